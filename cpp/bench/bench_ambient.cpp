@@ -0,0 +1,81 @@
+// cpp/bench/bench_ambient.cpp
+// Per-frame cost of AmbientProcessor::processFrame per reduce mode and
+// input resolution. Usage: bench_ambient [leds] [frames] [threads]
+#include "ambient_processor.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+struct Resolution
+{
+    const char* name;
+    int width;
+    int height;
+};
+
+static const Resolution RESOLUTIONS[] = {
+    { "720p", 1280, 720 },
+    { "1080p", 1920, 1080 },
+    { "4K", 3840, 2160 },
+};
+
+// gradients plus a checker pattern and noise, so no mode gets a flat frame
+static std::vector<uint8_t> makeFrame(int width, int height) {
+    std::vector<uint8_t> frame(static_cast<size_t>(width) * height * 3);
+    uint32_t seed = 12345;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            uint8_t* p = &frame[(static_cast<size_t>(y) * width + x) * 3];
+            p[0] = static_cast<uint8_t>(x * 255 / width);
+            p[1] = static_cast<uint8_t>(y * 255 / height);
+            p[2] = static_cast<uint8_t>(((x / 40 + y / 40) % 2) * 128 + (seed >> 26));
+        }
+    }
+    return frame;
+}
+
+struct Mode
+{
+    const char* name;
+    AmbientProcessor::ReduceMode mode;
+    int downscale;
+};
+
+static const Mode MODES[] = {
+    { "mean", AmbientProcessor::ReduceMode::Mean, 1 },
+    { "mean+downscale", AmbientProcessor::ReduceMode::Mean, 0 },
+    { "sample 4x4", AmbientProcessor::ReduceMode::Sample, 1 },
+    { "dominant", AmbientProcessor::ReduceMode::Dominant, 0 },
+};
+
+int main(int argc, char** argv) {
+    const int leds = argc > 1 ? std::atoi(argv[1]) : 300;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 200;
+    const int threads = argc > 3 ? std::atoi(argv[3]) : 1;
+
+    std::printf("%-16s %-6s %12s %12s  %s\n", "mode", "input", "us/frame", "ns/LED",
+                threads > 1 ? "busy us/frame per worker" : "");
+    for (const Resolution& res : RESOLUTIONS) {
+        const std::vector<uint8_t> frame = makeFrame(res.width, res.height);
+        for (const Mode& m : MODES) {
+            AmbientProcessor ap(leds);
+            ap.setReduceMode(m.mode);
+            ap.setDownscale(m.downscale);
+            ap.setThreads(threads);
+            ap.processFrame(frame.data(), res.width, res.height);   // warm-up, builds maps
+
+            const auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; ++i) ap.processFrame(frame.data(), res.width, res.height);
+            const double us = std::chrono::duration<double, std::micro>(
+                                  std::chrono::steady_clock::now() - t0).count() / frames;
+
+            std::printf("%-16s %-6s %12.1f %12.1f ", m.name, res.name, us, us * 1000.0 / leds);
+            for (uint64_t ns : ap.stats().workerNs) std::printf(" %7.1f", ns / 1000.0 / (frames + 1));
+            std::printf("\n");
+        }
+    }
+    return 0;
+}
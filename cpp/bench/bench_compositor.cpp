@@ -0,0 +1,62 @@
+// cpp/bench/bench_compositor.cpp
+// Per-frame cost of Compositor::compose: a base layer plus three overlays
+// of one blend mode at partial opacity, and a mixed stack.
+// Usage: bench_compositor [leds] [frames]
+#include "compositor.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static std::vector<RGB> makeLayer(int leds, uint32_t seed) {
+    std::vector<RGB> colors(leds);
+    for (RGB& c : colors) {
+        seed = seed * 1664525u + 1013904223u;
+        c = { static_cast<uint8_t>(seed >> 24), static_cast<uint8_t>(seed >> 16), static_cast<uint8_t>(seed >> 8) };
+    }
+    return colors;
+}
+
+struct Stack
+{
+    const char* name;
+    BlendMode overlays[3];
+};
+
+static const Stack STACKS[] = {
+    { "normal", { BlendMode::Normal, BlendMode::Normal, BlendMode::Normal } },
+    { "add", { BlendMode::Add, BlendMode::Add, BlendMode::Add } },
+    { "max", { BlendMode::Max, BlendMode::Max, BlendMode::Max } },
+    { "multiply", { BlendMode::Multiply, BlendMode::Multiply, BlendMode::Multiply } },
+    { "mixed", { BlendMode::Add, BlendMode::Multiply, BlendMode::Normal } },
+};
+
+int main(int argc, char** argv) {
+    const int leds = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 10000;
+
+    std::vector<std::vector<RGB>> sources;
+    for (uint32_t i = 0; i < 4; ++i) sources.push_back(makeLayer(leds, 12345 + i));
+
+    std::printf("%-10s %12s %12s\n", "4 layers", "us/frame", "ns/LED");
+    unsigned checksum = 0;
+    for (const Stack& s : STACKS) {
+        Compositor comp(leds);
+        Layer layers[4];
+        layers[0] = { sources[0].data(), BlendMode::Normal, OPAQUE };
+        for (int i = 0; i < 3; ++i) layers[i + 1] = { sources[i + 1].data(), s.overlays[i], 96u + 48u * i };
+        comp.compose(layers, 4);   // warm-up
+
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            layers[1].alpha = 1 + (i & 255);   // a running crossfade
+            checksum += comp.compose(layers, 4)[i % leds].r;
+        }
+        const double us = std::chrono::duration<double, std::micro>(
+                              std::chrono::steady_clock::now() - t0).count() / frames;
+        std::printf("%-10s %12.2f %12.2f\n", s.name, us, us * 1000.0 / leds);
+    }
+    std::printf("(checksum %u)\n", checksum);
+    return 0;
+}
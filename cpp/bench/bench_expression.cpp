@@ -0,0 +1,50 @@
+// cpp/bench/bench_expression.cpp
+// Per-frame cost of evaluating user expressions (expression.h) over the
+// strip. Usage: bench_expression [leds] [frames]
+#include "expression.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static const char* PROGRAMS[] = {
+    "r = 255",
+    "r = sin(t*2 + i*0.1)*127 + 128",
+    "r = sin(t*2 + i*0.1)*127 + 128; g = cos(t*3 - x*6.28)*127 + 128; b = 255*fract(x*4 + t)",
+    "h = fract(x + t*0.1)*6; r = clamp(abs(h - 3) - 1, 0, 1)*255; g = clamp(2 - abs(h - 2), 0, 1)*255;"
+    " b = clamp(2 - abs(h - 4), 0, 1)*255",
+    "d = abs(x - fract(t*0.5)); w = step(d, 0.05); s = max(0, 1 - d*8);"
+    " r = mix(s*s*40, 255, w); g = mix(s*80, 255, w); b = mix(20 + s*120, 255, w)",
+};
+
+int main(int argc, char** argv) {
+    const int leds = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 5000;
+
+    std::printf("%6s %5s %12s %10s  %s\n", "instr", "regs", "us/frame", "ns/LED", "program");
+    std::vector<RGB> frame(leds);
+    unsigned checksum = 0;
+    for (const char* source : PROGRAMS) {
+        std::string error;
+        const auto program = ExprProgram::compile(source, error);
+        if (!program) {
+            std::fprintf(stderr, "%s: %s\n", source, error.c_str());
+            return 1;
+        }
+        ExprVM vm;
+        vm.run(*program, 0.0f, frame);   // warm-up, loads constants
+
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; ++f) {
+            vm.run(*program, f / 200.0f, frame);
+            checksum += frame[f % leds].r;
+        }
+        const double us = std::chrono::duration<double, std::micro>(
+                              std::chrono::steady_clock::now() - t0).count() / frames;
+        std::printf("%6zu %5d %12.2f %10.2f  %.60s\n", program->instructions(), program->registers(), us,
+                    us * 1000.0 / leds, source);
+    }
+    std::printf("(checksum %u)\n", checksum);
+    return 0;
+}
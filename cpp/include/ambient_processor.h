@@ -3,28 +3,179 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <memory>
+#include <atomic>
+#include <mutex>
 
 #include "rgb.h"
+#include "smoothing.h"
+#include "border_detector.h"
+#include "worker_pool.h"
 
 // ----------------------------------------------------------
 // Ambient Processor – berechnet die Farben aus dem Bild
 // ----------------------------------------------------------
+// Frames are packed RGB24 (width * 3 bytes per row). LEDs run clockwise
+// around the screen starting top-left: top (left -> right), right
+// (top -> bottom), bottom (right -> left), left (bottom -> top).
 class AmbientProcessor
 {
 public:
+    // how a region is reduced to one color
+    enum class ReduceMode
+    {
+        Mean,                        // every pixel of the region (optionally downscaled)
+        Sample,                      // fixed grid of sample points, constant cost per LED
+        Dominant                     // most frequent color (4-4-4 bit histogram) instead of the mean
+    };
+
     AmbientProcessor(int ledCount);
 
-    std::vector<RGB> processFrame(const uint8_t* frameData, int width, int height);
+    // result stays valid until the next call; timestampNs (Frame::mediaNs:
+    // capture time, or media time on replays) paces the smoothing, 0 = now
+    const std::vector<RGB>& processFrame(const uint8_t* frameData, int width, int height,
+                                         uint64_t timestampNs = 0);
 
-    void setSmoothing(int frames);
+    // EMA time constant in ms, see smoothing.h
+    void setSmoothingTime(float tauMs);
     void setBrightness(float b);
+    // fast attack time constant and change thresholds, as LEDDriver
+    void setAdaptiveSmoothing(float fastTauMs, const AdaptiveSmoothing& params);
+    void setBorderDetection(bool enabled);
+    // border bands downscaled 2/4/8x before averaging; 0 = auto, 1 = off
+    void setDownscale(int factor);
+    void setReduceMode(ReduceMode mode);
+    // sample points per region in Sample mode (x * y)
+    void setSampleGrid(int samplesX, int samplesY);
+    // split the region work over n threads (persistent pool, caller included)
+    void setThreads(int n);
+
+    // The setters above belong to the thread calling processFrame. Settings
+    // from any other thread (config reload) go through queueSettings and are
+    // applied at the next frame boundary; unchanged values keep their state
+    // (smoothing history, crop, pool). The calling thread also builds the
+    // region map for the new mode and sample grid, for the last frame's size
+    // and crop, so the processing thread only swaps it in.
+    struct Settings
+    {
+        float smoothingMs = 16.7f;   // = the former 3 frame window at 60 Hz
+        float smoothingFastMs = 5.6f;   // fast attack, a third of the above
+        float brightness = 1.0f;
+        AdaptiveSmoothing adaptive;
+        bool borderDetection = true;
+        int downscale = 0;
+        ReduceMode mode = ReduceMode::Mean;
+        int samplesX = 4;
+        int samplesY = 4;
+        int threads = 1;
+    };
+    void queueSettings(const Settings& settings);
+
+    struct Stats
+    {
+        uint64_t frames = 0;
+        uint64_t fastFrames = 0;     // adaptive filter switched to fast attack
+        uint64_t cuts = 0;           // scene cuts (filter snapped)
+        uint64_t cropChanges = 0;    // region map moved to a new letterbox/pillarbox crop
+        Crop crop;                   // currently applied
+        int width = 0;               // size of the last frame
+        int height = 0;
+        uint64_t mapBuilds = 0;      // full-res region maps built by processFrame
+        uint64_t borderNs = 0;       // total time in the border detector
+        uint64_t processNs = 0;      // total processFrame time
+        int downscale = 1;           // factor used for the last frame
+        int downscaleError = 0;      // max channel error of the last full-res check
+        uint64_t downscaleChecks = 0;
+        std::vector<uint64_t> workerNs; // busy time per worker (threads > 1)
+    };
+    // any thread: a copy taken at the end of the last processFrame
+    Stats stats() const;
 
 private:
+    struct Region
+    {
+        int x0, y0, x1, y1;          // pixel rect, x1/y1 exclusive
+    };
+
+    // LED regions for one frame geometry (full resolution or downscaled)
+    struct RegionMap
+    {
+        int width = 0;
+        int height = 0;
+        Crop crop;
+        std::vector<Region> regions;
+        Region bands[4] = {};        // top, right, bottom, left band bounds
+
+        // Sample mode: byte offsets into the frame, samplesPerRegion per LED
+        std::vector<uint32_t> samples;
+        int samplesPerRegion = 0;
+    };
+
     int _ledCount;
-    int _smoothing = 3;
+    float _smoothingMs = 16.7f;
+    float _smoothingFastMs = 5.6f;
     float _brightness = 1.0f;
+    float _depth = 0.1f;             // border band depth, fraction of width/height
+    AdaptiveSmoothing _adaptive;
+
+    RegionMap _map;                  // full resolution
+    RegionMap _smallMap;             // in _small coordinates
+
+    ReduceMode _mode = ReduceMode::Mean;
+    int _samplesX = 4;
+    int _samplesY = 4;
+
+    int _downscale = 0;              // requested: 0 = auto, 1 = off, 2/4/8
+    int _downscaleCap = 8;           // lowered if the full-res check fails
+    int _maxDownscaleError = 6;      // allowed max channel difference vs. full res
+    std::vector<uint8_t> _small;     // downscaled frame, only the bands are written
+    std::vector<RGB> _check;         // full-res colors for the periodic check
+
+    // Dominant mode: 4096-bin histogram slice(s) + touched-bin lists; a
+    // region only clears the bins it used, so reset cost follows its size
+    static constexpr int HIST_BINS = 4096;
+    std::vector<uint16_t> _histArena;      // one slice per worker
+    std::vector<uint16_t> _touchedArena;
+
+    std::unique_ptr<WorkerPool> _pool;     // null = single-threaded
+    std::vector<int> _ranges;              // LED range boundaries per worker
+
+    bool _borderDetection = true;
+    BorderDetector _border;
+
+    std::vector<RGB> _raw;           // unsmoothed colors of the current frame
+    std::vector<RGB> _smoothed;      // filter output (before brightness), rounded _state
+    std::vector<RGB> _output;
+    std::vector<float> _state;       // EMA state, _ledCount * 3, 0..255
+    uint64_t _lastNs = 0;            // timestamp of the previous frame
+
+    Stats _stats;                    // processing thread
+    mutable std::mutex _statsMutex;  // guards _published
+    Stats _published;                // _stats as of the last frame boundary
 
-    std::vector<std::vector<RGB>> _history;
+    // queued settings plus the full-res map they need (width 0 = none)
+    struct PendingSettings
+    {
+        Settings settings;
+        RegionMap map;
+    };
+    std::shared_ptr<PendingSettings> _pending;  // atomic_store / atomic_exchange
+    std::atomic<bool> _hasPending{false};       // cheap per-frame check, no lock
 
-    RGB averageSegment(const std::vector<RGB>& seg);
-};
\ No newline at end of file
+    void buildRegions(int width, int height, const Crop& crop, RegionMap& map) const;
+    int chooseDownscale(int width, int height) const;
+    void downscaleBands(const uint8_t* frame, int width, int factor);
+    void downscaleRows(const uint8_t* frame, int width, int factor, int begin, int end);
+    void balanceRanges(const RegionMap& map, int workers);
+    void reduceRange(const uint8_t* frame, const RegionMap& map, std::vector<RGB>& out,
+                     int begin, int end, int worker);
+    void buildSampleOffsets(RegionMap& map, int samplesX, int samplesY) const;
+    void computeColors(const uint8_t* frame, const RegionMap& map, std::vector<RGB>& out);
+    void sampleColors(const uint8_t* frame, const RegionMap& map, std::vector<RGB>& out,
+                      int begin, int end) const;
+    RGB averageSegment(const uint8_t* frame, int width, const Region& reg) const;
+    RGB dominantSegment(const uint8_t* frame, int width, const Region& reg,
+                        uint16_t* hist, uint16_t* touched) const;
+    void smooth(uint64_t dtNs);
+    void applySettings(PendingSettings& pending);
+};
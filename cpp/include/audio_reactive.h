@@ -0,0 +1,139 @@
+// cpp/include/audio_reactive.h
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "rgb.h"
+#include "color_order.h"
+#include "frame_target.h"
+#include "audio_source.h"
+#include "fft.h"
+
+// ----------------------------------------------------------
+// AudioReactive – Spektrum + Beat auf die LEDs
+// ----------------------------------------------------------
+// Reads hop = fft/2 samples at a time from an AudioSource on its own thread
+// and runs a Hann windowed real FFT over the last fft samples. The spectrum
+// is binned into log spaced bands (40 Hz up to 16 kHz or Nyquist), turned
+// into dB and normalized by an automatic gain (peak tracker with a fixed
+// dynamic range), with fast attack / slow release per band.
+//
+// Beats: positive spectral flux (sum of per band dB rises) against the
+// mean + K * stddev of the last second, with a refractory time; a beat
+// flashes the strip.
+//
+// Each segment (or the whole strip) shows the full spectrum, bass to treble
+// from red over green to blue, brightness = band level. Band position and
+// base color per LED are precomputed; every buffer is allocated in the
+// constructor, so the thread loop does no allocation. After a few seconds
+// of silence the target is released.
+//
+// Latency: capture time of the newest sample (from the source) to the
+// submitted frame. The window adds fft/2 samples on top (the center of the
+// analyzed window lags the newest sample), reported as windowMs.
+class AudioReactive
+{
+public:
+    static constexpr int DEFAULT_FFT = 1024;
+    static constexpr int DEFAULT_BANDS = 16;
+
+    struct Settings
+    {
+        int fftSize = DEFAULT_FFT;
+        int bands = DEFAULT_BANDS;
+        std::vector<LedSegment> segments;      // empty = the whole strip
+    };
+
+    struct Stats
+    {
+        uint64_t blocks = 0;            // hops analyzed
+        uint64_t frames = 0;            // submitted (not silent)
+        uint64_t beats = 0;
+        uint64_t processNs = 0;         // sum, window + FFT + bands + render
+        uint64_t maxProcessNs = 0;
+        uint64_t latencyNs = 0;         // sum over frames, capture -> submit
+        uint64_t maxLatencyNs = 0;
+        double windowMs = 0.0;
+        float levelDb = -120.0f;        // last block RMS, dBFS
+        bool active = false;            // submitting (not silent)
+
+        double avgProcessUs() const { return blocks ? processNs / 1000.0 / blocks : 0.0; }
+        double avgLatencyMs() const { return frames ? latencyNs / 1e6 / frames : 0.0; }
+    };
+
+    AudioReactive(FrameTarget& target, std::unique_ptr<AudioSource> source, const Settings& settings);   // throws on a bad fft size
+    ~AudioReactive();
+
+    AudioReactive(const AudioReactive&) = delete;
+    AudioReactive& operator=(const AudioReactive&) = delete;
+
+    bool start();
+    void stop();
+
+    Stats stats() const;
+
+private:
+    static constexpr float MIN_HZ = 40.0f;
+    static constexpr float MAX_HZ = 16000.0f;
+    static constexpr float RANGE_DB = 40.0f;         // shown dynamic range below the peak
+    static constexpr float FLOOR_DB = -70.0f;        // AGC peak never drops below this
+    static constexpr float PEAK_DECAY_DB = 6.0f;     // per second
+    static constexpr float ATTACK_S = 0.01f;
+    static constexpr float RELEASE_S = 0.15f;
+    static constexpr float FLASH_S = 0.12f;
+    static constexpr float BEAT_K = 1.5f;            // stddevs above the mean flux
+    static constexpr float BEAT_MIN_FLUX = 6.0f;     // dB, summed over bands
+    static constexpr float BEAT_HOLD_S = 0.25f;
+    static constexpr float SILENCE_DB = -60.0f;
+    static constexpr uint64_t SILENCE_NS = 2000000000;
+
+    FrameTarget& _target;
+    std::unique_ptr<AudioSource> _source;
+    RealFft _fft;
+    const int _hop;
+    const int _bands;
+    const float _hopSeconds;
+    std::atomic<bool> _stopping{false};
+    std::thread _thread;
+
+    // analysis, thread only
+    std::vector<float> _samples;          // last fft samples, newest at the end
+    std::vector<float> _hann;
+    std::vector<float> _windowed;
+    std::vector<float> _power;            // fft bins
+    std::vector<int> _bandLo, _bandHi;    // bin range per band, [lo, hi)
+    std::vector<float> _bandDb, _prevDb;
+    std::vector<float> _level;            // 0..1, smoothed; one extra = last band (interpolation)
+    std::vector<float> _flux;             // ring, ~1 s
+    size_t _fluxPos = 0;
+    size_t _fluxCount = 0;
+    double _fluxSum = 0.0, _fluxSumSq = 0.0;
+    float _peakDb = FLOOR_DB;
+    float _attack, _release, _flashDecay, _peakDecay;
+    float _flash = 0.0f;
+    int _beatHold;                        // hops
+    int _sinceBeat = 0;                   // hops, counted in audio time (pipes arrive in bursts)
+    uint64_t _silentNs = 0;
+    bool _active = false;
+
+    // rendering, per LED
+    std::vector<uint16_t> _ledBand;
+    std::vector<float> _ledFrac;          // blend toward band + 1
+    std::vector<float> _ledColor;         // r g b 0..255 per LED
+    std::vector<RGB> _frame;
+
+    std::atomic<uint64_t> _blocks{0}, _frames{0}, _beats{0}, _processNs{0}, _maxProcessNs{0}, _latencyNs{0}, _maxLatencyNs{0};
+    std::atomic<float> _levelDb{-120.0f};
+    std::atomic<bool> _activeFlag{false};
+
+    void loop();
+    void analyze();
+    bool detectBeat(float flux);
+    void render();
+    void record(std::atomic<uint64_t>& sum, std::atomic<uint64_t>& max, uint64_t ns);
+    void mapSegment(int start, int count, bool reversed);
+};
@@ -0,0 +1,81 @@
+// cpp/include/audio_source.h
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------
+// Audio Source – liefert Samples für den Audio-Modus
+// ----------------------------------------------------------
+// Mono float samples (-1..1), multi-channel input is downmixed. read()
+// blocks until count samples are there and reports when the newest of them
+// was captured (steady clock), so the analyzer can measure audio-to-light
+// latency including the device buffer. Waits are sliced, so interrupt()
+// from another thread ends a blocked read() within WAIT_SLICE_MS.
+class AudioSource
+{
+public:
+    static constexpr int WAIT_SLICE_MS = 100;
+
+    virtual ~AudioSource() = default;
+
+    // false = end of stream, device error or interrupted
+    virtual bool read(float* samples, size_t count, uint64_t& captureNs) = 0;
+    virtual int sampleRate() const = 0;
+
+    void interrupt() { _interrupted.store(true, std::memory_order_relaxed); }
+    void resume() { _interrupted.store(false, std::memory_order_relaxed); }
+
+protected:
+    bool interrupted() const { return _interrupted.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> _interrupted{false};
+};
+
+// RIFF/WAVE file or pipe ("-" = stdin), 16 bit PCM or 32 bit float. Regular
+// files play in real time (optionally looped); pipes and FIFOs are read as
+// fast as the writer produces (e.g. arecord -t wav, ffmpeg -f wav -); a
+// FIFO blocks in the constructor until its writer opens it.
+class WavSource : public AudioSource
+{
+public:
+    WavSource(const std::string& path, bool loop);   // throws on bad files
+    ~WavSource() override;
+
+    WavSource(const WavSource&) = delete;
+    WavSource& operator=(const WavSource&) = delete;
+
+    bool read(float* samples, size_t count, uint64_t& captureNs) override;
+    int sampleRate() const override { return _rate; }
+
+private:
+    int _fd = -1;
+    bool _ownsFd = false;
+    bool _regular = false;           // seekable file: paced + loopable
+    bool _loop;
+    bool _float = false;             // else 16 bit PCM
+    int _channels = 0;
+    int _rate = 0;
+    off_t _dataStart = 0;
+    uint64_t _dataBytes = 0;         // 0 = until EOF (streamed header)
+    uint64_t _dataPos = 0;
+    std::vector<uint8_t> _raw;       // one read worth of interleaved input
+    uint64_t _startNs = 0;           // pacing: clock time of sample 0
+    uint64_t _played = 0;            // frames since _startNs
+
+    bool readFully(void* buf, size_t n);      // false on EOF/error/interrupt
+    bool skip(uint64_t n);
+    bool readHeader(std::string& error);
+};
+
+// "-", a path ending in .wav or an existing file/FIFO: WavSource (looped);
+// throws for anything else. Sound cards are read through a pipe, e.g.
+// arecord -t wav | led_daemon.
+std::unique_ptr<AudioSource> openAudioSource(const std::string& device);
@@ -0,0 +1,60 @@
+// cpp/include/border_detector.h
+#pragma once
+
+#include <cstdint>
+
+// ----------------------------------------------------------
+// Border Detector – Letterbox / Pillarbox Erkennung
+// ----------------------------------------------------------
+// Scans only a few rows per frame: from the top/bottom edge inward until a
+// row with content shows up (letterbox), and a handful of rows from the
+// left/right edge inward (pillarbox). Every test is a threshold compare over
+// a contiguous run of bytes. A new crop is only reported once it has been
+// seen for stableFrames consecutive frames.
+struct Crop
+{
+    int top = 0;
+    int bottom = 0;
+    int left = 0;
+    int right = 0;
+
+    bool operator==(const Crop& o) const {
+        return top == o.top && bottom == o.bottom && left == o.left && right == o.right;
+    }
+    bool operator!=(const Crop& o) const { return !(*this == o); }
+};
+
+class BorderDetector
+{
+public:
+    struct Params
+    {
+        uint8_t threshold = 24;      // max channel value still counted as black
+        int stableFrames = 30;       // frames a new crop must persist before it is applied
+        int tolerance = 2;           // px jitter treated as "same crop"
+        float maxFraction = 0.34f;   // never crop more than this per axis and side
+    };
+
+    BorderDetector() = default;
+    explicit BorderDetector(const Params& params) : _params(params) {}
+
+    // returns true if the applied crop changed
+    bool update(const uint8_t* frame, int width, int height);
+
+    const Crop& crop() const { return _applied; }
+    void reset();
+
+private:
+    Params _params;
+    int _width = 0;
+    int _height = 0;
+    Crop _applied;
+    Crop _candidate;
+    int _candidateFrames = 0;
+
+    bool detect(const uint8_t* frame, int width, int height, Crop& out) const;
+    bool rowIsBlack(const uint8_t* row, int width) const;
+    int leadingBlack(const uint8_t* row, int width, int limit) const;
+    int trailingBlack(const uint8_t* row, int width, int limit) const;
+    bool near(const Crop& a, const Crop& b) const;
+};
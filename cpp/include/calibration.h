@@ -0,0 +1,47 @@
+// cpp/include/calibration.h
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <string>
+
+// ----------------------------------------------------------
+// Color calibration – 3x3 matrix + per-channel gamma per strip batch
+// ----------------------------------------------------------
+struct Calibration
+{
+    // row-major, out = M * in (applied to 0..255 values before gamma)
+    float matrix[9] = { 1.0f, 0.0f, 0.0f,
+                        0.0f, 1.0f, 0.0f,
+                        0.0f, 0.0f, 1.0f };
+    float gamma[3] = { 0.0f, 0.0f, 0.0f };   // 0 = driver gamma
+};
+
+// lanes of the matrix pass, a multiple of 3 so lane t is always channel t % 3
+static constexpr int CALIB_LANES = 48;
+
+// Tables for one segment, built off the output thread.
+// A diagonal matrix (white balance only) is folded into the LUTs and costs
+// nothing at render time; off-diagonal terms run as a Q12 multiply-add on
+// the interleaved bytes: output byte t is the sum over d = 0..4 of
+// weight[d][t] * input byte t + d - 2, so every lane does the same work and
+// no de-interleave shuffle is needed.
+struct CompiledCalibration
+{
+    bool mix = false;
+    int32_t weight[5][CALIB_LANES] = {};    // Q12 (4096 = 1.0), only if mix
+    uint16_t lut[3][256] = {};              // gain/gamma/brightness, 8.8 fixed point
+};
+
+static constexpr float CALIB_MAX_COEFF = 4.0f;
+
+void compileCalibration(const Calibration& calib, float gamma, float brightness,
+                        CompiledCalibration& out);
+
+// in place on logical RGB triplets
+void applyColorMatrix(const CompiledCalibration& calib, uint8_t* rgb, int count);
+
+// CALIB argument parsing: "WB r g b" | "MATRIX m00 .. m22" | "GAMMA r g b" | "RESET"
+bool parseCalibration(std::istream& in, Calibration& calib, std::string& error);
+
+bool sameCalibration(const Calibration& a, const Calibration& b);
@@ -0,0 +1,95 @@
+// cpp/include/color_order.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------
+// Color order / segment layout – wire encoding of the strip
+// ----------------------------------------------------------
+enum class ColorOrder : uint8_t
+{
+    RGB,
+    RBG,
+    GRB,
+    GBR,
+    BRG,
+    BGR
+};
+
+// One physical strip section. LEDs are addressed logically 0..n-1;
+// a reversed segment is wired "backwards" (last logical LED first).
+struct LedSegment
+{
+    int start = 0;
+    int count = 0;
+    ColorOrder order = ColorOrder::RGB;
+    bool reversed = false;
+};
+
+bool parseColorOrder(const std::string& name, ColorOrder& out);
+const char* colorOrderName(ColorOrder order);
+
+// parses "start:count[:ORDER][:R]"
+bool parseSegment(const std::string& spec, ColorOrder defaultOrder, LedSegment& out);
+
+// segments must tile 0..numLeds-1 without gaps or overlap (sorted in place)
+bool validateSegments(std::vector<LedSegment>& segments, int numLeds);
+
+// ----------------------------------------------------------
+// Template-specialized writers
+// ----------------------------------------------------------
+template <ColorOrder O> struct OrderTraits;
+template <> struct OrderTraits<ColorOrder::RGB> { static constexpr int c0 = 0, c1 = 1, c2 = 2; };
+template <> struct OrderTraits<ColorOrder::RBG> { static constexpr int c0 = 0, c1 = 2, c2 = 1; };
+template <> struct OrderTraits<ColorOrder::GRB> { static constexpr int c0 = 1, c1 = 0, c2 = 2; };
+template <> struct OrderTraits<ColorOrder::GBR> { static constexpr int c0 = 1, c1 = 2, c2 = 0; };
+template <> struct OrderTraits<ColorOrder::BRG> { static constexpr int c0 = 2, c1 = 0, c2 = 1; };
+template <> struct OrderTraits<ColorOrder::BGR> { static constexpr int c0 = 2, c1 = 1, c2 = 0; };
+
+// src: logical RGB triplets, dst: wire values (8.8 fixed point) of the segment,
+// lut: one table per logical channel (R, G, B).
+// Channel permutation and direction are compile-time constants, so the
+// loop is the same straight copy through the LUT as the plain RGB case.
+template <ColorOrder O, bool Reverse>
+inline void encodeSegment(const uint8_t* src, uint16_t* dst, int count, const uint16_t (*lut)[256])
+{
+    using T = OrderTraits<O>;
+    for (int i = 0; i < count; ++i) {
+        const uint8_t* s = src + static_cast<size_t>(Reverse ? count - 1 - i : i) * 3;
+        uint16_t* d = dst + static_cast<size_t>(i) * 3;
+        d[0] = lut[T::c0][s[T::c0]];
+        d[1] = lut[T::c1][s[T::c1]];
+        d[2] = lut[T::c2][s[T::c2]];
+    }
+}
+
+template <bool Reverse>
+inline void encodeSegmentDispatch(ColorOrder order, const uint8_t* src, uint16_t* dst, int count, const uint16_t (*lut)[256])
+{
+    switch (order) {
+        case ColorOrder::RGB: encodeSegment<ColorOrder::RGB, Reverse>(src, dst, count, lut); break;
+        case ColorOrder::RBG: encodeSegment<ColorOrder::RBG, Reverse>(src, dst, count, lut); break;
+        case ColorOrder::GRB: encodeSegment<ColorOrder::GRB, Reverse>(src, dst, count, lut); break;
+        case ColorOrder::GBR: encodeSegment<ColorOrder::GBR, Reverse>(src, dst, count, lut); break;
+        case ColorOrder::BRG: encodeSegment<ColorOrder::BRG, Reverse>(src, dst, count, lut); break;
+        case ColorOrder::BGR: encodeSegment<ColorOrder::BGR, Reverse>(src, dst, count, lut); break;
+    }
+}
+
+// logical channel (0 = R, 1 = G, 2 = B) sent at wire position pos (0..2)
+inline int wireChannel(ColorOrder order, int pos)
+{
+    static constexpr int MAP[6][3] = {
+        { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 }
+    };
+    return MAP[static_cast<int>(order)][pos];
+}
+
+inline void encodeSegment(const LedSegment& seg, const uint8_t* logical, uint16_t* wire, const uint16_t (*lut)[256])
+{
+    const size_t off = static_cast<size_t>(seg.start) * 3;
+    if (seg.reversed) encodeSegmentDispatch<true>(seg.order, logical + off, wire + off, seg.count, lut);
+    else              encodeSegmentDispatch<false>(seg.order, logical + off, wire + off, seg.count, lut);
+}
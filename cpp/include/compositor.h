@@ -0,0 +1,82 @@
+// cpp/include/compositor.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rgb.h"
+
+// ----------------------------------------------------------
+// Compositor – Ebenen mischen + Überblendungen
+// ----------------------------------------------------------
+// Layers are composited bottom to top into one RGB buffer. Opacity is Q8
+// (0..256, 256 = opaque) so every blend is an 8x8 -> 16 bit multiply and a
+// shift: plain byte loops over the whole buffer that -O3 vectorizes (16
+// channels per SSE/NEON op), about 1-2 us per layer for 2000 LEDs.
+//
+//   Normal     dst + (src - dst) * a          (a = 256: replace)
+//   Add        min(255, dst + src * a)
+//   Max        max(dst, src * a)
+//   Multiply   dst * (1 - a + src * a)        (a = 0: unchanged)
+enum class BlendMode : uint8_t
+{
+    Normal,
+    Add,
+    Max,
+    Multiply
+};
+
+static constexpr uint32_t OPAQUE = 256;
+
+bool parseBlendMode(const std::string& name, BlendMode& out);
+const char* blendModeName(BlendMode mode);
+
+// dst = dst (blend) src over n bytes, alpha 0..256
+void blendLayer(uint8_t* dst, const uint8_t* src, size_t n, BlendMode mode, uint32_t alpha);
+
+struct Layer
+{
+    const RGB* colors = nullptr;
+    BlendMode mode = BlendMode::Normal;
+    uint32_t alpha = OPAQUE;
+};
+
+class Compositor
+{
+public:
+    explicit Compositor(int numLeds);
+
+    // bottom to top; the first layer is copied (black below it when its
+    // alpha is < OPAQUE)
+    const std::vector<RGB>& compose(const Layer* layers, size_t count);
+    const std::vector<RGB>& result() const { return _out; }
+
+private:
+    std::vector<RGB> _out;
+};
+
+// Timed crossfade level, Q16 (0..65536). Advanced by elapsed time rather
+// than per frame, so fades last fadeMs whatever the frame rate. The part of
+// a step below one Q16 unit is carried over, so many short steps add up to
+// the same level as one long one.
+class FadeLevel
+{
+public:
+    static constexpr uint32_t FULL = 65536;
+
+    // returns true while still moving
+    bool step(bool visible, uint64_t elapsedNs, uint64_t fadeNs);
+    void snap(bool visible) {
+        _level = visible ? FULL : 0;
+        _carry = 0;
+    }
+    uint32_t alpha() const { return (_level + 128) >> 8; }   // Q8 for blendLayer
+    bool visible() const { return _level > 0; }
+    bool full() const { return _level == FULL; }
+
+private:
+    uint32_t _level = 0;
+    uint64_t _carry = 0;             // elapsedNs * FULL remainder, < fadeNs
+};
@@ -0,0 +1,158 @@
+// cpp/include/config.h
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "led_driver.h"
+#include "ambient_processor.h"
+#include "ipc_server.h"
+#include "output_sink.h"
+#include "dmx_protocol.h"
+#include "ddp_receiver.h"
+#include "opc_server.h"
+#include "source_manager.h"
+#include "effect_engine.h"
+#include "audio_reactive.h"
+#include "delay_line.h"
+
+// ----------------------------------------------------------
+// Config – Datei laden + Hot Reload
+// ----------------------------------------------------------
+// INI style, "key = value", sections [led] [output] [ambient] [capture] [ipc]
+// [dmx] [ddp] [opc] [effects] [audio] [sources] [trace], '#' starts a
+// comment. Unknown keys are reported and ignored. Defaults are the values
+// main.cpp used to hard-code, so an empty file changes nothing.
+//
+//   [led]      count, device, chip (ws2801), spi_speed
+//   [output]   gamma, brightness, order, segments
+//              (start:count[:ORDER][:R] ...), calibration (as CALIB:
+//              WB r g b | MATRIX ... | GAMMA r g b), power_budget (mA),
+//              power_model (mA_r mA_g mA_b idle_mA volts), smoothing_ms,
+//              smoothing_fast_ms (time constants), smoothing,
+//              smoothing_fast (alpha per frame at 60 Hz, converted), attack,
+//              cut, dither, refresh (Hz)
+//   [ambient]  smoothing_ms, smoothing_fast_ms (time constants), smoothing,
+//              smoothing_fast (frames at 60 Hz, converted), brightness,
+//              attack, cut, border, downscale, mode (mean | sample |
+//              dominant), samples (XxY), threads
+//   [capture]  width, height, fps, delay (ms, holds the LEDs back to match
+//              the TV)
+//   [ipc]      port
+//   [dmx]      e131, artnet (on/off), e131_universe, artnet_universe (first
+//              universe), leds_per_universe
+//   [ddp]      enable (on/off), port
+//   [opc]      enable (on/off), port, channels (channel:start:count ...)
+//   [effects]  rate (Hz), effect (as the EFFECT command, e.g.
+//              "rainbow speed=0.2")
+//   [audio]    enable (on/off), device (WAV file, FIFO or "-" for a WAV
+//              stream on stdin), fft (samples), bands
+//   [sources]  capture, network, ipc, effect, audio:
+//              "priority timeout_ms [blend [opacity]]" (higher priority
+//              wins, timeout 0 = never expires, blend normal | add | max |
+//              multiply, opacity 0..1), fade (ms)
+//   [trace]    dir (where TRACE ON over IPC writes; empty = off, --trace
+//              on the command line takes any path)
+//
+// Hot reload: [output], [ambient], capture.delay, effects.effect and
+// trace.dir apply while running; [led], the rest of [capture], [ipc],
+// [dmx], [ddp], [opc], effects.rate, [audio] and [sources] need a restart.
+// A reload keeps runtime CALIB SEG n settings as long as the segment
+// boundaries stay the same. [ambient] changes are queued to the processor,
+// which gets the region map for a new mode or sample grid prebuilt by the
+// reloading thread.
+struct Config
+{
+    int ledCount = 60;
+    std::string device = "/dev/spidev0.0";
+    std::string chip = "ws2801";
+    uint32_t spiSpeedHz = SpiSink::DEFAULT_SPEED_HZ;
+
+    LEDDriver::OutputConfig output;
+    ColorOrder order = ColorOrder::RGB;
+    float smoothingMs = 57.9f;                       // alpha 0.25 per frame at 60 Hz
+    float smoothingFastMs = 18.2f;                   // alpha 0.6
+    AdaptiveSmoothing adaptive;
+    bool dithering = false;
+    int refreshHz = 0;
+
+    AmbientProcessor::Settings ambient;
+
+    int captureWidth = 32;
+    int captureHeight = 18;
+    int captureFps = 60;
+    int captureDelayMs = 0;                          // A/V sync, see DelayLine
+
+    int port = DEFAULT_IPC_PORT;
+
+    bool e131 = false;
+    bool artnet = false;
+    int e131Universe = 1;
+    int artnetUniverse = 0;
+    int ledsPerUniverse = LEDS_PER_UNIVERSE;
+
+    bool ddp = false;
+    int ddpPort = DDP_PORT;
+
+    bool opc = false;
+    int opcPort = OPC_PORT;
+    std::vector<OpcServer::Mapping> opcChannels;   // empty = channel 1, whole strip
+
+    int effectRate = EffectEngine::DEFAULT_RATE_HZ;
+    std::string effect = "off";                      // validated by parseEffect
+
+    bool audio = false;
+    std::string audioDevice = "-";
+    int audioFft = AudioReactive::DEFAULT_FFT;
+    int audioBands = AudioReactive::DEFAULT_BANDS;
+
+    SourcePolicy captureSource{100, 500};
+    SourcePolicy networkSource{200, 2000};           // E1.31, Art-Net, DDP, OPC
+    SourcePolicy ipcSource{250, 5000};               // COLOR / PIX on the IPC port
+    SourcePolicy effectSource{150, 0};               // until EFFECT off
+    SourcePolicy audioSource{175, 500};              // released after silence
+    int fadeMs = 250;                                // crossfade between sources
+
+    std::string traceDir;                            // TRACE ON target, empty = refused
+};
+
+// false + error ("file:line: message") if the file can't be read or a
+// value is invalid; out is only written on success
+bool loadConfig(const std::string& path, Config& out, std::string& error);
+
+// Applies the runtime part of cfg. With previous, only groups that changed
+// are touched (no smoothing/dither reset on an unrelated edit) and changed
+// restart-only keys are reported. Table rebuilds run on the calling thread.
+void applyConfig(const Config& cfg, const Config* previous, LEDDriver& driver, AmbientProcessor& ambient);
+
+// Watches the file's directory with inotify (editors replace files via
+// rename) and calls onReload with every successfully parsed new version,
+// on the watcher thread. Parse errors keep the old config.
+class ConfigWatcher
+{
+public:
+    using Callback = std::function<void(const Config&)>;
+
+    ConfigWatcher(const std::string& path, Callback onReload);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    bool start();
+    void stop();
+
+private:
+    std::string _path;
+    std::string _dir;
+    std::string _name;
+    Callback _onReload;
+    int _inotifyFd = -1;
+    int _wakeFd = -1;                // eventfd, wakes the thread for stop()
+    std::thread _thread;
+
+    void loop();
+};
@@ -0,0 +1,83 @@
+// cpp/include/ddp_receiver.h
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "rgb.h"
+#include "frame_target.h"
+
+static constexpr int DDP_PORT = 4048;
+
+// ----------------------------------------------------------
+// DdpReceiver – Distributed Display Protocol Empfänger
+// ----------------------------------------------------------
+// DDP carries a byte offset + length into one flat RGB buffer, so a single
+// socket covers any LED count (about 480 LEDs per 1440 byte packet). Each
+// datagram is read twice: a MSG_PEEK of the header, then a scatter recvmsg
+// whose second iovec points at frame + offset - the payload lands in the
+// render buffer without an intermediate copy. A packet with the PUSH flag
+// submits the frame (one show per push).
+//
+// Sequence numbers (1..15, 0 = unused) are tracked per sender address;
+// gaps count as lost packets.
+class DdpReceiver
+{
+public:
+    struct Stats
+    {
+        uint64_t packets = 0;
+        uint64_t bytes = 0;         // payload bytes written into the frame
+        uint64_t frames = 0;        // PUSH packets = frames shown
+        uint64_t lost = 0;          // sequence gaps, all senders
+        uint64_t reordered = 0;     // sequence went backwards
+        uint64_t ignored = 0;       // malformed, query/reply, other destination
+        uint64_t clipped = 0;       // payload beyond the last LED, cut off
+        int sources = 0;
+    };
+
+    DdpReceiver(FrameTarget& target, int port = DDP_PORT);
+    ~DdpReceiver();
+
+    DdpReceiver(const DdpReceiver&) = delete;
+    DdpReceiver& operator=(const DdpReceiver&) = delete;
+
+    bool start();
+    void stop();
+
+    Stats stats() const;
+
+private:
+    static constexpr size_t HEADER = 10;
+    static constexpr size_t HEADER_TIMECODE = 14;
+    static constexpr int MAX_SOURCES = 8;
+    static constexpr int RCVBUF_BYTES = 1 << 20;
+
+    struct Source
+    {
+        uint32_t addr = 0;          // network order, with the port as identity
+        uint16_t port = 0;
+        uint8_t lastSeq = 0;
+        uint64_t lastSeenNs = 0;
+    };
+
+    FrameTarget& _target;
+    int _port;
+    int _fd = -1;
+    int _wakeFd = -1;
+    std::thread _thread;
+
+    // receiver thread only
+    std::vector<RGB> _frame;           // render buffer, DDP offset 0 = LED 0 red
+    std::vector<Source> _sources;
+
+    std::atomic<uint64_t> _packets{0}, _bytes{0}, _frames{0}, _lost{0}, _reordered{0}, _ignored{0}, _clipped{0};
+    std::atomic<int> _sourceCount{0};
+
+    void loop();
+    bool receiveOne();                 // false when the socket is drained
+    void discard();
+    void trackSequence(uint32_t addr, uint16_t port, uint8_t seq);
+};
@@ -0,0 +1,58 @@
+// cpp/include/delay_line.h
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rgb.h"
+
+// ----------------------------------------------------------
+// DelayLine – verzögert Frames für A/V-Sync
+// ----------------------------------------------------------
+// TVs show the picture 50-150 ms after the grabber sees it, so the LEDs
+// would run ahead. The pipeline's output stage pushes every processed frame
+// with its capture timestamp and emits the newest frame whose timestamp +
+// delay has passed.
+//
+// A ring of CAPACITY frames, all buffers allocated in the constructor.
+// Frames arrive in timestamp order, so due() only ever moves a cursor
+// forward over entries that became due: every frame is looked at once,
+// constant time per frame. A longer delay holds the current frame until
+// the older ones catch up; a shorter one skips the frames that are overdue.
+// The ring covers MAX_DELAY_MS up to CAPACITY * 1000 / MAX_DELAY_MS fps;
+// beyond that the oldest frames are overwritten (counted as dropped).
+class DelayLine
+{
+public:
+    static constexpr int MAX_DELAY_MS = 1000;
+    static constexpr size_t CAPACITY = 256;          // power of two
+
+    explicit DelayLine(int numLeds);
+
+    // any thread; clamped to 0..MAX_DELAY_MS
+    void setDelayMs(int ms);
+    int delayMs() const { return _delayMs.load(std::memory_order_relaxed); }
+
+    // owner thread only
+    // (mediaNs is carried along for the target, see Frame::mediaNs)
+    void push(const std::vector<RGB>& colors, uint64_t timestampNs, uint64_t mediaNs = 0);
+    // newest frame that is due at nowNs and not emitted yet, nullptr if none;
+    // valid until the next push()
+    const std::vector<RGB>* due(uint64_t nowNs, uint64_t& timestampNs, uint64_t& mediaNs);
+    bool empty() const { return _head == _tail; }
+    // when the oldest frame not emitted yet becomes due; false if empty
+    bool nextDue(uint64_t& dueNs) const;
+
+    uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<std::vector<RGB>> _frames;
+    std::vector<uint64_t> _timestamps;
+    std::vector<uint64_t> _media;
+    uint64_t _head = 0;                  // next write, free running
+    uint64_t _tail = 0;                  // oldest not emitted
+    std::atomic<int> _delayMs{0};
+    std::atomic<uint64_t> _dropped{0};   // skipped (overdue) + overwritten
+};
@@ -0,0 +1,53 @@
+// cpp/include/dmx_protocol.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// ----------------------------------------------------------
+// DMX over UDP – E1.31 (sACN) und Art-Net Pakete
+// ----------------------------------------------------------
+// Only what a pixel receiver needs: DMX data (start code 0) and the sync
+// packets of both protocols. Parsers work in place on the receive buffer;
+// the builders are used by the packet generator (tools/dmx_send).
+static constexpr int E131_PORT = 5568;
+static constexpr int ARTNET_PORT = 6454;
+static constexpr int DMX_CHANNELS = 512;
+static constexpr int LEDS_PER_UNIVERSE = 170;    // 510 of 512 channels as RGB
+static constexpr size_t DMX_PACKET_MAX = 638;   // largest E1.31 data packet
+
+struct DmxPacket
+{
+    enum class Type : uint8_t
+    {
+        Data,
+        Sync
+    };
+
+    Type type = Type::Data;
+    uint16_t universe = 0;           // data: universe, sync: sync address (E1.31)
+    uint16_t syncAddress = 0;        // E1.31 data: sync universe, 0 = unsynchronized
+    uint8_t sequence = 0;            // 0 in Art-Net = sequencing disabled
+    uint8_t priority = 100;          // E1.31 only
+    const uint8_t* data = nullptr;   // DMX slots 1..n (start code stripped)
+    uint16_t length = 0;
+};
+
+// false for anything that is not an E1.31 data/sync packet we can use
+// (other start codes, preview data, stream-terminated, malformed)
+bool parseE131(const uint8_t* buf, size_t len, DmxPacket& out);
+// false for anything but ArtDmx / ArtSync
+bool parseArtNet(const uint8_t* buf, size_t len, DmxPacket& out);
+
+// E1.31 sequence rule: a packet at most 20 behind the last one is stale
+inline bool sequenceStale(uint8_t last, uint8_t seq) {
+    const int8_t diff = static_cast<int8_t>(seq - last);
+    return diff <= 0 && diff > -20;
+}
+
+// builders return the packet size; out must hold DMX_PACKET_MAX bytes
+size_t buildE131Data(uint8_t* out, const uint8_t cid[16], uint16_t universe, uint8_t sequence,
+                     uint16_t syncAddress, const uint8_t* data, uint16_t length);
+size_t buildE131Sync(uint8_t* out, const uint8_t cid[16], uint16_t syncAddress, uint8_t sequence);
+size_t buildArtDmx(uint8_t* out, uint16_t universe, uint8_t sequence, const uint8_t* data, uint16_t length);
+size_t buildArtSync(uint8_t* out);
@@ -0,0 +1,104 @@
+// cpp/include/dmx_receiver.h
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "dmx_protocol.h"
+#include "rgb.h"
+#include "frame_target.h"
+
+// ----------------------------------------------------------
+// DmxReceiver – E1.31 / Art-Net Empfänger
+// ----------------------------------------------------------
+// One UDP socket and one thread per protocol. Universe startUniverse + k
+// carries LEDs [k * ledsPerUniverse, (k+1) * ledsPerUniverse) as RGB
+// triplets from channel 1. Packets are drained with recvmmsg, BATCH per
+// syscall, straight into preallocated buffers.
+//
+// A frame is rendered (one submitFrame) when every mapped universe has
+// arrived, or - while the sender uses sync packets - when the sync packet
+// arrives. A universe repeating before the frame is complete (lost packet,
+// sender with fewer universes) renders what is there and starts the next
+// frame; a frame left incomplete for FRAME_TIMEOUT_MS is flushed as well.
+class DmxReceiver
+{
+public:
+    enum class Protocol
+    {
+        E131,
+        ArtNet
+    };
+
+    struct Params
+    {
+        Protocol protocol = Protocol::E131;
+        int port = 0;                          // 0 = protocol default
+        int startUniverse = -1;                // -1 = 1 for E1.31, 0 for Art-Net
+        int ledsPerUniverse = LEDS_PER_UNIVERSE;
+    };
+
+    struct Stats
+    {
+        uint64_t packets = 0;
+        uint64_t batches = 0;       // recvmmsg calls that returned data
+        uint64_t frames = 0;        // complete or synced frames rendered
+        uint64_t partial = 0;       // frames rendered with universes missing
+        uint64_t stale = 0;         // out of sequence, dropped
+        uint64_t ignored = 0;       // malformed, other protocol, unmapped universe
+    };
+
+    DmxReceiver(FrameTarget& target, const Params& params);
+    ~DmxReceiver();
+
+    DmxReceiver(const DmxReceiver&) = delete;
+    DmxReceiver& operator=(const DmxReceiver&) = delete;
+
+    bool start();
+    void stop();
+
+    Stats stats() const;
+    int universes() const { return _universes; }
+    const char* name() const { return _params.protocol == Protocol::E131 ? "E1.31" : "Art-Net"; }
+
+private:
+    static constexpr int BATCH = 32;
+    static constexpr int FRAME_TIMEOUT_MS = 100;
+    static constexpr uint64_t SYNC_TIMEOUT_NS = 4000000000ull;   // Art-Net: 4 s without ArtSync
+    static constexpr int RCVBUF_BYTES = 1 << 20;
+
+    FrameTarget& _target;
+    Params _params;
+    int _numLeds;
+    int _universes;
+    int _fd = -1;
+    int _wakeFd = -1;
+    std::thread _thread;
+
+    // receiver thread only
+    std::vector<RGB> _frame;
+    std::vector<uint64_t> _received;   // bit per universe of the current frame
+    int _receivedCount = 0;
+    uint64_t _frameStartNs = 0;
+    std::vector<uint8_t> _lastSeq;
+    std::vector<uint8_t> _seqValid;
+    uint64_t _lastSyncNs = 0;
+    uint16_t _syncAddress = 0;         // E1.31 sync universe announced by the data packets
+
+    std::vector<uint8_t> _buffers;     // BATCH * DMX_PACKET_MAX
+    iovec _iov[BATCH];
+    mmsghdr _msgs[BATCH];
+
+    std::atomic<uint64_t> _packets{0}, _batches{0}, _frames{0}, _partial{0}, _stale{0}, _ignored{0};
+
+    void loop();
+    void handlePacket(const uint8_t* buf, size_t len, uint64_t now);
+    void handleData(const DmxPacket& pkt, uint64_t now);
+    void render(bool complete);
+    void joinMulticast();
+};
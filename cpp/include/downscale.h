@@ -0,0 +1,21 @@
+// cpp/include/downscale.h
+#pragma once
+
+#include <cstdint>
+
+// ----------------------------------------------------------
+// Downscale – box filter for the border bands
+// ----------------------------------------------------------
+// One output row of an f:1 reduction (f = 2, 4 or 8): each output pixel is
+// the mean of f adjacent source pixels of one source row. This is a
+// horizontal box only: callers pick one source row per block of f rows, so
+// the other f-1 rows are never read and memory traffic drops by f;
+// averaging along the row is free since those bytes share cache lines
+// anyway. Vertical detail finer than f rows can alias, which the
+// processor's periodic full-resolution check catches.
+void boxFilterRow(const uint8_t* src, uint8_t* dst, int outPixels, int factor);
+
+// Same geometry without averaging (middle pixel of each block). Used where
+// mixing neighbours would distort the result, e.g. the dominant-color
+// histogram, which needs the original colors.
+void pointSampleRow(const uint8_t* src, uint8_t* dst, int outPixels, int factor);
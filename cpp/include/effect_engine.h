@@ -0,0 +1,147 @@
+// cpp/include/effect_engine.h
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rgb.h"
+#include "frame_target.h"
+#include "expression.h"
+
+enum class EffectType : uint8_t
+{
+    Off,
+    Rainbow,
+    Breathing,
+    Chase,
+    Fire,
+    Noise,
+    Gradient,
+    Expression
+};
+
+enum class Palette : uint8_t
+{
+    Rainbow,
+    Heat,
+    Ocean,
+    Forest
+};
+
+struct EffectParams
+{
+    EffectType type = EffectType::Off;
+    float speed = 0.25f;          // cycles per second (chase: laps, fire: x64 steps)
+    float scale = 1.0f;           // repeats across the strip (rainbow, noise, gradient)
+    RGB color{255, 96, 16};       // breathing, chase, gradient start
+    RGB color2{0, 0, 0};          // chase background, gradient end
+    int size = 8;                 // chase tail in LEDs
+    int cooling = 55;             // fire: heat lost per step
+    int sparking = 120;           // fire: chance of a new spark per step, /255
+    Palette palette = Palette::Rainbow;   // rainbow, fire, noise
+    std::shared_ptr<const ExprProgram> program;   // expr
+};
+
+// "off" or "<effect> [key=value ...]", keys as in EffectParams (color as
+// RRGGBB hex). Effect defaults first, so "fire" alone picks the heat palette.
+// "expr <program>" compiles the rest of the line (see expression.h), t in
+// seconds.
+bool parseEffect(const std::string& text, EffectParams& out, std::string& error);
+const char* effectName(EffectType type);
+
+// ----------------------------------------------------------
+// EffectEngine – eingebaute Animationen
+// ----------------------------------------------------------
+// Renders generated effects (rainbow, breathing, chase, fire, noise,
+// gradient, user expressions) on its own thread, paced by a timerfd at
+// rateHz, into a frame target (normally the "effect" source input). The
+// built-in effects are integer math per LED: a 64 bit phase accumulator
+// (Q32 turns, advanced by the elapsed time so speeds don't depend on the
+// rate) and 256 entry sine and palette tables built once - no libm call
+// per pixel. 2000 LEDs take a few microseconds per frame, so 200 Hz costs
+// well under 1 % of a core. User expressions run in the float VM of
+// expression.h instead, batched over LEDs (sin/cos as polynomials); their
+// cost grows with the program, see bench_expression.
+//
+// Parameters can be changed from any thread (IPC); the render thread picks
+// them up at the next tick. "off" releases the target and stops the timer.
+class EffectEngine
+{
+public:
+    static constexpr int DEFAULT_RATE_HZ = 200;
+
+    struct Stats
+    {
+        EffectType type = EffectType::Off;
+        uint64_t frames = 0;
+        uint64_t late = 0;          // timer ticks missed (render thread not scheduled)
+        uint64_t renderNs = 0;      // sum, for the average
+        uint64_t maxRenderNs = 0;
+
+        double avgUs() const { return frames ? renderNs / 1000.0 / frames : 0.0; }
+    };
+
+    EffectEngine(FrameTarget& target, int rateHz = DEFAULT_RATE_HZ);
+    ~EffectEngine();
+
+    EffectEngine(const EffectEngine&) = delete;
+    EffectEngine& operator=(const EffectEngine&) = delete;
+
+    bool start();
+    void stop();
+
+    void set(const EffectParams& params);
+    bool command(const std::string& text, std::string& error);   // parseEffect + set
+    EffectParams params() const;
+
+    Stats stats() const;
+
+private:
+    static constexpr uint64_t MAX_STEP_NS = 100000000;   // a stall doesn't jump the animation
+    static constexpr int MAX_FIRE_STEPS = 4;
+
+    FrameTarget& _target;
+    int _rateHz;
+    int _timerFd = -1;
+    int _wakeFd = -1;
+    std::atomic<bool> _stopping{false};
+    std::thread _thread;
+
+    mutable std::mutex _paramsMutex;
+    EffectParams _pending;                // guarded by _paramsMutex
+    std::atomic<bool> _changed{false};
+
+    // render thread only
+    EffectParams _params;
+    uint64_t _turnsQ32 = 0;               // speed, Q32 turns per second
+    uint32_t _ledStep = 0;                // Q32 turns per LED (scale repeats per strip)
+    uint64_t _phase = 0;                  // Q32 turns since the effect started
+    uint64_t _lastNs = 0;
+    uint32_t _rng = 0x9E3779B9;
+    std::vector<uint8_t> _heat;
+    ExprVM _vm;
+    std::vector<RGB> _frame;
+
+    std::atomic<uint8_t> _activeType{0};
+    std::atomic<uint64_t> _frames{0}, _late{0}, _renderNs{0}, _maxRenderNs{0};
+
+    void loop();
+    void wake();
+    bool arm(bool on);
+    void apply(const EffectParams& params);
+    const std::vector<RGB>& render(uint64_t nowNs);
+
+    void renderRainbow();
+    void renderBreathing();
+    void renderChase();
+    void renderFire(uint64_t steps);
+    void renderNoise();
+    void renderGradient();
+    void renderExpression();
+    uint8_t random8() { _rng ^= _rng << 13; _rng ^= _rng >> 17; _rng ^= _rng << 5; return uint8_t(_rng >> 24); }
+};
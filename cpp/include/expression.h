@@ -0,0 +1,93 @@
+// cpp/include/expression.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rgb.h"
+
+// ----------------------------------------------------------
+// Expression – Formelsprache für eigene Effekte
+// ----------------------------------------------------------
+// Statements "name = expr", separated by ';' or newlines:
+//
+//   r = sin(t*2 + i*0.1)*127 + 128; g = r*x; b = 0
+//
+//   inputs     t (seconds), i (LED index), n (LED count), x (i / n, 0..1)
+//   outputs    r, g, b (0..255, clamped; unassigned = 0); other names are locals
+//   operators  + - * / % < > (1 or 0), unary -, parentheses
+//   functions  sin cos abs floor fract sqrt min max step(edge, v)
+//              clamp(v, lo, hi) mix(a, b, f)
+//
+// compile() turns the text into register bytecode once: every operation
+// gets a fresh register, locals are just names for registers, constant
+// subexpressions are folded. The VM evaluates the program over BATCH LEDs
+// at a time with one float array per register (struct of arrays): each
+// instruction is a plain loop over BATCH lanes that -O3 vectorizes, so the
+// interpreter dispatch is paid once per instruction per batch instead of
+// once per LED. sin/cos are polynomials (no libm call per lane).
+class ExprProgram
+{
+public:
+    static constexpr int BATCH = 64;
+    static constexpr int MAX_REGISTERS = 128;
+    // the text comes from the network (EFFECT expr), so the recursive
+    // descent parser is bounded: folded constants use no registers
+    static constexpr int MAX_DEPTH = 64;             // nested parentheses / unary minus / calls
+    static constexpr size_t MAX_SOURCE = 4096;       // characters
+
+    // nullptr + error ("col N: message") on a syntax error
+    static std::shared_ptr<const ExprProgram> compile(const std::string& text, std::string& error);
+
+    const std::string& source() const { return _source; }
+    size_t instructions() const { return _code.size(); }
+    int registers() const { return _registers; }
+
+    // bytecode: dst = op(a[, b[, c]]), registers indices
+    enum class Op : uint8_t
+    {
+        Add, Sub, Mul, Div, Mod, Less, Greater,
+        Neg, Sin, Cos, Abs, Floor, Fract, Sqrt,
+        Min, Max, Step, Clamp, Mix
+    };
+
+    struct Instr
+    {
+        Op op;
+        uint8_t dst;
+        uint8_t a, b, c;
+    };
+
+    static float evalScalar(Op op, float a, float b, float c);   // constant folding
+
+private:
+    friend class ExprCompiler;
+    friend class ExprVM;
+
+    // fixed registers, filled by the VM
+    static constexpr uint8_t REG_T = 0, REG_I = 1, REG_N = 2, REG_X = 3, FIRST_FREE = 4;
+
+    uint64_t _id = 0;                                    // unique per compile()
+    std::string _source;
+    std::vector<Instr> _code;
+    std::vector<std::pair<uint8_t, float>> _constants;   // register, value (loaded once)
+    uint8_t _out[3] = {};                                // r, g, b
+    int _registers = FIRST_FREE;
+};
+
+// Evaluation state (the register file), one per rendering thread
+class ExprVM
+{
+public:
+    // frame.size() LEDs at time t (seconds)
+    void run(const ExprProgram& program, float t, std::vector<RGB>& frame);
+
+private:
+    std::vector<float> _regs;                      // MAX_REGISTERS x BATCH
+    uint64_t _loaded = 0;                          // program id whose constants are in _regs
+
+    float* reg(uint8_t r) { return &_regs[static_cast<size_t>(r) * ExprProgram::BATCH]; }
+};
@@ -0,0 +1,32 @@
+// cpp/include/fft.h
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// ----------------------------------------------------------
+// RealFft – FFT fester Größe für reelle Signale
+// ----------------------------------------------------------
+// N real samples are packed into N/2 complex values (even + i odd), run
+// through an iterative radix-2 FFT of size N/2 and split into the N/2 + 1
+// bins of the real spectrum. Twiddles (both for the complex FFT and the
+// split), the bit-reverse permutation and the work buffers are built in the
+// constructor, so power() does no allocation and no trig calls.
+class RealFft
+{
+public:
+    explicit RealFft(int size);        // power of two, >= 16
+
+    int size() const { return _n; }
+    int bins() const { return _n / 2 + 1; }
+
+    // in: size() samples, out: bins() values |X[k]|^2
+    void power(const float* in, float* out);
+
+private:
+    int _n;
+    std::vector<float> _twRe, _twIm;         // e^(-2 pi i j / (N/2)), j < N/4
+    std::vector<float> _splitRe, _splitIm;   // e^(-2 pi i k / N), k <= N/2
+    std::vector<uint32_t> _bitrev;           // N/2
+    std::vector<float> _re, _im;             // N/2 work buffers
+};
@@ -0,0 +1,69 @@
+// cpp/include/frame_source.h
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// ----------------------------------------------------------
+// Frame Source – liefert Bilder für den Ambient Processor
+// ----------------------------------------------------------
+// A captured frame, packed RGB24. The buffer belongs to the pipeline slot
+// and is reused, so sources write into it instead of allocating. Sources
+// that already hold RGB24 somewhere stable (e.g. a file mapping) point
+// `external` at it instead and leave data alone (zero-copy).
+struct Frame
+{
+    std::vector<uint8_t> data;
+    const uint8_t* external = nullptr;
+    int width = 0;
+    int height = 0;
+    uint64_t seq = 0;
+    uint64_t timestampNs = 0;        // steady clock, when the pixels became available
+    // when the frame is meant to be shown; paces the smoothing filters, only
+    // differences count. Live sources: timestampNs. Replays: frame index /
+    // rate, so a file is smoothed the same on every run, paced or not
+    uint64_t mediaNs = 0;
+
+    const uint8_t* pixels() const { return external ? external : data.data(); }
+};
+
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+
+    // blocks until the next frame is available; false = no more frames
+    virtual bool capture(Frame& frame) = 0;
+};
+
+// sleeps until the next frame slot; never catches up after an overrun.
+// fps <= 0: no pacing (as fast as possible)
+class FramePacer
+{
+public:
+    explicit FramePacer(double fps);
+
+    void wait();
+
+private:
+    uint64_t _periodNs;
+    uint64_t _next = 0;
+};
+
+// Test pattern (the old placeholder from main.cpp), paced to fps
+class DummySource : public FrameSource
+{
+public:
+    DummySource(int width, int height, int fps);
+
+    bool capture(Frame& frame) override;
+
+private:
+    int _width;
+    int _height;
+    FramePacer _pacer;
+    uint64_t _seq = 0;
+};
+
+// steady clock in ns, shared by all pipeline timestamps
+uint64_t monotonicNs();
@@ -0,0 +1,28 @@
+// cpp/include/frame_target.h
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "rgb.h"
+
+// ----------------------------------------------------------
+// FrameTarget – Ziel für komplette Frames
+// ----------------------------------------------------------
+// What producers (pipeline, network receivers) hand their frames to: the
+// LEDDriver directly, or a SourceManager input that arbitrates between
+// several producers.
+class FrameTarget
+{
+public:
+    virtual ~FrameTarget() = default;
+
+    // numLeds() colors, other sizes are ignored. timestampNs is when the
+    // frame is meant to be shown (steady clock, or media time for replays,
+    // see Frame::mediaNs); it paces the smoothing, 0 = now
+    virtual void submitFrame(const std::vector<RGB>& colors, uint64_t timestampNs = 0) = 0;
+    virtual int numLeds() const = 0;
+    // the producer has nothing to show any more (a source input stops
+    // competing; the driver keeps the last frame)
+    virtual void release() {}
+};
@@ -1,6 +1,77 @@
 // cpp/include/ipc_server.h
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "source_manager.h"
+
 class LEDDriver;
+class EffectEngine;
+class Pipeline;
+
+static constexpr int DEFAULT_IPC_PORT = 9000;
+
+// ----------------------------------------------------------
+// IpcServer – Textbefehle über TCP
+// ----------------------------------------------------------
+// Line protocol, see LEDDriver::handleCommand. With colors set, the pixel
+// commands (COLOR, PIX) build an IPC-owned frame that is submitted to that
+// source instead of writing the driver directly; RELEASE hands the strip
+// back to lower-priority sources. With effects set, "EFFECT <name>
+// [key=value ...]" / "EFFECT off" control the effect engine. With pipeline
+// set, "DELAY <ms>" sets the A/V sync delay of the capture output, "DELAY"
+// alone prints it, and STATUS also prints the capture side (crop, border
+// detector and per-worker times).
+//
+// One thread accepts (polling the listener and a wake eventfd), one thread
+// per client reads lines. Every thread and socket is owned by the server:
+// stop() shuts the client sockets down and joins all threads, so nothing
+// touches the driver, effects or pipeline after it returns. Stop the
+// server before any of them is destroyed.
+class IpcServer
+{
+public:
+    IpcServer(LEDDriver& driver, int port = DEFAULT_IPC_PORT, SourceManager::Input* colors = nullptr,
+              EffectEngine* effects = nullptr, Pipeline* pipeline = nullptr);
+    ~IpcServer();
+
+    IpcServer(const IpcServer&) = delete;
+    IpcServer& operator=(const IpcServer&) = delete;
+
+    bool start();
+    void stop();
+
+private:
+    struct Client
+    {
+        int fd = -1;                 // closed by the server after the join
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    LEDDriver& _driver;
+    int _port;
+    SourceManager::Input* _colors;
+    EffectEngine* _effects;
+    Pipeline* _pipeline;
+    int _listenFd = -1;
+    int _wakeFd = -1;
+    std::thread _thread;
+
+    std::mutex _clientsMutex;
+    std::vector<std::unique_ptr<Client>> _clients;
+    bool _stopping = false;              // guarded by _clientsMutex: accept no more clients
+
+    std::mutex _frameMutex;              // shared by all client threads
+    std::vector<RGB> _frame;             // COLOR / PIX frame, _colors->numLeds()
 
-void runIPCServer(LEDDriver* driver);
+    void acceptLoop();
+    void clientLoop(Client& c);
+    void handleLine(const std::string& line);
+    bool handlePixelCommand(const std::string& line);
+    void reapClients();                  // joins finished clients; caller holds _clientsMutex
+};
@@ -0,0 +1,37 @@
+// cpp/include/latency_harness.h
+#pragma once
+
+#include <string>
+
+class FrameSource;
+
+// ----------------------------------------------------------
+// Latency Harness – Glass-to-LED Messung ohne Grabber
+// ----------------------------------------------------------
+// Drives the full pipeline (capture -> AmbientProcessor -> LEDDriver) with
+// a synthetic source that steps the whole picture between gray levels
+// ("probes"), and records every frame the driver hands to a fake output
+// sink. Each frame carries its sequence number and capture timestamp; the
+// probe start times are matched against the sink timestamps afterwards:
+//   first change  probe start -> first output that moved 5% of the step
+//   settled       probe start -> output stays within 5% of its final value
+// so "settled" includes the convergence time of both smoothing filters.
+// Runs headless, no SPI device or grabber needed.
+struct LatencyOptions
+{
+    int probes = 120;
+    int holdFrames = 45;             // frames per probe, must exceed the settling time
+    int fps = 60;
+    int width = 320;
+    int height = 180;
+    int leds = 60;
+};
+
+// prints the distribution (p50/p90/p99/max) and pipeline stats; exit code
+int runLatencyHarness(const LatencyOptions& options);
+
+// Throughput: every frame of source (e.g. a ReplaySource) through the
+// pipeline with back-pressure and a sink that only counts, then frames/s
+// and the per-stage stats. Deterministic input -> comparable numbers, and
+// with tracePath a golden output trace to diff against (tools/trace_diff).
+int runThroughputHarness(FrameSource& source, int leds, const std::string& tracePath = std::string());
@@ -3,32 +3,159 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
 
 #include "rgb.h"
+#include "color_order.h"
+#include "calibration.h"
+#include "power_limiter.h"
+#include "smoothing.h"
+#include "output_sink.h"
+#include "trace.h"
+#include "frame_target.h"
 
 // ----------------------------------------------------------
-// LED Controller – steuert den Strip über SPI
+// LED Driver – steuert den Strip über SPI
 // ----------------------------------------------------------
-class LEDController
+class LEDDriver : public FrameTarget
 {
 public:
-    LEDController(int numLeds, const std::string& spiDevice = "/dev/spidev0.0");
-    ~LEDController();
+    LEDDriver(const std::string& spi_dev, int num_leds);
+    LEDDriver(std::unique_ptr<OutputSink> sink, int num_leds);
+    ~LEDDriver();
 
-    void setPixel(int index, const RGB& color);
-    void setPixels(const std::vector<RGB>& colors);
+    void setAll(uint8_t r, uint8_t g, uint8_t b);
+    void setPixel(int idx, uint8_t r, uint8_t g, uint8_t b);
 
-    void applyGamma(float gamma);
-    void send();                     // schreibt über SPI
+    // whole frame (numLeds() colors) through the smoothing filter, then
+    // shown, or picked up by the refresh thread if it runs
+    void submitFrame(const std::vector<RGB>& colors, uint64_t timestampNs = 0) override;
+
+    void show();                     // schreibt über SPI
     void clear();                    // alle LEDs aus
 
+    // Refresh thread: re-sends the current state at a fixed rate so the
+    // dithering stage can spread fractional levels over several refreshes.
+    void startOutputThread(int refreshHz);
+    void stopOutputThread();
+
+    void setGamma(float gamma);
+    void setBrightness(float brightness);
+    // EMA time constant in ms (see smoothing.h), alpha derived per update
+    // from the time since the previous one
+    void setSmoothingTime(float tauMs);
+    void setSmoothingAlpha(float alpha);   // per frame at SMOOTHING_REFERENCE_HZ
+    // fastTauMs is used above params.attackThreshold, cuts snap (alpha 1)
+    void setAdaptiveSmoothing(float fastTauMs, const AdaptiveSmoothing& params);
+    void setDithering(bool enabled);
+
+    // wire layout: byte order + reversed sections
+    void setColorOrder(ColorOrder order);
+    bool setSegments(std::vector<LedSegment> segments);
+
+    // segment < 0: whole strip (also the default for new segment layouts)
+    bool setCalibration(int segment, const Calibration& calib);
+    Calibration calibration(int segment);
+    // read-modify-write under one lock; fn returns false to leave it unchanged.
+    // false if there is no such segment or fn declined
+    bool updateCalibration(int segment, const std::function<bool(Calibration&)>& fn);
+
+    void setPowerModel(const PowerModel& model);
+    PowerModel powerModel();
+
+    // everything the output tables depend on, applied in one step: a single
+    // rebuild on the calling thread, then one atomic swap (config reload)
+    struct OutputConfig
+    {
+        float gamma = 2.2f;
+        float brightness = 1.0f;
+        std::vector<LedSegment> segments;    // empty = one RGB segment
+        Calibration calibration;             // whole strip, CALIB SEG n kept if the boundaries match
+        PowerModel power;
+    };
+    bool setOutputConfig(OutputConfig config);
+
+    // record every frame written by show() (delta-encoded, see trace.h)
+    bool startTrace(const std::string& path, bool exclusive = false);
+    void stopTrace();
+    // where TRACE ON writes; empty = TRACE ON refused. The IPC port takes
+    // no paths, only file names inside this directory.
+    void setTraceDir(const std::string& dir);
+
+    void handleCommand(const std::string& cmd);
+
+    int numLeds() const override { return numLeds_; }
+
 private:
-    int _numLeds;
-    int _spiFd;                      // SPI file descriptor
-    std::vector<RGB> _leds;
-    float _gamma = 2.2f;
-
-    bool openSpi(const std::string& device);
-    void closeSpi();
-    uint8_t gammaCorrect(uint8_t v) const;
+    std::unique_ptr<OutputSink> sink_;
+    int numLeds_;
+
+    std::vector<uint8_t> buffer_;          // wire bytes (segment order/direction applied)
+    std::vector<uint8_t> lastBuffer_;
+    std::vector<uint8_t> logicalBuffer_;   // quantized RGB per logical LED
+    std::vector<uint16_t> wire16_;         // wire values, 8.8 fixed point
+    std::vector<uint16_t> ditherAcc_;      // carried fraction per wire byte (0..255)
+    std::vector<float> lastFloatBuffer_;   // smoothed RGB 0..255
+
+    // guarded by configMutex_
+    float gamma_;
+    float brightness_;
+    std::vector<LedSegment> segments_;
+    std::vector<Calibration> calibrations_;    // one per segment
+    Calibration stripCalibration_;
+    PowerModel power_;
+
+    float smoothingMs_;                    // time constants (guarded by mutex_)
+    float smoothingFastMs_ = 18.2f;
+    uint64_t lastSmoothNs_ = 0;            // previous doSmoothing's timestamp, 0 = none yet
+    AdaptiveSmoothing adaptive_;
+    uint64_t smoothFast_ = 0;              // frames with fast attack (guarded by mutex_)
+    uint64_t smoothCuts_ = 0;              // frames snapped on a cut
+    bool dithering_ = false;
+
+    // Everything the encoder needs, compiled from the config above. Built
+    // under configMutex_ and published with an atomic pointer swap, so the
+    // output thread never waits for a rebuild.
+    struct OutputTables
+    {
+        std::vector<LedSegment> segments;
+        std::vector<CompiledCalibration> calib; // per segment: matrix + gain/gamma/brightness LUTs
+        PowerModel power;
+    };
+    std::shared_ptr<const OutputTables> tables_;
+
+    std::mutex mutex_;                     // frame state (buffers, smoothing)
+    std::mutex configMutex_;               // config + table rebuilds
+    std::mutex outputMutex_;               // serializes render + SPI write
+    std::mutex threadMutex_;               // start/stop of the refresh thread
+
+    std::mutex traceMutex_;                // trace file; taken after outputMutex_, never before
+    TraceWriter trace_;                    // guarded by traceMutex_
+    std::vector<uint8_t> traceFrame_;      // copy of buffer_ being recorded, guarded by traceMutex_
+    std::atomic<bool> tracing_{false};     // trace_ open, checked without the lock
+    std::string traceDir_;                 // guarded by outputMutex_
+
+    // power limiter stats (written by the render path)
+    std::atomic<uint32_t> powermW_{0};     // estimate before limiting, last frame
+    std::atomic<uint64_t> powerFrames_{0};
+    std::atomic<uint64_t> powerLimited_{0};
+
+    std::thread outputThread_;
+    std::atomic<bool> outputRunning_{false};
+    std::atomic<int> refreshHz_{0};        // for STATUS, the thread gets its own copy
+
+    void rebuildTables();                  // caller holds configMutex_
+
+    void applyGammaAndBrightness();        // caller holds mutex_
+    void limitPower(const OutputTables& tables);
+    void requestShow();                    // show now, or leave it to the refresh thread
+    void startNamedTrace(std::string name);
+    void joinOutputThread();               // caller holds threadMutex_
+    void outputLoop(int refreshHz);
+    // count = numLeds_ * 3, timestampNs as in submitFrame()
+    void doSmoothing(const uint8_t* newbuf, size_t count, uint64_t timestampNs);
 };
@@ -0,0 +1,102 @@
+// cpp/include/opc_server.h
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rgb.h"
+#include "frame_target.h"
+
+static constexpr int OPC_PORT = 7890;
+
+// ----------------------------------------------------------
+// OpcServer – Open Pixel Control über TCP
+// ----------------------------------------------------------
+// Message: channel (1), command (1), length (2, big endian), payload.
+// Command 0 (set pixel colors, RGB) is the only one used; everything else
+// is skipped. Each channel maps to an LED range (multi-strip setups);
+// channel 0 is broadcast to every mapped range.
+//
+// One thread polls the listening socket and all clients. The header is
+// read on its own, then the payload is recv'd straight into the mapped
+// range of the staging frame - no line splitting, no std::string. A poll
+// round drains every client and renders once at the end, so a client that
+// outruns the strip only gets its latest frame shown (coalescing). A round
+// that ends inside a payload waits for the rest instead of showing a torn
+// frame, up to STALL_MS.
+class OpcServer
+{
+public:
+    struct Mapping
+    {
+        uint8_t channel = 1;
+        int start = 0;              // first LED
+        int count = 0;              // LEDs, clipped to the strip
+    };
+
+    struct Stats
+    {
+        uint64_t messages = 0;      // complete set-pixel messages
+        uint64_t frames = 0;        // submitted to the target
+        uint64_t coalesced = 0;     // messages superseded before they were shown
+        uint64_t skipped = 0;       // other commands, unmapped channels
+        uint64_t clients = 0;       // accepted so far
+    };
+
+    // empty mapping = channel 1 drives the whole strip
+    OpcServer(FrameTarget& target, int port = OPC_PORT, std::vector<Mapping> mapping = {});
+    ~OpcServer();
+
+    OpcServer(const OpcServer&) = delete;
+    OpcServer& operator=(const OpcServer&) = delete;
+
+    bool start();
+    void stop();
+
+    Stats stats() const;
+
+    // "channel:start:count ..." -> mapping; false on a bad entry
+    static bool parseMapping(const std::string& spec, std::vector<Mapping>& out);
+
+private:
+    static constexpr int MAX_CLIENTS = 8;
+    static constexpr size_t HEADER = 4;
+    static constexpr int STALL_MS = 50;
+    static constexpr uint8_t CMD_SET_PIXELS = 0;
+
+    struct Client
+    {
+        int fd = -1;
+        uint8_t header[HEADER];
+        size_t headerGot = 0;
+        size_t remaining = 0;       // payload bytes still to read
+        size_t pos = 0;             // payload bytes read
+        const Mapping* target = nullptr;   // nullptr = discard payload
+        bool broadcast = false;
+    };
+
+    FrameTarget& _target;
+    int _port;
+    std::vector<Mapping> _mapping;
+    int _listenFd = -1;
+    int _wakeFd = -1;
+    std::thread _thread;
+
+    // server thread only
+    std::vector<RGB> _frame;
+    std::vector<Client> _clients;
+    std::vector<uint8_t> _scratch;      // sink for skipped payload bytes
+    uint64_t _pending = 0;              // complete messages since the last render
+
+    std::atomic<uint64_t> _messages{0}, _frames{0}, _coalesced{0}, _skipped{0}, _accepted{0};
+
+    void loop();
+    void acceptClients();
+    bool readClient(Client& c);         // false = connection closed
+    void beginPayload(Client& c);
+    void finishMessage(Client& c);
+    void render();
+};
@@ -0,0 +1,40 @@
+// cpp/include/output_sink.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ----------------------------------------------------------
+// Output Sink – wohin die fertigen Bytes geschrieben werden
+// ----------------------------------------------------------
+// LEDDriver renders into wire bytes and hands each frame to a sink. The
+// daemon uses SpiSink; tests and the latency harness plug in their own.
+class OutputSink
+{
+public:
+    virtual ~OutputSink() = default;
+
+    // one complete frame in wire order; false on a failed/partial write
+    virtual bool write(const uint8_t* data, size_t size) = 0;
+};
+
+// spidev device (WS2801), includes the latch pause after every frame
+class SpiSink : public OutputSink
+{
+public:
+    static constexpr uint32_t DEFAULT_SPEED_HZ = 8000000; // 8MHz (WS2801 safe)
+
+    // throws if the device can't be opened
+    explicit SpiSink(const std::string& device, uint32_t speedHz = DEFAULT_SPEED_HZ);
+    ~SpiSink() override;
+
+    SpiSink(const SpiSink&) = delete;
+    SpiSink& operator=(const SpiSink&) = delete;
+
+    bool write(const uint8_t* data, size_t size) override;
+
+private:
+    std::string _device;
+    int _fd = -1;
+};
@@ -0,0 +1,171 @@
+// cpp/include/pipeline.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "rgb.h"
+#include "frame_source.h"
+#include "spsc_queue.h"
+#include "delay_line.h"
+#include "ambient_processor.h"
+
+class FrameTarget;
+
+// ----------------------------------------------------------
+// Pipeline – Capture -> Process -> Output auf eigenen Threads
+// ----------------------------------------------------------
+// Three stages, one thread each (optionally pinned to a core), connected by
+// SPSC queues of slot indices. Frame and color buffers are allocated once
+// and cycle between the stages through free lists, so the steady state does
+// not allocate or lock. Throughput is bounded by the slowest stage instead
+// of the sum of all three.
+//
+// When a stage is still busy with older frames the new frame is dropped
+// (counted) instead of queued deeper, so queueing adds at most
+// QUEUE_DEPTH frames of latency. File replay sets Params::blocking to
+// wait for the next stage instead, so every frame is processed.
+//
+// An idle stage spins briefly (the next frame is usually due shortly),
+// then sleeps on a futex until the neighbouring stage signals new work or
+// free slots, so a 60 fps pipeline does not poll empty queues.
+//
+// For A/V sync the output stage can hold frames back: with a delay set,
+// processed frames go into a DelayLine and are submitted once their
+// capture timestamp + delay has passed. Without one they are submitted
+// straight from the queue slot, as before.
+class Pipeline
+{
+public:
+    static constexpr size_t QUEUE_DEPTH = 2;
+
+    struct Params
+    {
+        int cores[3] = { -1, -1, -1 };   // capture, process, output; -1 = not pinned
+        bool blocking = false;           // back-pressure instead of dropping frames
+    };
+    // cores 1..3 on machines with at least 4 CPUs (core 0 left for IPC / system)
+    static Params defaultParams();
+
+    Pipeline(FrameSource& source, AmbientProcessor& processor, FrameTarget& target,
+             const Params& params = defaultParams());
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    void start();
+    void stop();
+    // the source ran out and every captured frame has been output
+    bool finished() const { return _outputDone.load(); }
+
+    // A/V sync, any thread, takes effect at the next output check
+    void setDelayMs(int ms) {
+        _delay.setDelayMs(ms);
+        _wakeOutput.notify();        // a shorter delay may make a held frame due now
+    }
+    int delayMs() const { return _delay.delayMs(); }
+
+    struct StageStats
+    {
+        uint64_t frames = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+
+        double avgUs() const { return frames ? totalNs / 1000.0 / frames : 0.0; }
+    };
+
+    struct Stats
+    {
+        StageStats capture;          // pixels available -> capture() returned
+        StageStats process;          // AmbientProcessor::processFrame
+        StageStats output;           // submitFrame (LEDDriver: smoothing + SPI)
+        StageStats queued;           // time waiting in both queues
+        StageStats latency;          // pixels available -> output done (includes the delay)
+        uint64_t droppedCapture = 0; // process stage busy
+        uint64_t droppedProcess = 0; // output stage busy
+        int delayMs = 0;
+        uint64_t droppedDelay = 0;   // overdue or overwritten in the delay line
+        AmbientProcessor::Stats ambient;
+    };
+    Stats stats() const;
+
+private:
+    // written by one stage thread, read by stats()
+    struct StageCounter
+    {
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> totalNs{0};
+        std::atomic<uint64_t> maxNs{0};
+
+        void add(uint64_t ns);
+        StageStats snapshot() const;
+    };
+
+    // Futex sleep of one stage thread. The waiter reads prepare() before
+    // checking its queue; a notify() after that read ends the wait.
+    class Wakeup
+    {
+    public:
+        uint32_t prepare() const { return _seq.load(); }
+        // spins while spins < SPIN_ITERATIONS, then sleeps (timeoutNs 0 = no limit)
+        void wait(uint32_t seen, int& spins, uint64_t timeoutNs = 0);
+        void notify();
+
+    private:
+        std::atomic<uint32_t> _seq{0};
+        std::atomic<uint32_t> _sleepers{0};
+    };
+
+    struct FrameSlot
+    {
+        Frame frame;
+        uint64_t enqueuedNs = 0;
+    };
+
+    struct ColorSlot
+    {
+        std::vector<RGB> colors;
+        uint64_t timestampNs = 0;    // from the frame
+        uint64_t mediaNs = 0;
+        uint64_t queuedNs = 0;       // time spent in the capture queue
+        uint64_t enqueuedNs = 0;
+    };
+
+    // one slot per queue entry + one held by each adjacent stage, so the
+    // producer always finds a free slot after a successful push
+    static constexpr size_t SLOTS = QUEUE_DEPTH + 2;
+
+    FrameSource& _source;
+    AmbientProcessor& _processor;
+    FrameTarget& _target;
+    Params _params;
+
+    std::array<FrameSlot, SLOTS> _frames;
+    std::array<ColorSlot, SLOTS> _colors;
+    SpscQueue<int, QUEUE_DEPTH> _toProcess;
+    SpscQueue<int, QUEUE_DEPTH> _toOutput;
+    SpscQueue<int, SLOTS> _freeFrames;       // process -> capture
+    SpscQueue<int, SLOTS> _freeColors;       // output -> process
+    DelayLine _delay;                        // output thread, except setDelayMs
+
+    std::thread _threads[3];
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _captureDone{false};
+    std::atomic<bool> _processDone{false};
+    std::atomic<bool> _outputDone{false};
+    Wakeup _wakeCapture, _wakeProcess, _wakeOutput;   // one sleeper each
+
+    StageCounter _capture, _process, _output, _queued, _latency;
+    std::atomic<uint64_t> _droppedCapture{0};
+    std::atomic<uint64_t> _droppedProcess{0};
+
+    void captureLoop();
+    void processLoop();
+    void outputLoop();
+    void emit(const std::vector<RGB>& colors, uint64_t timestampNs, uint64_t mediaNs);
+    bool push(SpscQueue<int, QUEUE_DEPTH>& queue, int slot);
+};
@@ -0,0 +1,24 @@
+// cpp/include/power_limiter.h
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// ----------------------------------------------------------
+// Power limiter – current estimate from the post-gamma frame
+// ----------------------------------------------------------
+struct PowerModel
+{
+    float channelmA[3] = { 20.0f, 20.0f, 20.0f };  // logical R, G, B at full duty
+    float idlemA = 1.0f;                           // per LED, driver IC quiescent
+    float volts = 5.0f;
+    float budgetmA = 0.0f;                         // 0 = no limit
+};
+
+// Sums of 8.8 wire values per triplet position (0, 1, 2) over count LEDs.
+// Accumulates 8 LEDs (24 lanes) at a time so the inner loop is a plain
+// contiguous add that the compiler vectorizes; lanes are folded at the end.
+void sumTriplets(const uint16_t* wire, int count, uint64_t out[3]);
+
+// wire = wire * scale / 65536
+void scaleFrame(uint16_t* wire, size_t n, uint32_t scaleQ16);
@@ -0,0 +1,88 @@
+// cpp/include/replay_source.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "frame_source.h"
+
+// ----------------------------------------------------------
+// Replay Source – spielt Rohdaten- / Y4M-Dateien ab
+// ----------------------------------------------------------
+// The file is mmap'ed once and never copied:
+//   rgb   packed RGB24, width * height * 3 bytes per frame, headerless
+//   yuyv  packed YUYV 4:2:2 (V4L2 grabber dumps), headerless
+//   y4m   YUV4MPEG2 with C420* / C422 / C444 (planar), size + rate from the header
+// RGB frames are handed to the pipeline as a pointer into the mapping
+// (Frame::external). YUV frames are converted (BT.601, limited range) into
+// the slot's reused buffer. Plays at the file's (or the given) frame rate,
+// or as fast as possible with fps <= 0. Frame n carries the media time
+// (n + 1) / rate (the file rate, or 60 fps, when unpaced), so the smoothing
+// and a trace of it don't depend on how fast the replay ran.
+class ReplaySource : public FrameSource
+{
+public:
+    enum class Format
+    {
+        RGB24,
+        YUYV,
+        Y4M
+    };
+
+    struct Options
+    {
+        Format format = Format::Y4M;
+        int width = 0;               // raw formats only; Y4M reads the header
+        int height = 0;
+        double fps = 0.0;            // 0 = as fast as possible, < 0 = file rate (Y4M) / 60
+        bool loop = false;
+    };
+
+    ReplaySource(const std::string& path, const Options& options);   // throws on bad files
+    ~ReplaySource() override;
+
+    ReplaySource(const ReplaySource&) = delete;
+    ReplaySource& operator=(const ReplaySource&) = delete;
+
+    bool capture(Frame& frame) override;
+
+    int width() const { return _width; }
+    int height() const { return _height; }
+    size_t frameCount() const { return _frames.size(); }
+    double fileFps() const { return _fileFps; }
+
+    // from the extension: .y4m, .yuyv, anything else raw RGB24. false for
+    // .yuv, which is used for planar I420 as often as for packed YUYV, so
+    // the caller has to name the format
+    static bool formatFromPath(const std::string& path, Format& format);
+    // "rgb" | "yuyv" | "y4m"
+    static bool parseFormat(const std::string& name, Format& format);
+
+private:
+    enum class Chroma
+    {
+        None,                        // packed (RGB24 / YUYV)
+        C420,
+        C422,
+        C444
+    };
+
+    const uint8_t* _map = nullptr;
+    size_t _size = 0;
+    Format _format;
+    Chroma _chroma = Chroma::None;
+    int _width = 0;
+    int _height = 0;
+    double _fileFps = 0.0;
+    bool _loop;
+    std::vector<size_t> _frames;     // byte offset of each frame's pixel data
+    size_t _next = 0;
+    uint64_t _seq = 0;               // frames delivered, across loops
+    uint64_t _mediaStepNs = 0;
+    FramePacer _pacer;
+
+    void parseY4M(const std::string& path);
+    void indexRaw(size_t frameBytes, const std::string& path);
+};
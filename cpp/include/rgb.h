@@ -13,4 +13,7 @@ struct RGB
 
     RGB() : r(0), g(0), b(0) {}
     RGB(uint8_t r_, uint8_t g_, uint8_t b_) : r(r_), g(g_), b(b_) {}
-};
\ No newline at end of file
+};
+
+// arrays of RGB are passed on as packed RGB24
+static_assert(sizeof(RGB) == 3, "RGB must stay packed");
\ No newline at end of file
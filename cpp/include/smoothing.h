@@ -0,0 +1,59 @@
+// cpp/include/smoothing.h
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// ----------------------------------------------------------
+// Adaptive smoothing – change metric + response selection
+// ----------------------------------------------------------
+// Per frame the mean absolute difference per channel between the new LED
+// vector and the current output decides how fast the filter follows:
+//   below attackThreshold  -> slow (static scene, suppress flicker)
+//   above attackThreshold  -> fast attack
+//   above cutThreshold     -> snap (scene cut, no fade)
+// A threshold <= 0 disables that step.
+struct AdaptiveSmoothing
+{
+    float attackThreshold = 12.0f;
+    float cutThreshold = 64.0f;
+};
+
+enum class SmoothingResponse : uint8_t
+{
+    Slow,
+    Fast,
+    Snap
+};
+
+SmoothingResponse classifyChange(float meanAbsDiff, const AdaptiveSmoothing& params);
+
+// ----------------------------------------------------------
+// Zeitkonstante – Glättung unabhängig von der Framerate
+// ----------------------------------------------------------
+// An EMA step l += a * (x - l) with a = 1 - exp(-dt / tau) responds the same
+// per second at any update rate: two steps of dt move exactly as far as one
+// of 2 dt. Frames can be dropped or the rate changed without changing how
+// fast the LEDs follow. exp comes from a 256 entry table of exp(-x) over
+// 0..8 with linear interpolation, so an update costs no libm call; dt / tau
+// beyond the table snaps (a = 1). alpha is off by less than 4e-4.
+//
+// Older settings given per frame (alpha, window length) are converted at
+// SMOOTHING_REFERENCE_HZ, so they look as before at that rate.
+static constexpr int SMOOTHING_REFERENCE_HZ = 60;
+static constexpr float MAX_SMOOTHING_MS = 10000.0f;
+// a gap (source idle, first frame) counts as at most this much, so the
+// first update after a pause still fades instead of jumping
+static constexpr uint64_t MAX_SMOOTHING_STEP_NS = 100000000;
+
+// dt = 0 -> 0, tauMs <= 0 -> 1
+float emaAlpha(uint64_t dtNs, float tauMs);
+// per frame alpha at the reference rate -> time constant (alpha 0 = MAX_SMOOTHING_MS)
+float alphaToTauMs(float alpha);
+// moving average over frames at the reference rate -> time constant with
+// the same delay ((frames - 1) / 2 frames)
+float windowToTauMs(int frames);
+
+// sum |a[i] - b[i]|, plain loops the compiler vectorizes
+uint32_t sumAbsDiff(const uint8_t* a, const uint8_t* b, size_t n);
+uint32_t sumAbsDiff(const uint8_t* a, const float* b, size_t n);   // b: 0..255 state
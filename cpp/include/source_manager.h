@@ -0,0 +1,132 @@
+// cpp/include/source_manager.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "compositor.h"
+#include "frame_target.h"
+#include "rgb.h"
+
+struct SourcePolicy
+{
+    int priority = 100;     // higher wins
+    int timeoutMs = 0;      // without a frame for this long the source expires, 0 = never
+    BlendMode blend = BlendMode::Normal;
+    float opacity = 1.0f;   // 0..1
+};
+
+// ----------------------------------------------------------
+// SourceManager – Priorisierung mehrerer Eingänge
+// ----------------------------------------------------------
+// Every producer (capture pipeline, network receivers, IPC colors, ...)
+// registers an Input with a priority and a timeout and submits frames to
+// it instead of to the LEDDriver. The highest-priority live opaque input
+// (Normal blend, full opacity) is the base layer; live inputs above it are
+// blended on top (overlays, see compositor.h). An input that stops sending
+// expires after its timeout and the next one takes over with its latest
+// frame. Layers appearing or disappearing crossfade over fadeMs, computed
+// from elapsed time on the manager thread.
+//
+// Producers never lock: a frame goes into the input's triple buffer (one
+// copy + one atomic exchange) and sets the input's bit in the live mask.
+// Bits are ordered by priority, so the base is the lowest opaque set bit.
+// The manager thread is the only consumer; a producer only wakes it
+// (eventfd) when it is at or above the current base.
+class SourceManager
+{
+public:
+    static constexpr int MAX_SOURCES = 16;
+
+    class Input : public FrameTarget
+    {
+    public:
+        // the timestamp is dropped: the manager composes and smooths on its
+        // own clock, inputs may not share a time base
+        void submitFrame(const std::vector<RGB>& colors, uint64_t timestampNs = 0) override;
+        int numLeds() const override;
+        // stop competing until the next frame (e.g. client disconnected)
+        void release() override;
+
+    private:
+        friend class SourceManager;
+        static constexpr uint8_t FRESH = 0x4;     // middle buffer holds an unread frame
+        static constexpr uint8_t INDEX = 0x3;
+
+        SourceManager* _manager = nullptr;
+        std::string _name;
+        SourcePolicy _policy;
+        uint64_t _timeoutNs = 0;
+        uint32_t _opacity = OPAQUE;                // Q8
+        int _rank = 0;
+        uint32_t _bit = 0;
+        FadeLevel _level;                          // manager thread only
+
+        std::array<std::vector<RGB>, 3> _buffers;
+        uint8_t _back = 0;                         // producer only
+        uint8_t _front = 2;                        // manager thread only
+        std::atomic<uint8_t> _middle{1};
+
+        std::atomic<uint64_t> _lastNs{0};
+        std::atomic<uint64_t> _submitted{0}, _shown{0}, _superseded{0}, _expired{0};
+    };
+
+    struct SourceStats
+    {
+        std::string name;
+        SourcePolicy policy;
+        uint64_t submitted = 0;
+        uint64_t shown = 0;          // composites that included a new frame of this input
+        uint64_t superseded = 0;     // overwritten before the manager read them
+        uint64_t expired = 0;
+        bool live = false;
+        bool active = false;         // base layer
+    };
+
+    // composites go to target (the LEDDriver)
+    explicit SourceManager(FrameTarget& target, int fadeMs = 0);
+    ~SourceManager();
+
+    SourceManager(const SourceManager&) = delete;
+    SourceManager& operator=(const SourceManager&) = delete;
+
+    // all inputs before start() and before any producer runs (adding
+    // re-ranks); equal priorities rank in registration order
+    Input& add(const std::string& name, const SourcePolicy& policy);
+
+    bool start();
+    void stop();
+
+    std::vector<SourceStats> stats() const;
+
+private:
+    static constexpr int NONE = MAX_SOURCES;
+    static constexpr int FADE_TICK_MS = 10;        // 100 Hz while a crossfade runs
+
+    FrameTarget& _target;
+    int _numLeds;
+    uint64_t _fadeNs;
+    Compositor _compositor;
+    std::vector<Layer> _layers;
+    std::vector<std::unique_ptr<Input>> _inputs;    // registration order
+    std::vector<Input*> _byRank;                    // bit index -> input
+    std::atomic<uint32_t> _live{0};
+    uint32_t _opaqueMask = 0;                       // Normal blend at full opacity
+    std::atomic<int> _winner{NONE};
+    int _wakeFd = -1;
+    std::atomic<bool> _stopping{false};
+    std::thread _thread;
+
+    void publish(Input& in, const std::vector<RGB>& colors);
+    void release(Input& in);
+    void wake();
+    bool stale(const Input& in, uint64_t now) const;
+    int select(uint64_t now);
+    int nextTimeoutMs(bool fading) const;
+    void loop();
+};
@@ -0,0 +1,50 @@
+// cpp/include/spsc_queue.h
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// ----------------------------------------------------------
+// SPSC Queue – lock-free ring between exactly two threads
+// ----------------------------------------------------------
+// One producer calls tryPush, one consumer calls tryPop. Head and tail are
+// free-running counters on separate cache lines; each side keeps a cached
+// copy of the other side's counter and only re-reads the shared one when
+// the ring looks full (producer) or empty (consumer). Neither call blocks.
+template <class T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    bool tryPush(const T& value) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _headCache == Capacity) {
+            _headCache = _head.load(std::memory_order_acquire);
+            if (tail - _headCache == Capacity) return false;
+        }
+        _items[tail & (Capacity - 1)] = value;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tailCache) {
+            _tailCache = _tail.load(std::memory_order_acquire);
+            if (head == _tailCache) return false;
+        }
+        value = _items[head & (Capacity - 1)];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    alignas(64) std::atomic<size_t> _tail{0};   // written by the producer
+    size_t _headCache = 0;                      // producer's view of _head
+    alignas(64) std::atomic<size_t> _head{0};   // written by the consumer
+    size_t _tailCache = 0;                      // consumer's view of _tail
+    alignas(64) T _items[Capacity];
+};
@@ -0,0 +1,87 @@
+// cpp/include/trace.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ----------------------------------------------------------
+// LED Trace – aufgezeichnete Ausgabe-Frames (append-only)
+// ----------------------------------------------------------
+// File layout, little endian:
+//   header  "LEDTRACE" | u32 version | u32 frameBytes
+//   record  u32 payloadBytes | u32 runs | u64 timestampNs | payload
+//   payload runs x (varint skip, varint length, length bytes)
+// Every record is a delta against the previous frame (the first one
+// against all zeros): only changed byte ranges are stored, ranges closer
+// than a few bytes are merged. The fixed record header lets a reader step
+// through a mapped file without decoding the runs; a truncated last record
+// (crash while writing) is ignored.
+static constexpr char TRACE_MAGIC[8] = { 'L', 'E', 'D', 'T', 'R', 'A', 'C', 'E' };
+static constexpr uint32_t TRACE_VERSION = 1;
+
+struct TraceStats
+{
+    uint64_t frames = 0;
+    uint64_t changedBytes = 0;       // bytes that differ from the previous frame
+    uint64_t fileBytes = 0;
+};
+
+class TraceWriter
+{
+public:
+    TraceWriter() = default;
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    // new file (truncates); exclusive: fail if path exists or is a symlink
+    // instead (names that came over the network); false + message on error
+    bool open(const std::string& path, size_t frameBytes, bool exclusive = false);
+    void close();
+    bool isOpen() const { return _fd >= 0; }
+
+    // one frame of frameBytes bytes
+    void append(const uint8_t* frame, uint64_t timestampNs);
+
+    const TraceStats& stats() const { return _stats; }
+    const std::string& path() const { return _path; }
+
+private:
+    int _fd = -1;
+    std::string _path;
+    std::vector<uint8_t> _prev;
+    std::vector<uint8_t> _record;    // reused encode buffer
+    TraceStats _stats;
+};
+
+class TraceReader
+{
+public:
+    TraceReader() = default;
+    ~TraceReader();
+
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    bool open(const std::string& path);   // false + message on error
+
+    // decode the next record into frame(); false at the end
+    bool next();
+
+    const std::vector<uint8_t>& frame() const { return _frame; }
+    uint64_t timestampNs() const { return _timestampNs; }
+    uint32_t changedBytes() const { return _changed; }   // of the last record
+    size_t frameBytes() const { return _frame.size(); }
+    size_t fileBytes() const { return _size; }
+
+private:
+    const uint8_t* _map = nullptr;
+    size_t _size = 0;
+    size_t _pos = 0;
+    std::vector<uint8_t> _frame;
+    uint64_t _timestampNs = 0;
+    uint32_t _changed = 0;
+};
@@ -0,0 +1,59 @@
+// cpp/include/worker_pool.h
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// ----------------------------------------------------------
+// Worker Pool – persistent threads for per-frame parallel work
+// ----------------------------------------------------------
+// run(fn) calls fn(i) once for every participant i in 0..size()-1 and
+// returns when all are done. The calling thread is participant 0, so a pool
+// of size n owns n-1 threads, created once. Start and completion are
+// signalled through two atomic counters (epoch, pending); threads spin
+// briefly and then sleep on a futex, so an idle pool costs no CPU and a
+// run() never takes a lock or allocates.
+class WorkerPool
+{
+public:
+    explicit WorkerPool(int size);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int size() const { return _size; }
+
+    template <class F>
+    void run(F& fn) { runImpl(&thunk<F>, &fn); }
+
+    // accumulated time spent inside fn per participant
+    uint64_t busyNs(int i) const { return _slots[i].busyNs; }
+
+private:
+    template <class F>
+    static void thunk(void* ctx, int i) { (*static_cast<F*>(ctx))(i); }
+
+    void runImpl(void (*fn)(void*, int), void* ctx);
+    void workerLoop(int index);
+
+    struct alignas(64) Slot
+    {
+        uint64_t busyNs = 0;
+    };
+
+    int _size;
+    std::vector<std::thread> _threads;
+    std::vector<Slot> _slots;
+
+    void (*_fn)(void*, int) = nullptr;
+    void* _ctx = nullptr;
+
+    std::atomic<uint32_t> _epoch{0};        // bumped once per run()
+    std::atomic<uint32_t> _pending{0};      // workers still busy in this run
+    std::atomic<uint32_t> _sleepers{0};     // workers blocked on _epoch
+    std::atomic<uint32_t> _callerWaiting{0};
+    std::atomic<bool> _stop{false};
+};
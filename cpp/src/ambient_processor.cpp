@@ -0,0 +1,526 @@
+// cpp/src/ambient_processor.cpp
+#include "ambient_processor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+
+#include "downscale.h"
+
+static_assert(sizeof(RGB) == 3, "RGB must be tightly packed");
+
+
+static inline const uint8_t* bytes(const std::vector<RGB>& v) {
+    return reinterpret_cast<const uint8_t*>(v.data());
+}
+
+static inline uint8_t* bytes(std::vector<RGB>& v) {
+    return reinterpret_cast<uint8_t*>(v.data());
+}
+
+// -----------------------------
+// AmbientProcessor Implementation
+// -----------------------------
+AmbientProcessor::AmbientProcessor(int ledCount)
+    : _ledCount(std::max(1, ledCount))
+{
+    _raw.assign(_ledCount, RGB());
+    _check.assign(_ledCount, RGB());
+    _histArena.assign(HIST_BINS, 0);
+    _touchedArena.assign(HIST_BINS, 0);
+    _smoothed.assign(_ledCount, RGB());
+    _output.assign(_ledCount, RGB());
+    _state.assign(static_cast<size_t>(_ledCount) * 3, 0.0f);
+}
+
+void AmbientProcessor::setSmoothingTime(float tauMs) {
+    _smoothingMs = std::clamp(tauMs, 0.0f, MAX_SMOOTHING_MS);
+}
+
+void AmbientProcessor::setBrightness(float b) {
+    _brightness = std::clamp(b, 0.0f, 1.0f);
+}
+
+void AmbientProcessor::setAdaptiveSmoothing(float fastTauMs, const AdaptiveSmoothing& params) {
+    _smoothingFastMs = std::clamp(fastTauMs, 0.0f, MAX_SMOOTHING_MS);
+    _adaptive = params;
+}
+
+void AmbientProcessor::setBorderDetection(bool enabled) {
+    _borderDetection = enabled;
+    _border.reset();
+}
+
+// -----------------------------
+// Region map (rebuilt only when the frame size, crop or downscale changes)
+// -----------------------------
+void AmbientProcessor::buildRegions(int frameWidth, int frameHeight, const Crop& crop, RegionMap& map) const {
+    map.width = frameWidth;
+    map.height = frameHeight;
+    map.crop = crop;
+    map.regions.assign(_ledCount, Region{0, 0, 1, 1});
+
+    // picture area inside the black bars
+    const int ox = crop.left;
+    const int oy = crop.top;
+    const int width = std::max(1, frameWidth - crop.left - crop.right);
+    const int height = std::max(1, frameHeight - crop.top - crop.bottom);
+
+    // LEDs per side proportional to the side length
+    int top = static_cast<int>(std::lround(_ledCount * width / (2.0 * (width + height))));
+    top = std::clamp(top, 0, _ledCount / 2);
+    const int bottom = top;
+    const int left = (_ledCount - top - bottom) / 2;
+    const int right = _ledCount - top - bottom - left;
+
+    const int dx = std::max(1, static_cast<int>(width * _depth));
+    const int dy = std::max(1, static_cast<int>(height * _depth));
+
+    auto span = [](int i, int n, int len, int& a, int& b) {
+        a = std::min(len - 1, static_cast<int>(static_cast<long>(i) * len / n));
+        b = std::max(a + 1, static_cast<int>(static_cast<long>(i + 1) * len / n));
+    };
+
+    auto& regions = map.regions;
+    int led = 0;
+    for (int i = 0; i < top; ++i, ++led) {
+        Region& r = regions[led];
+        span(i, top, width, r.x0, r.x1);
+        r.y0 = 0;
+        r.y1 = dy;
+    }
+    for (int i = 0; i < right; ++i, ++led) {
+        Region& r = regions[led];
+        span(i, right, height, r.y0, r.y1);
+        r.x0 = width - dx;
+        r.x1 = width;
+    }
+    for (int i = 0; i < bottom; ++i, ++led) {
+        Region& r = regions[led];
+        span(bottom - 1 - i, bottom, width, r.x0, r.x1);
+        r.y0 = height - dy;
+        r.y1 = height;
+    }
+    for (int i = 0; i < left; ++i, ++led) {
+        Region& r = regions[led];
+        span(left - 1 - i, left, height, r.y0, r.y1);
+        r.x0 = 0;
+        r.x1 = dx;
+    }
+
+    for (Region& r : regions) {
+        r.x0 += ox; r.x1 += ox;
+        r.y0 += oy; r.y1 += oy;
+    }
+
+    // bands cover every pixel some region reads; the side bands skip the
+    // corner rows already covered by the top/bottom bands
+    const int sy0 = top > 0 ? dy : 0;
+    const int sy1 = bottom > 0 ? height - dy : height;
+    map.bands[0] = top > 0    ? Region{ox, oy, ox + width, oy + dy} : Region{0, 0, 0, 0};
+    map.bands[1] = right > 0  ? Region{ox + width - dx, oy + sy0, ox + width, oy + sy1} : Region{0, 0, 0, 0};
+    map.bands[2] = bottom > 0 ? Region{ox, oy + height - dy, ox + width, oy + height} : Region{0, 0, 0, 0};
+    map.bands[3] = left > 0   ? Region{ox, oy + sy0, ox + dx, oy + sy1} : Region{0, 0, 0, 0};
+}
+
+// -----------------------------
+// Downscale pre-stage
+// -----------------------------
+// Largest factor that still leaves MIN_SAMPLES_PER_LED samples in an
+// average region, so dense strips on small frames stay at full resolution.
+static constexpr int MIN_SAMPLES_PER_LED = 64;
+static constexpr int DOWNSCALE_CHECK_INTERVAL = 120;  // frames between full-res checks
+
+int AmbientProcessor::chooseDownscale(int width, int height) const {
+    if (_downscale >= 1) return std::min(_downscale, _downscaleCap);
+
+    const double dx = width * _depth, dy = height * _depth;
+    const double bandArea = 2.0 * width * dy + 2.0 * height * dx;
+    const double perLed = bandArea / _ledCount;
+    int factor = 1;
+    while (factor < _downscaleCap && perLed / (4.0 * factor * factor) >= MIN_SAMPLES_PER_LED) factor *= 2;
+    return factor;
+}
+
+void AmbientProcessor::downscaleBands(const uint8_t* frame, int width, int factor) {
+    int rows = 0;
+    for (const Region& band : _smallMap.bands) rows += band.y1 - band.y0;
+
+    if (!_pool) {
+        downscaleRows(frame, width, factor, 0, rows);
+        return;
+    }
+    const int n = _pool->size();
+    auto job = [&](int w) { downscaleRows(frame, width, factor, rows * w / n, rows * (w + 1) / n); };
+    _pool->run(job);
+}
+
+// band rows [begin, end), counted across all four bands
+void AmbientProcessor::downscaleRows(const uint8_t* frame, int width, int factor, int begin, int end) {
+    const size_t srcStride = static_cast<size_t>(width) * 3;
+    const size_t dstStride = static_cast<size_t>(_smallMap.width) * 3;
+    int row = 0;
+    for (const Region& band : _smallMap.bands) {
+        const int h = band.y1 - band.y0;
+        const int from = std::max(begin - row, 0), to = std::min(end - row, h);
+        row += h;
+        for (int y = band.y0 + from; y < band.y0 + to; ++y) {
+            // one source row per block: the middle one
+            const uint8_t* src = frame + (static_cast<size_t>(y) * factor + factor / 2) * srcStride
+                                 + static_cast<size_t>(band.x0) * factor * 3;
+            uint8_t* dst = _small.data() + y * dstStride + static_cast<size_t>(band.x0) * 3;
+            if (_mode == ReduceMode::Dominant) pointSampleRow(src, dst, band.x1 - band.x0, factor);
+            else boxFilterRow(src, dst, band.x1 - band.x0, factor);
+        }
+    }
+}
+
+void AmbientProcessor::setDownscale(int factor) {
+    _downscale = (factor == 2 || factor == 4 || factor == 8 || factor == 1) ? factor : 0;
+    _downscaleCap = 8;
+}
+
+void AmbientProcessor::setReduceMode(ReduceMode mode) {
+    _mode = mode;
+    _map.width = 0;     // force a rebuild (sample offsets)
+}
+
+static int clampSampleGrid(int n) { return std::clamp(n, 1, 16); }
+
+void AmbientProcessor::setSampleGrid(int samplesX, int samplesY) {
+    _samplesX = clampSampleGrid(samplesX);
+    _samplesY = clampSampleGrid(samplesY);
+    _map.width = 0;
+}
+
+// -----------------------------
+// Sample mode: fixed grid of cell centers per region, as byte offsets
+// -----------------------------
+void AmbientProcessor::buildSampleOffsets(RegionMap& map, int samplesX, int samplesY) const {
+    map.samplesPerRegion = samplesX * samplesY;
+    map.samples.resize(static_cast<size_t>(_ledCount) * map.samplesPerRegion);
+    uint32_t* out = map.samples.data();
+    for (const Region& r : map.regions) {
+        const int w = r.x1 - r.x0, h = r.y1 - r.y0;
+        for (int j = 0; j < samplesY; ++j) {
+            const int y = r.y0 + (2 * j + 1) * h / (2 * samplesY);
+            for (int i = 0; i < samplesX; ++i) {
+                const int x = r.x0 + (2 * i + 1) * w / (2 * samplesX);
+                *out++ = static_cast<uint32_t>((static_cast<size_t>(y) * map.width + x) * 3);
+            }
+        }
+    }
+}
+
+void AmbientProcessor::sampleColors(const uint8_t* frame, const RegionMap& map, std::vector<RGB>& out,
+                                    int begin, int end) const {
+    const int n = map.samplesPerRegion;
+    const uint32_t* off = map.samples.data() + static_cast<size_t>(begin) * n;
+    for (int i = begin; i < end; ++i, off += n) {
+        uint32_t sr = 0, sg = 0, sb = 0;
+        for (int k = 0; k < n; ++k) {
+            const uint8_t* p = frame + off[k];
+            sr += p[0];
+            sg += p[1];
+            sb += p[2];
+        }
+        out[i] = RGB(static_cast<uint8_t>((sr + n / 2) / n),
+                     static_cast<uint8_t>((sg + n / 2) / n),
+                     static_cast<uint8_t>((sb + n / 2) / n));
+    }
+}
+
+// -----------------------------
+// Parallel reduction
+// -----------------------------
+void AmbientProcessor::setThreads(int n) {
+    n = std::clamp(n, 1, 16);
+    if (n == 1) _pool.reset();
+    else if (!_pool || _pool->size() != n) _pool = std::make_unique<WorkerPool>(n);
+    _histArena.assign(static_cast<size_t>(n) * HIST_BINS, 0);
+    _touchedArena.assign(static_cast<size_t>(n) * HIST_BINS, 0);
+    _stats.workerNs.assign(n > 1 ? n : 0, 0);
+}
+
+// calling thread: buildRegions/buildSampleOffsets only read _ledCount and
+// _depth, fixed since construction. If the size or crop moves before the
+// settings are applied, processFrame rebuilds the map as for any move.
+void AmbientProcessor::queueSettings(const Settings& settings) {
+    auto pending = std::make_shared<PendingSettings>();
+    pending->settings = settings;
+    const Stats last = stats();
+    if (last.width > 0) {
+        buildRegions(last.width, last.height, last.crop, pending->map);
+        if (settings.mode == ReduceMode::Sample) {
+            buildSampleOffsets(pending->map, clampSampleGrid(settings.samplesX),
+                               clampSampleGrid(settings.samplesY));
+        }
+    }
+    std::atomic_store(&_pending, pending);
+    _hasPending.store(true, std::memory_order_release);
+}
+
+// processing thread, between frames
+void AmbientProcessor::applySettings(PendingSettings& pending) {
+    const Settings& s = pending.settings;
+    setSmoothingTime(s.smoothingMs);
+    setBrightness(s.brightness);
+    setAdaptiveSmoothing(s.smoothingFastMs, s.adaptive);
+    if (s.borderDetection != _borderDetection) setBorderDetection(s.borderDetection);
+    if (s.downscale != _downscale) setDownscale(s.downscale);
+    if (s.mode != _mode) setReduceMode(s.mode);
+    if (s.samplesX != _samplesX || s.samplesY != _samplesY) setSampleGrid(s.samplesX, s.samplesY);
+    if (s.threads != (_pool ? _pool->size() : 1)) setThreads(s.threads);
+    // mode or grid changed: take the prebuilt map instead of rebuilding
+    if (_map.width == 0) _map = std::move(pending.map);
+}
+
+// LED ranges of roughly equal cost (region area; constant in Sample mode),
+// so workers holding the long top/bottom regions do not lag behind
+void AmbientProcessor::balanceRanges(const RegionMap& map, int workers) {
+    _ranges.assign(workers + 1, _ledCount);
+    _ranges[0] = 0;
+
+    auto cost = [&](int i) -> uint64_t {
+        if (_mode == ReduceMode::Sample) return 1;
+        const Region& r = map.regions[i];
+        return static_cast<uint64_t>(r.x1 - r.x0) * (r.y1 - r.y0);
+    };
+    uint64_t total = 0;
+    for (int i = 0; i < _ledCount; ++i) total += cost(i);
+
+    uint64_t acc = 0;
+    int w = 1;
+    for (int i = 0; i < _ledCount && w < workers; ++i) {
+        acc += cost(i);
+        while (w < workers && acc * workers >= total * w) _ranges[w++] = i + 1;
+    }
+}
+
+void AmbientProcessor::reduceRange(const uint8_t* frame, const RegionMap& map, std::vector<RGB>& out,
+                                   int begin, int end, int worker) {
+    switch (_mode) {
+        case ReduceMode::Sample:
+            sampleColors(frame, map, out, begin, end);
+            break;
+        case ReduceMode::Dominant: {
+            uint16_t* hist = _histArena.data() + static_cast<size_t>(worker) * HIST_BINS;
+            uint16_t* touched = _touchedArena.data() + static_cast<size_t>(worker) * HIST_BINS;
+            for (int i = begin; i < end; ++i) out[i] = dominantSegment(frame, map.width, map.regions[i], hist, touched);
+            break;
+        }
+        case ReduceMode::Mean:
+            for (int i = begin; i < end; ++i) out[i] = averageSegment(frame, map.width, map.regions[i]);
+            break;
+    }
+}
+
+void AmbientProcessor::computeColors(const uint8_t* frame, const RegionMap& map, std::vector<RGB>& out) {
+    if (!_pool) {
+        reduceRange(frame, map, out, 0, _ledCount, 0);
+        return;
+    }
+    balanceRanges(map, _pool->size());
+    auto job = [&](int w) { reduceRange(frame, map, out, _ranges[w], _ranges[w + 1], w); };
+    _pool->run(job);
+}
+
+// -----------------------------
+// Mean color of one region
+// -----------------------------
+RGB AmbientProcessor::averageSegment(const uint8_t* frame, int width, const Region& reg) const {
+    uint32_t sr = 0, sg = 0, sb = 0;
+    const size_t stride = static_cast<size_t>(width) * 3;
+    for (int y = reg.y0; y < reg.y1; ++y) {
+        const uint8_t* p = frame + y * stride + static_cast<size_t>(reg.x0) * 3;
+        for (int x = reg.x0; x < reg.x1; ++x, p += 3) {
+            sr += p[0];
+            sg += p[1];
+            sb += p[2];
+        }
+    }
+    const uint32_t n = static_cast<uint32_t>((reg.x1 - reg.x0) * (reg.y1 - reg.y0));
+    if (n == 0) return RGB();
+    return RGB(static_cast<uint8_t>((sr + n / 2) / n),
+               static_cast<uint8_t>((sg + n / 2) / n),
+               static_cast<uint8_t>((sb + n / 2) / n));
+}
+
+// -----------------------------
+// Dominant color of one region: most populated 4-4-4 bin, then the mean of
+// the pixels in that bin (so the result is not quantized to the bin center)
+// -----------------------------
+static inline uint16_t colorBin(const uint8_t* p) {
+    return static_cast<uint16_t>(((p[0] >> 4) << 8) | ((p[1] >> 4) << 4) | (p[2] >> 4));
+}
+
+RGB AmbientProcessor::dominantSegment(const uint8_t* frame, int width, const Region& reg,
+                                      uint16_t* hist, uint16_t* touched) const {
+    const size_t stride = static_cast<size_t>(width) * 3;
+    int nTouched = 0;
+    uint16_t best = 0, bestCount = 0;
+
+    for (int y = reg.y0; y < reg.y1; ++y) {
+        const uint8_t* p = frame + y * stride + static_cast<size_t>(reg.x0) * 3;
+        for (int x = reg.x0; x < reg.x1; ++x, p += 3) {
+            const uint16_t bin = colorBin(p);
+            uint16_t& c = hist[bin];
+            if (c == 0) touched[nTouched++] = bin;
+            if (c < UINT16_MAX) ++c;
+            if (c > bestCount) {
+                bestCount = c;
+                best = bin;
+            }
+        }
+    }
+    for (int i = 0; i < nTouched; ++i) hist[touched[i]] = 0;
+    if (bestCount == 0) return RGB();
+
+    uint32_t sr = 0, sg = 0, sb = 0, n = 0;
+    for (int y = reg.y0; y < reg.y1; ++y) {
+        const uint8_t* p = frame + y * stride + static_cast<size_t>(reg.x0) * 3;
+        for (int x = reg.x0; x < reg.x1; ++x, p += 3) {
+            if (colorBin(p) != best) continue;
+            sr += p[0];
+            sg += p[1];
+            sb += p[2];
+            ++n;
+        }
+    }
+    return RGB(static_cast<uint8_t>((sr + n / 2) / n),
+               static_cast<uint8_t>((sg + n / 2) / n),
+               static_cast<uint8_t>((sb + n / 2) / n));
+}
+
+// -----------------------------
+// Adaptive temporal filter: EMA with a time constant, alpha from the time
+// since the previous frame (smoothing.h). The change metric (mean abs
+// difference to the current output) picks the response: full time
+// constant, the fast attack one or reset (cut).
+// -----------------------------
+void AmbientProcessor::smooth(uint64_t dtNs) {
+    const size_t n = static_cast<size_t>(_ledCount) * 3;
+    const uint8_t* raw = bytes(_raw);
+
+    const uint32_t sad = sumAbsDiff(raw, bytes(_smoothed), n);
+    const SmoothingResponse response = classifyChange(static_cast<float>(sad) / n, _adaptive);
+
+    float tau = _smoothingMs;
+    if (response == SmoothingResponse::Snap || _stats.frames == 0) {
+        // nothing from before the cut fades in
+        tau = 0.0f;
+        if (_stats.frames > 0) ++_stats.cuts;
+    } else if (response == SmoothingResponse::Fast) {
+        tau = std::min(tau, _smoothingFastMs);
+        ++_stats.fastFrames;
+    }
+    const float a = emaAlpha(dtNs, tau);
+
+    float* state = _state.data();
+    uint8_t* out = bytes(_smoothed);
+    for (size_t i = 0; i < n; ++i) {
+        state[i] += a * (static_cast<float>(raw[i]) - state[i]);
+        out[i] = static_cast<uint8_t>(state[i] + 0.5f);
+    }
+}
+
+// -----------------------------
+// Frame -> LED colors
+// -----------------------------
+const std::vector<RGB>& AmbientProcessor::processFrame(const uint8_t* frameData, int width, int height,
+                                                       uint64_t timestampNs) {
+    if (!frameData || width <= 0 || height <= 0) return _output;
+
+    if (_hasPending.load(std::memory_order_acquire) && _hasPending.exchange(false)) {
+        if (auto pending = std::atomic_exchange(&_pending, std::shared_ptr<PendingSettings>())) {
+            applySettings(*pending);
+        }
+    }
+
+    using clock = std::chrono::steady_clock;
+    const auto t0 = clock::now();
+
+    if (_borderDetection && _border.update(frameData, width, height)) ++_stats.cropChanges;
+    const Crop crop = _borderDetection ? _border.crop() : Crop{};
+    const auto t1 = clock::now();
+
+    if (width != _map.width || height != _map.height || crop != _map.crop) {
+        buildRegions(width, height, crop, _map);
+        if (_mode == ReduceMode::Sample) buildSampleOffsets(_map, _samplesX, _samplesY);
+        ++_stats.mapBuilds;
+    }
+
+    const int factor = _mode == ReduceMode::Sample ? 1 : chooseDownscale(width, height);
+    if (_mode == ReduceMode::Sample) {
+        computeColors(frameData, _map, _raw);
+    } else if (factor > 1) {
+        const int sw = width / factor, sh = height / factor;
+        const Crop sc{crop.top / factor, crop.bottom / factor, crop.left / factor, crop.right / factor};
+        if (sw != _smallMap.width || sh != _smallMap.height || sc != _smallMap.crop) {
+            buildRegions(sw, sh, sc, _smallMap);
+            _small.assign(static_cast<size_t>(sw) * sh * 3, 0);
+        }
+        downscaleBands(frameData, width, factor);
+        computeColors(_small.data(), _smallMap, _raw);
+
+        // keep the downscaled result within _maxDownscaleError of the full
+        // resolution one; step the factor down if content breaks the bound
+        if (_mode == ReduceMode::Mean && _stats.frames % DOWNSCALE_CHECK_INTERVAL == 0) {
+            computeColors(frameData, _map, _check);
+            const uint8_t* a = bytes(_raw);
+            const uint8_t* b = bytes(_check);
+            int err = 0;
+            for (size_t i = 0; i < static_cast<size_t>(_ledCount) * 3; ++i) {
+                err = std::max(err, std::abs(static_cast<int>(a[i]) - static_cast<int>(b[i])));
+            }
+            _stats.downscaleError = err;
+            ++_stats.downscaleChecks;
+            if (err > _maxDownscaleError) {
+                _downscaleCap = std::max(1, factor / 2);
+                _raw = _check;
+            }
+        }
+    } else {
+        computeColors(frameData, _map, _raw);
+    }
+    _stats.downscale = factor;
+
+    // first frame and gaps: see MAX_SMOOTHING_STEP_NS
+    if (timestampNs == 0) {
+        timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(t0.time_since_epoch()).count();
+    }
+    uint64_t dt = 1000000000ull / SMOOTHING_REFERENCE_HZ;
+    if (_lastNs && timestampNs > _lastNs) dt = std::min(timestampNs - _lastNs, MAX_SMOOTHING_STEP_NS);
+    _lastNs = timestampNs;
+    smooth(dt);
+    ++_stats.frames;
+
+    const uint32_t scale = static_cast<uint32_t>(_brightness * 256.0f + 0.5f);
+    const uint8_t* src = bytes(_smoothed);
+    uint8_t* dst = bytes(_output);
+    for (size_t i = 0; i < static_cast<size_t>(_ledCount) * 3; ++i) {
+        dst[i] = static_cast<uint8_t>((src[i] * scale) >> 8);
+    }
+
+    const auto t2 = clock::now();
+    _stats.crop = crop;
+    _stats.width = width;
+    _stats.height = height;
+    _stats.borderNs += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    _stats.processNs += std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t0).count();
+    if (_pool) {
+        for (int i = 0; i < _pool->size(); ++i) _stats.workerNs[i] = _pool->busyNs(i);
+    }
+    {
+        // other threads only see whole frames; the copy reuses _published's storage
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        _published = _stats;
+    }
+    return _output;
+}
+
+AmbientProcessor::Stats AmbientProcessor::stats() const {
+    std::lock_guard<std::mutex> lock(_statsMutex);
+    return _published;
+}
@@ -0,0 +1,247 @@
+// cpp/src/audio_reactive.cpp
+#include "audio_reactive.h"
+#include "frame_source.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+AudioReactive::AudioReactive(FrameTarget& target, std::unique_ptr<AudioSource> source, const Settings& settings)
+    : _target(target),
+      _source(std::move(source)),
+      _fft(settings.fftSize),
+      _hop(settings.fftSize / 2),
+      _bands(std::max(1, settings.bands)),
+      _hopSeconds(static_cast<float>(_hop) / _source->sampleRate())
+{
+    const int n = _fft.size();
+    const int rate = _source->sampleRate();
+    _samples.assign(n, 0.0f);
+    _windowed.assign(n, 0.0f);
+    _power.assign(_fft.bins(), 0.0f);
+    _hann.resize(n);
+    for (int i = 0; i < n; ++i) {
+        _hann[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * M_PI * i / n));
+    }
+
+    // log spaced band edges, at least one bin each, DC skipped
+    const float top = std::min(MAX_HZ, 0.5f * rate);
+    const float binHz = static_cast<float>(rate) / n;
+    _bandLo.resize(_bands);
+    _bandHi.resize(_bands);
+    for (int b = 0; b < _bands; ++b) {
+        const float lo = MIN_HZ * std::pow(top / MIN_HZ, static_cast<float>(b) / _bands);
+        const float hi = MIN_HZ * std::pow(top / MIN_HZ, static_cast<float>(b + 1) / _bands);
+        _bandLo[b] = std::min(_fft.bins() - 1, std::max(1, static_cast<int>(lo / binHz)));
+        _bandHi[b] = std::min(_fft.bins(), std::max(_bandLo[b] + 1, static_cast<int>(hi / binHz)));
+    }
+    _bandDb.assign(_bands, FLOOR_DB);
+    _prevDb.assign(_bands, FLOOR_DB);
+    _level.assign(_bands + 1, 0.0f);
+    _flux.assign(std::max(4, static_cast<int>(std::ceil(1.0f / _hopSeconds))), 0.0f);
+
+    // per hop coefficients of the time constants
+    _attack = 1.0f - std::exp(-_hopSeconds / ATTACK_S);
+    _release = 1.0f - std::exp(-_hopSeconds / RELEASE_S);
+    _flashDecay = std::exp(-_hopSeconds / FLASH_S);
+    _peakDecay = PEAK_DECAY_DB * _hopSeconds;
+    _beatHold = static_cast<int>(std::ceil(BEAT_HOLD_S / _hopSeconds));
+    _sinceBeat = _beatHold;
+
+    const int leds = target.numLeds();
+    _ledBand.assign(leds, 0);
+    _ledFrac.assign(leds, 0.0f);
+    _ledColor.assign(static_cast<size_t>(leds) * 3, 0.0f);
+    _frame.assign(leds, RGB{0, 0, 0});
+    if (settings.segments.empty()) {
+        mapSegment(0, leds, false);
+    } else {
+        for (const LedSegment& s : settings.segments) mapSegment(s.start, s.count, s.reversed);
+    }
+}
+
+AudioReactive::~AudioReactive() {
+    stop();
+}
+
+// bass at the start (end if reversed): red -> green -> blue
+void AudioReactive::mapSegment(int start, int count, bool reversed) {
+    const int leds = static_cast<int>(_frame.size());
+    start = std::max(0, start);
+    count = std::min(count, leds - start);
+    for (int j = 0; j < count; ++j) {
+        const float x = (j + 0.5f) / count;
+        const float pos = std::min(std::max(x * _bands - 0.5f, 0.0f), static_cast<float>(_bands - 1));
+        const int i = start + (reversed ? count - 1 - j : j);
+        _ledBand[i] = static_cast<uint16_t>(pos);
+        _ledFrac[i] = pos - _ledBand[i];
+        _ledColor[i * 3 + 0] = 255.0f * std::max(0.0f, 1.0f - 2.0f * x);
+        _ledColor[i * 3 + 1] = 255.0f * (1.0f - std::fabs(2.0f * x - 1.0f));
+        _ledColor[i * 3 + 2] = 255.0f * std::max(0.0f, 2.0f * x - 1.0f);
+    }
+}
+
+bool AudioReactive::start() {
+    stop();
+    _source->resume();
+    _stopping = false;
+    _thread = std::thread(&AudioReactive::loop, this);
+    pthread_setname_np(_thread.native_handle(), "amb-audio");
+    return true;
+}
+
+void AudioReactive::stop() {
+    if (_thread.joinable()) {
+        _stopping = true;
+        _source->interrupt();
+        _thread.join();
+    }
+}
+
+AudioReactive::Stats AudioReactive::stats() const {
+    Stats s;
+    s.blocks = _blocks.load(std::memory_order_relaxed);
+    s.frames = _frames.load(std::memory_order_relaxed);
+    s.beats = _beats.load(std::memory_order_relaxed);
+    s.processNs = _processNs.load(std::memory_order_relaxed);
+    s.maxProcessNs = _maxProcessNs.load(std::memory_order_relaxed);
+    s.latencyNs = _latencyNs.load(std::memory_order_relaxed);
+    s.maxLatencyNs = _maxLatencyNs.load(std::memory_order_relaxed);
+    s.windowMs = 1000.0 * _hop / _source->sampleRate();
+    s.levelDb = _levelDb.load(std::memory_order_relaxed);
+    s.active = _activeFlag.load(std::memory_order_relaxed);
+    return s;
+}
+
+void AudioReactive::record(std::atomic<uint64_t>& sum, std::atomic<uint64_t>& max, uint64_t ns) {
+    sum.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > max.load(std::memory_order_relaxed)) max.store(ns, std::memory_order_relaxed);
+}
+
+// -----------------------------
+// Audio-Thread
+// -----------------------------
+void AudioReactive::loop() {
+    const int n = _fft.size();
+    const uint64_t hopNs = static_cast<uint64_t>(_hopSeconds * 1e9f);
+    for (;;) {
+        // slide the window by one hop, new samples go to the end
+        std::copy(_samples.begin() + _hop, _samples.end(), _samples.begin());
+        float* fresh = _samples.data() + n - _hop;
+        uint64_t captureNs = 0;
+        if (!_source->read(fresh, _hop, captureNs)) {
+            if (!_stopping) std::cout << "[Audio] end of input" << std::endl;
+            break;
+        }
+        const uint64_t t0 = monotonicNs();
+
+        float sumSq = 0.0f;
+        for (int i = 0; i < _hop; ++i) sumSq += fresh[i] * fresh[i];
+        const float levelDb = 10.0f * std::log10(sumSq / _hop + 1e-12f);
+        _levelDb.store(levelDb, std::memory_order_relaxed);
+        _silentNs = levelDb < SILENCE_DB ? _silentNs + hopNs : 0;
+        const bool active = _silentNs < SILENCE_NS;
+        if (active != _active) {
+            _active = active;
+            _activeFlag.store(active, std::memory_order_relaxed);
+            if (!active) _target.release();
+        }
+
+        analyze();
+        if (active) render();
+        const uint64_t t1 = monotonicNs();
+        _blocks.fetch_add(1, std::memory_order_relaxed);
+        record(_processNs, _maxProcessNs, t1 - t0);
+        if (!active) continue;
+
+        _target.submitFrame(_frame);
+        _frames.fetch_add(1, std::memory_order_relaxed);
+        const uint64_t done = monotonicNs();
+        record(_latencyNs, _maxLatencyNs, done > captureNs ? done - captureNs : 0);
+    }
+    if (_active) {
+        _active = false;
+        _activeFlag.store(false, std::memory_order_relaxed);
+        _target.release();
+    }
+}
+
+void AudioReactive::analyze() {
+    const int n = _fft.size();
+    for (int i = 0; i < n; ++i) _windowed[i] = _samples[i] * _hann[i];
+    _fft.power(_windowed.data(), _power.data());
+
+    // a full scale sine peaks at (n/4)^2 with the Hann window -> 0 dB
+    const float norm = 16.0f / (static_cast<float>(n) * n);
+    float loudest = FLOOR_DB;
+    for (int b = 0; b < _bands; ++b) {
+        float e = 0.0f;
+        for (int k = _bandLo[b]; k < _bandHi[b]; ++k) e += _power[k];
+        _bandDb[b] = 10.0f * std::log10(e * norm + 1e-12f);
+        loudest = std::max(loudest, _bandDb[b]);
+    }
+
+    // automatic gain: the peak jumps up and decays slowly
+    _peakDb = std::max(loudest, _peakDb - _peakDecay);
+    const float bottom = _peakDb - RANGE_DB;
+
+    float flux = 0.0f;
+    for (int b = 0; b < _bands; ++b) {
+        const float db = std::max(_bandDb[b], bottom);       // no flux from noise under the range
+        flux += std::max(0.0f, db - _prevDb[b]);
+        _prevDb[b] = db;
+        const float target = (db - bottom) / RANGE_DB;
+        _level[b] += (target - _level[b]) * (target > _level[b] ? _attack : _release);
+    }
+    _level[_bands] = _level[_bands - 1];
+
+    _flash *= _flashDecay;
+    if (detectBeat(flux)) {
+        _flash = 1.0f;
+        _beats.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// flux above mean + K stddev of the last second (once half of it is known)
+bool AudioReactive::detectBeat(float flux) {
+    bool beat = false;
+    if (_sinceBeat < _beatHold) ++_sinceBeat;
+    if (_fluxCount >= _flux.size() / 2) {
+        const double mean = _fluxSum / _fluxCount;
+        const double var = std::max(0.0, _fluxSumSq / _fluxCount - mean * mean);
+        beat = flux > mean + BEAT_K * std::sqrt(var) && flux > BEAT_MIN_FLUX &&
+               _sinceBeat >= _beatHold;
+    }
+    if (beat) _sinceBeat = 0;
+
+    if (_fluxCount == _flux.size()) {
+        _fluxSum -= _flux[_fluxPos];
+        _fluxSumSq -= static_cast<double>(_flux[_fluxPos]) * _flux[_fluxPos];
+    } else {
+        ++_fluxCount;
+    }
+    _flux[_fluxPos] = flux;
+    _fluxSum += flux;
+    _fluxSumSq += static_cast<double>(flux) * flux;
+    _fluxPos = (_fluxPos + 1) % _flux.size();
+    return beat;
+}
+
+void AudioReactive::render() {
+    const size_t leds = _frame.size();
+    const float flash = 0.6f * _flash;
+    for (size_t i = 0; i < leds; ++i) {
+        const int b = _ledBand[i];
+        const float level = _level[b] + (_level[b + 1] - _level[b]) * _ledFrac[i];
+        const float* c = &_ledColor[i * 3];
+        const float f = (c[0] + c[1] + c[2] > 0.0f) ? flash : 0.0f;   // LEDs outside all segments stay dark
+        uint8_t out[3];
+        for (int k = 0; k < 3; ++k) {
+            const float v = c[k] * level;
+            out[k] = static_cast<uint8_t>(std::min(255.0f, v + (255.0f - v) * f) + 0.5f);
+        }
+        _frame[i] = RGB{out[0], out[1], out[2]};
+    }
+}
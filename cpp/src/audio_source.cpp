@@ -0,0 +1,230 @@
+// cpp/src/audio_source.cpp
+#include "audio_source.h"
+#include "frame_source.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+// -----------------------------
+// Hilfsfunktionen
+// -----------------------------
+static inline uint16_t le16(const uint8_t* p) { return uint16_t(p[0] | (p[1] << 8)); }
+static inline uint32_t le32(const uint8_t* p) { return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24; }
+
+static bool endsWith(const std::string& s, const char* ext) {
+    const size_t n = std::strlen(ext);
+    return s.size() >= n && s.compare(s.size() - n, n, ext) == 0;
+}
+
+// -----------------------------
+// WavSource Implementation
+// -----------------------------
+WavSource::WavSource(const std::string& path, bool loop)
+    : _loop(loop)
+{
+    if (path == "-") {
+        _fd = STDIN_FILENO;
+    } else {
+        _fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (_fd < 0) {
+            perror(("open " + path).c_str());
+            throw std::runtime_error("Failed to open WAV file: " + path);
+        }
+        _ownsFd = true;
+    }
+    struct stat st{};
+    _regular = fstat(_fd, &st) == 0 && S_ISREG(st.st_mode);
+
+    std::string error;
+    if (!readHeader(error)) {
+        if (_ownsFd) close(_fd);
+        throw std::runtime_error(path + ": " + error);
+    }
+    if (_regular) {
+        _dataStart = lseek(_fd, 0, SEEK_CUR);
+        // a header written before the length was known says 0 or ~0
+        const uint64_t rest = static_cast<uint64_t>(st.st_size - _dataStart);
+        if (_dataBytes == 0 || _dataBytes > rest) _dataBytes = rest;
+        // whole frames only: a looped file without one would never fill read()
+        const uint64_t frameBytes = static_cast<uint64_t>(_channels) * (_float ? 4 : 2);
+        _dataBytes -= _dataBytes % frameBytes;
+        if (_dataBytes == 0) {
+            if (_ownsFd) close(_fd);
+            throw std::runtime_error(path + ": no samples");
+        }
+    }
+}
+
+WavSource::~WavSource() {
+    if (_ownsFd && _fd >= 0) close(_fd);
+}
+
+bool WavSource::readFully(void* buf, size_t n) {
+    uint8_t* p = static_cast<uint8_t*>(buf);
+    while (n > 0) {
+        if (interrupted()) return false;
+        // pipes: sliced waits in poll(), then a read that can't block. The fd
+        // stays blocking, O_NONBLOCK on a shared stdin would leak to the
+        // parent's tty or pipe
+        if (!_regular) {
+            pollfd pfd{ _fd, POLLIN, 0 };
+            if (poll(&pfd, 1, WAIT_SLICE_MS) <= 0) continue;
+        }
+        const ssize_t r = ::read(_fd, p, n);
+        if (r > 0) {
+            p += r;
+            n -= static_cast<size_t>(r);
+        } else if (r == 0) {
+            return false;
+        } else if (errno != EINTR) {
+            perror("[Audio] read");
+            return false;
+        }
+    }
+    return true;
+}
+
+// pipes can't seek past chunks, so unknown chunks are read and dropped
+bool WavSource::skip(uint64_t n) {
+    uint8_t buf[256];
+    while (n > 0) {
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(n, sizeof(buf)));
+        if (!readFully(buf, chunk)) return false;
+        n -= chunk;
+    }
+    return true;
+}
+
+bool WavSource::readHeader(std::string& error) {
+    uint8_t riff[12];
+    if (!readFully(riff, sizeof(riff)) || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        error = "not a RIFF/WAVE file";
+        return false;
+    }
+    bool haveFormat = false;
+    for (;;) {
+        uint8_t chunk[8];
+        if (!readFully(chunk, sizeof(chunk))) {
+            error = "no data chunk";
+            return false;
+        }
+        const uint32_t size = le32(chunk + 4);
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[40] = {};
+            const uint32_t take = std::min<uint32_t>(size, sizeof(fmt));
+            if (size < 16 || !readFully(fmt, take) || !skip(size - take + (size & 1))) {
+                error = "bad fmt chunk";
+                return false;
+            }
+            uint16_t tag = le16(fmt);
+            if (tag == 0xFFFE && size >= 26) tag = le16(fmt + 24);   // WAVE_FORMAT_EXTENSIBLE subformat
+            _channels = le16(fmt + 2);
+            _rate = static_cast<int>(le32(fmt + 4));
+            const int bits = le16(fmt + 14);
+            if (tag == 1 && bits == 16) _float = false;
+            else if (tag == 3 && bits == 32) _float = true;
+            else {
+                error = "unsupported format (16 bit PCM or 32 bit float only)";
+                return false;
+            }
+            if (_channels < 1 || _rate < 1000) {
+                error = "bad channel count or sample rate";
+                return false;
+            }
+            haveFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                error = "data before fmt chunk";
+                return false;
+            }
+            _dataBytes = size == 0xFFFFFFFFu ? 0 : size;
+            return true;
+        } else if (!skip(size + (size & 1))) {
+            error = "truncated chunk";
+            return false;
+        }
+    }
+}
+
+bool WavSource::read(float* samples, size_t count, uint64_t& captureNs) {
+    const size_t frameBytes = static_cast<size_t>(_channels) * (_float ? 4 : 2);
+    _raw.resize(count * frameBytes);
+
+    size_t got = 0;
+    while (got < count) {
+        size_t want = count - got;
+        if (_dataBytes) {
+            if (_dataPos >= _dataBytes) {
+                if (!_regular || !_loop || lseek(_fd, _dataStart, SEEK_SET) < 0) return false;
+                _dataPos = 0;
+            }
+            want = std::min<uint64_t>(want, (_dataBytes - _dataPos) / frameBytes);
+            if (want == 0) {                  // partial trailing frame
+                _dataPos = _dataBytes;
+                continue;
+            }
+        }
+        if (!readFully(_raw.data() + got * frameBytes, want * frameBytes)) return false;
+        _dataPos += want * frameBytes;
+        got += want;
+    }
+
+    // downmix
+    const float scale = 1.0f / _channels;
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* p = _raw.data() + i * frameBytes;
+        float sum = 0.0f;
+        for (int c = 0; c < _channels; ++c) {
+            if (_float) {
+                float v;
+                std::memcpy(&v, p + c * 4, 4);
+                sum += v;
+            } else {
+                sum += static_cast<int16_t>(le16(p + c * 2)) * (1.0f / 32768.0f);
+            }
+        }
+        samples[i] = sum * scale;
+    }
+
+    if (!_regular) {
+        captureNs = monotonicNs();
+        return true;
+    }
+    // files play at their own rate: the newest sample is "captured" at
+    // start + played / rate, wait for that moment
+    if (_startNs == 0) _startNs = monotonicNs();
+    _played += count;
+    // whole seconds first, _played * 1e9 overflows after a few days of looping
+    const uint64_t rate = static_cast<uint64_t>(_rate);
+    captureNs = _startNs + _played / rate * 1000000000ull + _played % rate * 1000000000ull / rate;
+    for (;;) {
+        const uint64_t now = monotonicNs();
+        if (now >= captureNs) break;
+        if (interrupted()) return false;
+        const uint64_t wait = std::min<uint64_t>(captureNs - now, WAIT_SLICE_MS * 1000000ull);
+        timespec ts{ static_cast<time_t>(wait / 1000000000ull), static_cast<long>(wait % 1000000000ull) };
+        nanosleep(&ts, nullptr);
+    }
+    return true;
+}
+
+// -----------------------------
+// Factory
+// -----------------------------
+std::unique_ptr<AudioSource> openAudioSource(const std::string& device) {
+    struct stat st{};
+    const bool isFile = stat(device.c_str(), &st) == 0 && (S_ISREG(st.st_mode) || S_ISFIFO(st.st_mode));
+    if (device == "-" || endsWith(device, ".wav") || isFile) {
+        return std::make_unique<WavSource>(device, true);
+    }
+    throw std::runtime_error("audio device must be a WAV file, a pipe or \"-\": " + device);
+}
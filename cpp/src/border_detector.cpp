@@ -0,0 +1,135 @@
+// cpp/src/border_detector.cpp
+#include "border_detector.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+static constexpr int CHUNK_PX = 16;      // contiguous pixels per threshold test
+static constexpr int ROW_CHUNKS = 16;    // chunks sampled across a row
+static constexpr int SCAN_ROWS = 8;      // rows sampled for the pillarbox scan
+
+// max over n contiguous bytes > threshold; the max-reduction vectorizes
+static inline bool anyAbove(const uint8_t* p, int n, uint8_t threshold) {
+    uint8_t m = 0;
+    for (int i = 0; i < n; ++i) m = std::max(m, p[i]);
+    return m > threshold;
+}
+
+static inline bool pixelAbove(const uint8_t* p, uint8_t threshold) {
+    return p[0] > threshold || p[1] > threshold || p[2] > threshold;
+}
+
+void BorderDetector::reset() {
+    _applied = Crop{};
+    _candidate = Crop{};
+    _candidateFrames = 0;
+}
+
+bool BorderDetector::near(const Crop& a, const Crop& b) const {
+    const int t = _params.tolerance;
+    return std::abs(a.top - b.top) <= t && std::abs(a.bottom - b.bottom) <= t &&
+           std::abs(a.left - b.left) <= t && std::abs(a.right - b.right) <= t;
+}
+
+bool BorderDetector::rowIsBlack(const uint8_t* row, int width) const {
+    if (width <= CHUNK_PX * ROW_CHUNKS) return !anyAbove(row, width * 3, _params.threshold);
+    for (int i = 0; i < ROW_CHUNKS; ++i) {
+        const int x = static_cast<int>(static_cast<long>(i) * (width - CHUNK_PX) / (ROW_CHUNKS - 1));
+        if (anyAbove(row + x * 3, CHUNK_PX * 3, _params.threshold)) return false;
+    }
+    return true;
+}
+
+// black pixels from the left edge, at most limit
+int BorderDetector::leadingBlack(const uint8_t* row, int width, int limit) const {
+    limit = std::min(limit, width);
+    for (int x = 0; x < limit; x += CHUNK_PX) {
+        const int n = std::min(CHUNK_PX, limit - x);
+        if (!anyAbove(row + x * 3, n * 3, _params.threshold)) continue;
+        for (int i = x; i < x + n; ++i) {
+            if (pixelAbove(row + i * 3, _params.threshold)) return i;
+        }
+    }
+    return limit;
+}
+
+// black pixels from the right edge, at most limit
+int BorderDetector::trailingBlack(const uint8_t* row, int width, int limit) const {
+    limit = std::min(limit, width);
+    for (int k = 0; k < limit; k += CHUNK_PX) {
+        const int n = std::min(CHUNK_PX, limit - k);
+        const int x0 = width - k - n;
+        if (!anyAbove(row + x0 * 3, n * 3, _params.threshold)) continue;
+        for (int i = x0 + n - 1; i >= x0; --i) {
+            if (pixelAbove(row + i * 3, _params.threshold)) return width - 1 - i;
+        }
+    }
+    return limit;
+}
+
+// false if the frame gives no usable answer (e.g. a dark scene)
+bool BorderDetector::detect(const uint8_t* frame, int width, int height, Crop& out) const {
+    const size_t stride = static_cast<size_t>(width) * 3;
+    const int maxY = std::max(1, static_cast<int>(height * _params.maxFraction));
+    const int maxX = std::max(1, static_cast<int>(width * _params.maxFraction));
+    const int step = std::max(1, height / 270);
+
+    // first content row from an edge: coarse steps, then refine backwards
+    auto scanRows = [&](bool fromTop) {
+        auto rowAt = [&](int i) { return frame + (fromTop ? i : height - 1 - i) * stride; };
+        int i = 0;
+        while (i < maxY && rowIsBlack(rowAt(i), width)) i += step;
+        if (i >= maxY) return maxY;
+        while (i > 0 && !rowIsBlack(rowAt(i - 1), width)) --i;
+        return i;
+    };
+
+    const int top = scanRows(true);
+    const int bottom = scanRows(false);
+    if (top >= maxY || bottom >= maxY) return false;
+    const int bars = std::min(top, bottom);   // subtitles may sit in one bar
+
+    // pillarbox: a few rows inside the picture area, scanned inward
+    int left = maxX, right = maxX;
+    const int contentH = height - 2 * bars;
+    for (int i = 0; i < SCAN_ROWS; ++i) {
+        const int y = bars + (2 * i + 1) * contentH / (2 * SCAN_ROWS);
+        const uint8_t* row = frame + y * stride;
+        left = std::min(left, leadingBlack(row, width, left));
+        right = std::min(right, trailingBlack(row, width, right));
+    }
+    if (left >= maxX || right >= maxX) return false;
+    const int pillars = std::min(left, right);
+
+    out.top = out.bottom = bars;
+    out.left = out.right = pillars;
+    return true;
+}
+
+bool BorderDetector::update(const uint8_t* frame, int width, int height) {
+    if (width != _width || height != _height) {
+        _width = width;
+        _height = height;
+        reset();
+    }
+
+    Crop c;
+    if (!detect(frame, width, height, c)) return false;
+
+    if (near(c, _applied)) {
+        _candidateFrames = 0;
+        return false;
+    }
+
+    if (_candidateFrames > 0 && near(c, _candidate)) {
+        ++_candidateFrames;
+    } else {
+        _candidate = c;
+        _candidateFrames = 1;
+    }
+
+    if (_candidateFrames < _params.stableFrames) return false;
+    _applied = _candidate;
+    _candidateFrames = 0;
+    return true;
+}
@@ -0,0 +1,112 @@
+// cpp/src/calibration.cpp
+#include "calibration.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr int Q = 12;
+
+void compileCalibration(const Calibration& calib, float gamma, float brightness,
+                        CompiledCalibration& out) {
+    const float* m = calib.matrix;
+    out.mix = m[1] != 0.0f || m[2] != 0.0f || m[3] != 0.0f ||
+              m[5] != 0.0f || m[6] != 0.0f || m[7] != 0.0f;
+
+    for (int c = 0; c < 3; ++c) {
+        const float g = calib.gamma[c] > 0.01f ? calib.gamma[c] : gamma;
+        // without mixing the diagonal gain happens inside the LUT
+        const float gain = out.mix ? 1.0f : std::clamp(m[c * 4], 0.0f, CALIB_MAX_COEFF);
+        for (int i = 0; i < 256; ++i) {
+            float v = std::min(i * gain, 255.0f) / 255.0f;
+            float corrected = powf(v, g) * 255.0f * brightness;
+            float fixed = std::clamp(corrected, 0.0f, 255.0f) * 256.0f;
+            out.lut[c][i] = static_cast<uint16_t>(fixed + 0.5f);
+        }
+    }
+
+    // channel c of a pixel reads r, g, b at byte offsets -c, 1-c, 2-c
+    for (int t = 0; t < CALIB_LANES; ++t) {
+        const int c = t % 3;
+        for (int d = 0; d < 5; ++d) {
+            const int j = d - 2 + c;
+            const float k = j >= 0 && j < 3 ? std::clamp(m[c * 3 + j], -CALIB_MAX_COEFF, CALIB_MAX_COEFF) : 0.0f;
+            out.weight[d][t] = static_cast<int32_t>(std::lround(k * (1 << Q)));
+        }
+    }
+}
+
+void applyColorMatrix(const CompiledCalibration& calib, uint8_t* rgb, int count) {
+    if (!calib.mix) return;
+    const int32_t round = 1 << (Q - 1);
+    // two zero lanes on either side: the first and last pixel of a block
+    // read them with weight 0
+    int32_t in[CALIB_LANES + 4] = {};
+    const size_t bytes = static_cast<size_t>(count) * 3;
+
+    // widen a block, then five multiply-adds per byte; both are contiguous
+    // loops without a shuffle, which -O3 vectorizes (-fopt-info-vec)
+    for (size_t base = 0; base < bytes; base += CALIB_LANES) {
+        const int n = static_cast<int>(std::min<size_t>(CALIB_LANES, bytes - base));
+        uint8_t* p = rgb + base;
+        for (int t = 0; t < n; ++t) in[t + 2] = p[t];
+        for (int t = 0; t < n; ++t) {
+            const int32_t acc = calib.weight[0][t] * in[t] + calib.weight[1][t] * in[t + 1] +
+                                calib.weight[2][t] * in[t + 2] + calib.weight[3][t] * in[t + 3] +
+                                calib.weight[4][t] * in[t + 4];
+            p[t] = static_cast<uint8_t>(std::clamp((acc + round) >> Q, 0, 255));
+        }
+    }
+}
+
+bool parseCalibration(std::istream& in, Calibration& calib, std::string& error) {
+    std::string what;
+    if (!(in >> what)) {
+        error = "expected WB, MATRIX, GAMMA or RESET";
+        return false;
+    }
+
+    if (what == "RESET") {
+        calib = Calibration{};
+        return true;
+    }
+    if (what == "WB") {
+        float r, g, b;
+        if (!(in >> r >> g >> b) || r < 0.0f || g < 0.0f || b < 0.0f) {
+            error = "WB needs three gains >= 0";
+            return false;
+        }
+        Calibration c;
+        c.matrix[0] = r;
+        c.matrix[4] = g;
+        c.matrix[8] = b;
+        std::copy(calib.gamma, calib.gamma + 3, c.gamma);
+        calib = c;
+        return true;
+    }
+    if (what == "MATRIX") {
+        float m[9];
+        for (float& v : m) {
+            if (!(in >> v)) {
+                error = "MATRIX needs 9 values (row-major)";
+                return false;
+            }
+        }
+        std::copy(m, m + 9, calib.matrix);
+        return true;
+    }
+    if (what == "GAMMA") {
+        float g[3];
+        if (!(in >> g[0] >> g[1] >> g[2])) {
+            error = "GAMMA needs three values (0 = driver gamma)";
+            return false;
+        }
+        std::copy(g, g + 3, calib.gamma);
+        return true;
+    }
+    error = "unknown CALIB mode " + what;
+    return false;
+}
+
+bool sameCalibration(const Calibration& a, const Calibration& b) {
+    return std::equal(a.matrix, a.matrix + 9, b.matrix) && std::equal(a.gamma, a.gamma + 3, b.gamma);
+}
@@ -0,0 +1,75 @@
+// cpp/src/color_order.cpp
+#include "color_order.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+static const struct { ColorOrder order; const char* name; } ORDER_NAMES[] = {
+    { ColorOrder::RGB, "RGB" },
+    { ColorOrder::RBG, "RBG" },
+    { ColorOrder::GRB, "GRB" },
+    { ColorOrder::GBR, "GBR" },
+    { ColorOrder::BRG, "BRG" },
+    { ColorOrder::BGR, "BGR" },
+};
+
+bool parseColorOrder(const std::string& name, ColorOrder& out) {
+    std::string upper(name);
+    std::transform(upper.begin(), upper.end(), upper.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    for (const auto& e : ORDER_NAMES) {
+        if (upper == e.name) {
+            out = e.order;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* colorOrderName(ColorOrder order) {
+    for (const auto& e : ORDER_NAMES) {
+        if (e.order == order) return e.name;
+    }
+    return "?";
+}
+
+bool parseSegment(const std::string& spec, ColorOrder defaultOrder, LedSegment& out) {
+    std::istringstream iss(spec);
+    std::string part;
+    std::vector<std::string> parts;
+    while (std::getline(iss, part, ':')) parts.push_back(part);
+    if (parts.size() < 2) return false;
+
+    LedSegment seg;
+    seg.order = defaultOrder;
+    try {
+        seg.start = std::stoi(parts[0]);
+        seg.count = std::stoi(parts[1]);
+    } catch (...) {
+        return false;
+    }
+    if (seg.start < 0 || seg.count <= 0) return false;
+
+    for (size_t i = 2; i < parts.size(); ++i) {
+        if (parts[i] == "R" || parts[i] == "r") {
+            seg.reversed = true;
+        } else if (!parseColorOrder(parts[i], seg.order)) {
+            return false;
+        }
+    }
+    out = seg;
+    return true;
+}
+
+bool validateSegments(std::vector<LedSegment>& segments, int numLeds) {
+    if (segments.empty()) return false;
+    std::sort(segments.begin(), segments.end(),
+              [](const LedSegment& a, const LedSegment& b) { return a.start < b.start; });
+    int next = 0;
+    for (const auto& s : segments) {
+        if (s.start != next || s.count <= 0) return false;
+        next += s.count;
+    }
+    return next == numLeds;
+}
@@ -0,0 +1,124 @@
+// cpp/src/compositor.cpp
+#include "compositor.h"
+
+#include <algorithm>
+#include <cstring>
+
+// -----------------------------
+// Blend-Funktionen
+// -----------------------------
+// One loop per mode with alpha hoisted, so the body is branch-free
+// 16 bit arithmetic on packed bytes. With t = x + 128, (t + (t >> 8)) >> 8
+// is x / 255 rounded for x <= 65025 (Multiply).
+static void blendNormal(uint8_t* dst, const uint8_t* src, size_t n, uint32_t a) {
+    const uint16_t wa = static_cast<uint16_t>(a), wd = static_cast<uint16_t>(OPAQUE - a);
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = static_cast<uint8_t>((dst[i] * wd + src[i] * wa + 128) >> 8);
+    }
+}
+
+static void blendAdd(uint8_t* dst, const uint8_t* src, size_t n, uint32_t a) {
+    const uint16_t wa = static_cast<uint16_t>(a);
+    for (size_t i = 0; i < n; ++i) {
+        const uint16_t v = static_cast<uint16_t>(dst[i] + ((src[i] * wa + 128) >> 8));
+        dst[i] = static_cast<uint8_t>(v > 255 ? 255 : v);
+    }
+}
+
+static void blendMax(uint8_t* dst, const uint8_t* src, size_t n, uint32_t a) {
+    const uint16_t wa = static_cast<uint16_t>(a);
+    for (size_t i = 0; i < n; ++i) {
+        const uint8_t s = static_cast<uint8_t>((src[i] * wa + 128) >> 8);
+        dst[i] = dst[i] > s ? dst[i] : s;
+    }
+}
+
+static void blendMultiply(uint8_t* dst, const uint8_t* src, size_t n, uint32_t a) {
+    // factor = 255 - a * (255 - src), in 0..255
+    const uint16_t wa = static_cast<uint16_t>(a);
+    for (size_t i = 0; i < n; ++i) {
+        const uint16_t f = static_cast<uint16_t>(255 - (((255 - src[i]) * wa + 128) >> 8));
+        const uint32_t t = dst[i] * f + 128;
+        dst[i] = static_cast<uint8_t>((t + (t >> 8)) >> 8);
+    }
+}
+
+void blendLayer(uint8_t* dst, const uint8_t* src, size_t n, BlendMode mode, uint32_t alpha) {
+    if (alpha == 0) return;
+    alpha = std::min(alpha, OPAQUE);
+    switch (mode) {
+    case BlendMode::Normal:
+        if (alpha == OPAQUE) std::memcpy(dst, src, n);
+        else blendNormal(dst, src, n, alpha);
+        break;
+    case BlendMode::Add:
+        blendAdd(dst, src, n, alpha);
+        break;
+    case BlendMode::Max:
+        blendMax(dst, src, n, alpha);
+        break;
+    case BlendMode::Multiply:
+        blendMultiply(dst, src, n, alpha);
+        break;
+    }
+}
+
+bool parseBlendMode(const std::string& name, BlendMode& out) {
+    if (name == "normal") out = BlendMode::Normal;
+    else if (name == "add") out = BlendMode::Add;
+    else if (name == "max") out = BlendMode::Max;
+    else if (name == "multiply") out = BlendMode::Multiply;
+    else return false;
+    return true;
+}
+
+const char* blendModeName(BlendMode mode) {
+    switch (mode) {
+    case BlendMode::Normal: return "normal";
+    case BlendMode::Add: return "add";
+    case BlendMode::Max: return "max";
+    case BlendMode::Multiply: return "multiply";
+    }
+    return "?";
+}
+
+// -----------------------------
+// Compositor
+// -----------------------------
+Compositor::Compositor(int numLeds)
+    : _out(numLeds)
+{
+}
+
+const std::vector<RGB>& Compositor::compose(const Layer* layers, size_t count) {
+    uint8_t* out = reinterpret_cast<uint8_t*>(_out.data());
+    const size_t n = _out.size() * 3;
+    if (count == 0 || layers[0].mode != BlendMode::Normal || layers[0].alpha < OPAQUE) {
+        std::memset(out, 0, n);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        blendLayer(out, reinterpret_cast<const uint8_t*>(layers[i].colors), n, layers[i].mode, layers[i].alpha);
+    }
+    return _out;
+}
+
+// -----------------------------
+// FadeLevel
+// -----------------------------
+bool FadeLevel::step(bool visible, uint64_t elapsedNs, uint64_t fadeNs) {
+    const uint32_t target = visible ? FULL : 0;
+    if (_level == target) return false;
+    if (fadeNs == 0 || elapsedNs >= fadeNs) {
+        snap(visible);
+        return false;
+    }
+    // floor per step would lose up to one unit each time: at 1 ms steps a
+    // 200 ms fade took 201 steps
+    const uint64_t scaled = elapsedNs * FULL + _carry;
+    const uint64_t delta = scaled / fadeNs;
+    _carry = scaled % fadeNs;
+    if (visible) _level = static_cast<uint32_t>(std::min<uint64_t>(FULL, _level + delta));
+    else _level = _level > delta ? static_cast<uint32_t>(_level - delta) : 0;
+    if (_level == target) _carry = 0;
+    return _level != target;
+}
@@ -0,0 +1,421 @@
+// cpp/src/config.cpp
+#include "config.h"
+
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static constexpr int RELOAD_SETTLE_MS = 50;   // editors write in several steps
+
+// -----------------------------
+// Hilfsfunktionen
+// -----------------------------
+static std::string trim(const std::string& s) {
+    const size_t b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return std::string();
+    const size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+static std::string lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+    return s;
+}
+
+template <class T>
+static bool parseValue(const std::string& text, T& out) {
+    std::istringstream iss(text);
+    T v;
+    if (!(iss >> v) || !(iss >> std::ws).eof()) return false;
+    out = v;
+    return true;
+}
+
+static bool parseBool(const std::string& text, bool& out) {
+    const std::string v = lower(text);
+    if (v == "1" || v == "on" || v == "true" || v == "yes") out = true;
+    else if (v == "0" || v == "off" || v == "false" || v == "no") out = false;
+    else return false;
+    return true;
+}
+
+// "priority timeout_ms [blend [opacity]]"
+static bool parsePolicy(const std::string& text, SourcePolicy& out) {
+    SourcePolicy p;
+    std::istringstream iss(text);
+    if (!(iss >> p.priority >> p.timeoutMs) || p.timeoutMs < 0) return false;
+    std::string blend;
+    if (iss >> blend) {
+        if (!parseBlendMode(lower(blend), p.blend)) return false;
+        if (!(iss >> std::ws).eof() && (!(iss >> p.opacity) || p.opacity < 0.0f || p.opacity > 1.0f)) return false;
+    }
+    if (!(iss >> std::ws).eof()) return false;
+    out = p;
+    return true;
+}
+
+static bool parseReduceMode(const std::string& text, AmbientProcessor::ReduceMode& out) {
+    const std::string v = lower(text);
+    if (v == "mean") out = AmbientProcessor::ReduceMode::Mean;
+    else if (v == "sample") out = AmbientProcessor::ReduceMode::Sample;
+    else if (v == "dominant") out = AmbientProcessor::ReduceMode::Dominant;
+    else return false;
+    return true;
+}
+
+// one "section.key = value"; false + message
+static bool setKey(Config& c, const std::string& key, const std::string& val,
+                   std::string& segmentSpec, std::string& error) {
+    bool ok = true;
+    // [led]
+    if (key == "led.count") ok = parseValue(val, c.ledCount) && c.ledCount > 0;
+    else if (key == "led.device") c.device = val;
+    else if (key == "led.chip") {
+        c.chip = lower(val);
+        if (c.chip != "ws2801") {
+            error = "unsupported chip '" + val + "' (ws2801)";
+            return false;
+        }
+    }
+    else if (key == "led.spi_speed") ok = parseValue(val, c.spiSpeedHz) && c.spiSpeedHz > 0;
+    // [output]
+    else if (key == "output.gamma") ok = parseValue(val, c.output.gamma) && c.output.gamma > 0.01f;
+    else if (key == "output.brightness") ok = parseValue(val, c.output.brightness);
+    else if (key == "output.order") ok = parseColorOrder(val, c.order);
+    else if (key == "output.segments") segmentSpec = val;      // needs order + count, parsed last
+    else if (key == "output.calibration") {
+        std::istringstream iss(val);
+        if (!parseCalibration(iss, c.output.calibration, error)) return false;
+    }
+    else if (key == "output.power_budget") ok = parseValue(val, c.output.power.budgetmA) && c.output.power.budgetmA >= 0.0f;
+    else if (key == "output.power_model") {
+        PowerModel& pm = c.output.power;
+        std::istringstream iss(val);
+        ok = (iss >> pm.channelmA[0] >> pm.channelmA[1] >> pm.channelmA[2] >> pm.idlemA >> pm.volts)
+             && pm.volts > 0.0f;
+    }
+    else if (key == "output.smoothing_ms") ok = parseValue(val, c.smoothingMs) && c.smoothingMs >= 0.0f;
+    else if (key == "output.smoothing_fast_ms") ok = parseValue(val, c.smoothingFastMs) && c.smoothingFastMs >= 0.0f;
+    else if (key == "output.smoothing" || key == "output.smoothing_fast") {
+        float alpha;
+        ok = parseValue(val, alpha) && alpha >= 0.0f && alpha <= 1.0f;
+        if (ok) (key == "output.smoothing" ? c.smoothingMs : c.smoothingFastMs) = alphaToTauMs(alpha);
+    }
+    else if (key == "output.attack") ok = parseValue(val, c.adaptive.attackThreshold);
+    else if (key == "output.cut") ok = parseValue(val, c.adaptive.cutThreshold);
+    else if (key == "output.dither") ok = parseBool(val, c.dithering);
+    else if (key == "output.refresh") ok = parseValue(val, c.refreshHz) && c.refreshHz >= 0;
+    // [ambient]
+    else if (key == "ambient.smoothing_ms") ok = parseValue(val, c.ambient.smoothingMs) && c.ambient.smoothingMs >= 0.0f;
+    else if (key == "ambient.smoothing_fast_ms") {
+        ok = parseValue(val, c.ambient.smoothingFastMs) && c.ambient.smoothingFastMs >= 0.0f;
+    }
+    else if (key == "ambient.smoothing" || key == "ambient.smoothing_fast") {
+        int frames;
+        ok = parseValue(val, frames) && frames > 0;
+        if (ok) (key == "ambient.smoothing" ? c.ambient.smoothingMs : c.ambient.smoothingFastMs) = windowToTauMs(frames);
+    }
+    else if (key == "ambient.brightness") ok = parseValue(val, c.ambient.brightness);
+    else if (key == "ambient.attack") ok = parseValue(val, c.ambient.adaptive.attackThreshold);
+    else if (key == "ambient.cut") ok = parseValue(val, c.ambient.adaptive.cutThreshold);
+    else if (key == "ambient.border") ok = parseBool(val, c.ambient.borderDetection);
+    else if (key == "ambient.downscale") ok = parseValue(val, c.ambient.downscale);
+    else if (key == "ambient.mode") ok = parseReduceMode(val, c.ambient.mode);
+    else if (key == "ambient.samples") {
+        char x = 0;
+        std::istringstream iss(val);
+        ok = (iss >> c.ambient.samplesX >> x >> c.ambient.samplesY) && (x == 'x' || x == 'X');
+    }
+    else if (key == "ambient.threads") ok = parseValue(val, c.ambient.threads) && c.ambient.threads > 0;
+    // [capture]
+    else if (key == "capture.width") ok = parseValue(val, c.captureWidth) && c.captureWidth > 0;
+    else if (key == "capture.height") ok = parseValue(val, c.captureHeight) && c.captureHeight > 0;
+    else if (key == "capture.fps") ok = parseValue(val, c.captureFps) && c.captureFps > 0;
+    else if (key == "capture.delay") {
+        ok = parseValue(val, c.captureDelayMs) && c.captureDelayMs >= 0 && c.captureDelayMs <= DelayLine::MAX_DELAY_MS;
+    }
+    // [ipc]
+    else if (key == "ipc.port") ok = parseValue(val, c.port) && c.port > 0 && c.port < 65536;
+    // [dmx]
+    else if (key == "dmx.e131") ok = parseBool(val, c.e131);
+    else if (key == "dmx.artnet") ok = parseBool(val, c.artnet);
+    else if (key == "dmx.e131_universe") ok = parseValue(val, c.e131Universe) && c.e131Universe >= 1 && c.e131Universe < 64000;
+    else if (key == "dmx.artnet_universe") ok = parseValue(val, c.artnetUniverse) && c.artnetUniverse >= 0 && c.artnetUniverse < 32768;
+    else if (key == "dmx.leds_per_universe") {
+        ok = parseValue(val, c.ledsPerUniverse) && c.ledsPerUniverse > 0 && c.ledsPerUniverse <= LEDS_PER_UNIVERSE;
+    }
+    // [ddp]
+    else if (key == "ddp.enable") ok = parseBool(val, c.ddp);
+    else if (key == "ddp.port") ok = parseValue(val, c.ddpPort) && c.ddpPort > 0 && c.ddpPort < 65536;
+    // [opc]
+    else if (key == "opc.enable") ok = parseBool(val, c.opc);
+    else if (key == "opc.port") ok = parseValue(val, c.opcPort) && c.opcPort > 0 && c.opcPort < 65536;
+    else if (key == "opc.channels") ok = OpcServer::parseMapping(val, c.opcChannels);
+    // [effects]
+    else if (key == "effects.rate") ok = parseValue(val, c.effectRate) && c.effectRate > 0 && c.effectRate <= 1000;
+    else if (key == "effects.effect") {
+        EffectParams params;
+        std::string msg;
+        ok = parseEffect(val, params, msg);
+        if (ok) c.effect = val;
+    }
+    // [audio]
+    else if (key == "audio.enable") ok = parseBool(val, c.audio);
+    else if (key == "audio.device") c.audioDevice = val;
+    else if (key == "audio.fft") {
+        ok = parseValue(val, c.audioFft) && c.audioFft >= 256 && c.audioFft <= 16384 && (c.audioFft & (c.audioFft - 1)) == 0;
+    }
+    else if (key == "audio.bands") ok = parseValue(val, c.audioBands) && c.audioBands >= 2 && c.audioBands <= 64;
+    // [sources]
+    else if (key == "sources.capture") ok = parsePolicy(val, c.captureSource);
+    else if (key == "sources.network") ok = parsePolicy(val, c.networkSource);
+    else if (key == "sources.ipc") ok = parsePolicy(val, c.ipcSource);
+    else if (key == "sources.effect") ok = parsePolicy(val, c.effectSource);
+    else if (key == "sources.audio") ok = parsePolicy(val, c.audioSource);
+    else if (key == "sources.fade") ok = parseValue(val, c.fadeMs) && c.fadeMs >= 0;
+
+    else if (key == "trace.dir") c.traceDir = val;
+    else {
+        std::cerr << "[Config] unknown key " << key << " (ignored)\n";
+        return true;
+    }
+    if (!ok) error = "bad value '" + val + "' for " + key;
+    return ok;
+}
+
+static bool samePower(const PowerModel& a, const PowerModel& b) {
+    return std::equal(a.channelmA, a.channelmA + 3, b.channelmA) && a.idlemA == b.idlemA &&
+           a.volts == b.volts && a.budgetmA == b.budgetmA;
+}
+
+static bool sameSegments(const std::vector<LedSegment>& a, const std::vector<LedSegment>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const LedSegment& x, const LedSegment& y) {
+        return x.start == y.start && x.count == y.count && x.order == y.order && x.reversed == y.reversed;
+    });
+}
+
+static bool samePolicy(const SourcePolicy& a, const SourcePolicy& b) {
+    return a.priority == b.priority && a.timeoutMs == b.timeoutMs && a.blend == b.blend && a.opacity == b.opacity;
+}
+
+static bool sameOpcChannels(const std::vector<OpcServer::Mapping>& a, const std::vector<OpcServer::Mapping>& b) {
+    using M = OpcServer::Mapping;
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const M& x, const M& y) {
+        return x.channel == y.channel && x.start == y.start && x.count == y.count;
+    });
+}
+
+static bool sameOutput(const LEDDriver::OutputConfig& a, const LEDDriver::OutputConfig& b) {
+    return a.gamma == b.gamma && a.brightness == b.brightness && sameSegments(a.segments, b.segments) &&
+           sameCalibration(a.calibration, b.calibration) && samePower(a.power, b.power);
+}
+
+static bool sameAmbient(const AmbientProcessor::Settings& a, const AmbientProcessor::Settings& b) {
+    return a.smoothingMs == b.smoothingMs && a.smoothingFastMs == b.smoothingFastMs &&
+           a.brightness == b.brightness && a.adaptive.attackThreshold == b.adaptive.attackThreshold &&
+           a.adaptive.cutThreshold == b.adaptive.cutThreshold && a.borderDetection == b.borderDetection &&
+           a.downscale == b.downscale && a.mode == b.mode && a.samplesX == b.samplesX &&
+           a.samplesY == b.samplesY && a.threads == b.threads;
+}
+
+// -----------------------------
+// Laden
+// -----------------------------
+bool loadConfig(const std::string& path, Config& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = path + ": cannot open";
+        return false;
+    }
+
+    Config c;
+    std::string section, segmentSpec, line;
+    for (int lineNo = 1; std::getline(in, line); ++lineNo) {
+        const size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        line = trim(line);
+        if (line.empty()) continue;
+
+        auto fail = [&](const std::string& msg) {
+            error = path + ":" + std::to_string(lineNo) + ": " + msg;
+            return false;
+        };
+        if (line.front() == '[') {
+            if (line.back() != ']') return fail("bad section header");
+            section = lower(trim(line.substr(1, line.size() - 2)));
+            continue;
+        }
+        const size_t eq = line.find('=');
+        if (eq == std::string::npos) return fail("expected key = value");
+        const std::string key = section + "." + lower(trim(line.substr(0, eq)));
+        std::string msg;
+        if (!setKey(c, key, trim(line.substr(eq + 1)), segmentSpec, msg)) return fail(msg);
+    }
+
+    // layout: explicit segments (default order from "order"), else one segment
+    c.output.segments.clear();
+    if (segmentSpec.empty()) {
+        c.output.segments.push_back(LedSegment{0, c.ledCount, c.order, false});
+    } else {
+        std::istringstream iss(segmentSpec);
+        std::string spec;
+        while (iss >> spec) {
+            LedSegment seg;
+            if (!parseSegment(spec, c.order, seg)) {
+                error = path + ": bad segment '" + spec + "'";
+                return false;
+            }
+            c.output.segments.push_back(seg);
+        }
+        if (!validateSegments(c.output.segments, c.ledCount)) {
+            error = path + ": segments must cover 0.." + std::to_string(c.ledCount - 1) + " without gaps";
+            return false;
+        }
+    }
+
+    out = std::move(c);
+    return true;
+}
+
+// -----------------------------
+// Anwenden
+// -----------------------------
+void applyConfig(const Config& cfg, const Config* previous, LEDDriver& driver, AmbientProcessor& ambient) {
+    const Config* p = previous;
+    if (p) {
+        auto restart = [](const char* key) {
+            std::cerr << "[Config] " << key << " changed: takes effect after a restart\n";
+        };
+        if (cfg.ledCount != p->ledCount) restart("led.count");
+        if (cfg.device != p->device) restart("led.device");
+        if (cfg.chip != p->chip) restart("led.chip");
+        if (cfg.spiSpeedHz != p->spiSpeedHz) restart("led.spi_speed");
+        if (cfg.captureWidth != p->captureWidth || cfg.captureHeight != p->captureHeight ||
+            cfg.captureFps != p->captureFps) restart("[capture]");
+        if (cfg.port != p->port) restart("ipc.port");
+        if (cfg.e131 != p->e131 || cfg.artnet != p->artnet || cfg.e131Universe != p->e131Universe ||
+            cfg.artnetUniverse != p->artnetUniverse || cfg.ledsPerUniverse != p->ledsPerUniverse) restart("[dmx]");
+        if (cfg.ddp != p->ddp || cfg.ddpPort != p->ddpPort) restart("[ddp]");
+        if (cfg.opc != p->opc || cfg.opcPort != p->opcPort || !sameOpcChannels(cfg.opcChannels, p->opcChannels)) {
+            restart("[opc]");
+        }
+        if (cfg.effectRate != p->effectRate) restart("effects.rate");
+        if (cfg.audio != p->audio || cfg.audioDevice != p->audioDevice || cfg.audioFft != p->audioFft || cfg.audioBands != p->audioBands) restart("[audio]");
+        if (!samePolicy(cfg.captureSource, p->captureSource) || !samePolicy(cfg.networkSource, p->networkSource) ||
+            !samePolicy(cfg.ipcSource, p->ipcSource) || !samePolicy(cfg.effectSource, p->effectSource) ||
+            !samePolicy(cfg.audioSource, p->audioSource) || cfg.fadeMs != p->fadeMs) restart("[sources]");
+    }
+
+    // one table rebuild here, one atomic swap for the output thread
+    if (!p || !sameOutput(cfg.output, p->output)) {
+        LEDDriver::OutputConfig out = cfg.output;
+        // a layout for a new LED count only fits after the restart
+        if (cfg.ledCount != driver.numLeds()) out.segments.assign(1, LedSegment{0, driver.numLeds(), cfg.order, false});
+        driver.setOutputConfig(std::move(out));
+    }
+    if (!p || cfg.smoothingMs != p->smoothingMs) driver.setSmoothingTime(cfg.smoothingMs);
+    if (!p || cfg.smoothingFastMs != p->smoothingFastMs ||
+        cfg.adaptive.attackThreshold != p->adaptive.attackThreshold ||
+        cfg.adaptive.cutThreshold != p->adaptive.cutThreshold) {
+        driver.setAdaptiveSmoothing(cfg.smoothingFastMs, cfg.adaptive);
+    }
+    if (!p || cfg.dithering != p->dithering) driver.setDithering(cfg.dithering);
+    if (!p || cfg.refreshHz != p->refreshHz) {
+        if (cfg.refreshHz > 0) driver.startOutputThread(cfg.refreshHz);
+        else if (p) driver.stopOutputThread();
+    }
+
+    if (!p || cfg.traceDir != p->traceDir) driver.setTraceDir(cfg.traceDir);
+
+    // picked up by the processing thread at the next frame
+    if (!p || !sameAmbient(cfg.ambient, p->ambient)) ambient.queueSettings(cfg.ambient);
+}
+
+// -----------------------------
+// ConfigWatcher
+// -----------------------------
+ConfigWatcher::ConfigWatcher(const std::string& path, Callback onReload)
+    : _path(path),
+      _onReload(std::move(onReload))
+{
+    const size_t slash = path.find_last_of('/');
+    _dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    _name = slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+bool ConfigWatcher::start() {
+    stop();
+    _inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_inotifyFd < 0 || _wakeFd < 0 ||
+        inotify_add_watch(_inotifyFd, _dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        perror(("[Config] watch " + _dir).c_str());
+        stop();
+        return false;
+    }
+    _thread = std::thread(&ConfigWatcher::loop, this);
+    return true;
+}
+
+void ConfigWatcher::stop() {
+    if (_thread.joinable()) {
+        uint64_t one = 1;
+        if (write(_wakeFd, &one, sizeof(one)) < 0) perror("[Config] wake");
+        _thread.join();
+    }
+    if (_inotifyFd >= 0) close(_inotifyFd);
+    if (_wakeFd >= 0) close(_wakeFd);
+    _inotifyFd = _wakeFd = -1;
+}
+
+void ConfigWatcher::loop() {
+    alignas(inotify_event) char buf[4096];
+    pollfd fds[2] = { { _inotifyFd, POLLIN, 0 }, { _wakeFd, POLLIN, 0 } };
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("[Config] poll");
+            return;
+        }
+        if (fds[1].revents) return;
+
+        // drain; reload if any event names our file
+        bool changed = false;
+        do {
+            ssize_t n;
+            while ((n = read(_inotifyFd, buf, sizeof(buf))) > 0) {
+                for (char* p = buf; p < buf + n;) {
+                    const inotify_event* ev = reinterpret_cast<const inotify_event*>(p);
+                    if (ev->len > 0 && _name == ev->name) changed = true;
+                    p += sizeof(inotify_event) + ev->len;
+                }
+            }
+            // let the editor finish (truncate + write, temp file + rename)
+            if (changed) std::this_thread::sleep_for(std::chrono::milliseconds(RELOAD_SETTLE_MS));
+        } while (changed && poll(fds, 1, 0) > 0);
+        if (!changed) continue;
+
+        Config cfg;
+        std::string error;
+        if (!loadConfig(_path, cfg, error)) {
+            std::cerr << "[Config] reload failed, keeping the old config: " << error << "\n";
+            continue;
+        }
+        std::cerr << "[Config] reloaded " << _path << "\n";
+        _onReload(cfg);
+    }
+}
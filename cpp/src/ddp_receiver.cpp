@@ -0,0 +1,212 @@
+// cpp/src/ddp_receiver.cpp
+#include "ddp_receiver.h"
+#include "frame_source.h"
+
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+
+// header byte 0
+static constexpr uint8_t DDP_VERSION_MASK = 0xC0;
+static constexpr uint8_t DDP_VERSION_1 = 0x40;
+static constexpr uint8_t DDP_FLAG_TIMECODE = 0x10;
+static constexpr uint8_t DDP_FLAG_REPLY = 0x04;
+static constexpr uint8_t DDP_FLAG_QUERY = 0x02;
+static constexpr uint8_t DDP_FLAG_PUSH = 0x01;
+// header byte 3: 1 = default output, 246..254 control/config/status/DMX
+static constexpr uint8_t DDP_ID_CONTROL_FIRST = 246;
+static constexpr uint8_t DDP_ID_ALL = 255;
+
+static inline uint32_t be32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | p[2] << 8 | p[3];
+}
+
+DdpReceiver::DdpReceiver(FrameTarget& target, int port)
+    : _target(target),
+      _port(port),
+      _frame(target.numLeds(), RGB{0, 0, 0})
+{
+    _sources.reserve(MAX_SOURCES);
+}
+
+DdpReceiver::~DdpReceiver() {
+    stop();
+}
+
+// -----------------------------
+// Start / Stop
+// -----------------------------
+bool DdpReceiver::start() {
+    stop();
+    _fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_fd < 0 || _wakeFd < 0) {
+        perror("[DDP] socket");
+        stop();
+        return false;
+    }
+
+    int opt = 1;
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    int rcvbuf = RCVBUF_BYTES;
+    setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(_port);
+    if (bind(_fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror(("[DDP] bind " + std::to_string(_port)).c_str());
+        stop();
+        return false;
+    }
+
+    _thread = std::thread(&DdpReceiver::loop, this);
+    pthread_setname_np(_thread.native_handle(), "amb-ddp");
+    std::cout << "[DDP] Listening on port " << _port << " (" << _frame.size() * 3 << " bytes)" << std::endl;
+    return true;
+}
+
+void DdpReceiver::stop() {
+    if (_thread.joinable()) {
+        uint64_t one = 1;
+        if (write(_wakeFd, &one, sizeof(one)) < 0) perror("[DDP] wake");
+        _thread.join();
+    }
+    if (_fd >= 0) close(_fd);
+    if (_wakeFd >= 0) close(_wakeFd);
+    _fd = _wakeFd = -1;
+}
+
+DdpReceiver::Stats DdpReceiver::stats() const {
+    Stats s;
+    s.packets = _packets.load(std::memory_order_relaxed);
+    s.bytes = _bytes.load(std::memory_order_relaxed);
+    s.frames = _frames.load(std::memory_order_relaxed);
+    s.lost = _lost.load(std::memory_order_relaxed);
+    s.reordered = _reordered.load(std::memory_order_relaxed);
+    s.ignored = _ignored.load(std::memory_order_relaxed);
+    s.clipped = _clipped.load(std::memory_order_relaxed);
+    s.sources = _sourceCount.load(std::memory_order_relaxed);
+    return s;
+}
+
+// -----------------------------
+// Empfang
+// -----------------------------
+void DdpReceiver::loop() {
+    pollfd fds[2] = { { _fd, POLLIN, 0 }, { _wakeFd, POLLIN, 0 } };
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("[DDP] poll");
+            return;
+        }
+        if (fds[1].revents) return;
+        while (receiveOne()) {
+        }
+    }
+}
+
+bool DdpReceiver::receiveOne() {
+    uint8_t header[HEADER_TIMECODE];
+    sockaddr_in from{};
+    iovec iov[2] = { { header, sizeof(header) }, { nullptr, 0 } };
+    msghdr msg{};
+    msg.msg_name = &from;
+    msg.msg_namelen = sizeof(from);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 1;
+
+    // 1. header only, the datagram stays queued
+    const ssize_t peeked = recvmsg(_fd, &msg, MSG_PEEK | MSG_DONTWAIT);
+    if (peeked < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) perror("[DDP] recvmsg");
+        return false;
+    }
+    const uint8_t flags = header[0];
+    const size_t headerLen = (flags & DDP_FLAG_TIMECODE) ? HEADER_TIMECODE : HEADER;
+    const uint8_t id = header[3];
+    if (size_t(peeked) < headerLen || (flags & DDP_VERSION_MASK) != DDP_VERSION_1 ||
+        (flags & (DDP_FLAG_QUERY | DDP_FLAG_REPLY)) || (id >= DDP_ID_CONTROL_FIRST && id != DDP_ID_ALL)) {
+        discard();
+        _ignored.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 2. header + payload, scattered straight into the frame at offset
+    const size_t offset = be32(header + 4);
+    const size_t length = static_cast<size_t>(header[8] << 8 | header[9]);
+    const size_t capacity = _frame.size() * 3;
+    const size_t take = offset < capacity ? std::min(length, capacity - offset) : 0;
+    iov[0].iov_len = headerLen;
+    iov[1].iov_base = reinterpret_cast<uint8_t*>(_frame.data()) + offset;
+    iov[1].iov_len = take;
+    msg.msg_iovlen = take > 0 ? 2 : 1;
+    msg.msg_name = nullptr;
+    msg.msg_namelen = 0;
+    const ssize_t n = recvmsg(_fd, &msg, MSG_DONTWAIT);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) perror("[DDP] recvmsg");
+        return false;
+    }
+
+    _packets.fetch_add(1, std::memory_order_relaxed);
+    if (size_t(n) < headerLen + take) {
+        _ignored.fetch_add(1, std::memory_order_relaxed);   // shorter than announced
+        return true;
+    }
+    _bytes.fetch_add(take, std::memory_order_relaxed);
+    if (take < length) _clipped.fetch_add(1, std::memory_order_relaxed);
+    trackSequence(from.sin_addr.s_addr, from.sin_port, header[1] & 0x0F);
+
+    if (flags & DDP_FLAG_PUSH) {
+        _target.submitFrame(_frame);
+        _frames.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// drop the peeked datagram
+void DdpReceiver::discard() {
+    uint8_t byte;
+    if (recv(_fd, &byte, 1, MSG_DONTWAIT) < 0 && errno != EAGAIN && errno != EWOULDBLOCK) perror("[DDP] recv");
+}
+
+void DdpReceiver::trackSequence(uint32_t addr, uint16_t port, uint8_t seq) {
+    const uint64_t now = monotonicNs();
+    auto it = std::find_if(_sources.begin(), _sources.end(),
+                           [&](const Source& s) { return s.addr == addr && s.port == port; });
+    if (it == _sources.end()) {
+        if (_sources.size() < MAX_SOURCES) {
+            it = _sources.insert(_sources.end(), Source{});
+        } else {
+            it = std::min_element(_sources.begin(), _sources.end(),
+                                  [](const Source& a, const Source& b) { return a.lastSeenNs < b.lastSeenNs; });
+        }
+        *it = Source{ addr, port, 0, now };
+        _sourceCount.store(static_cast<int>(_sources.size()), std::memory_order_relaxed);
+    }
+    it->lastSeenNs = now;
+
+    // 0 = sender does not number its packets; 1..15 wrap
+    if (seq == 0) return;
+    if (it->lastSeq != 0) {
+        const int step = (seq - it->lastSeq + 15) % 15;
+        if (step == 0 || step > 7) {
+            _reordered.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (step > 1) _lost.fetch_add(step - 1, std::memory_order_relaxed);
+    }
+    it->lastSeq = seq;
+}
@@ -0,0 +1,50 @@
+// cpp/src/delay_line.cpp
+#include "delay_line.h"
+
+#include <algorithm>
+
+static_assert((DelayLine::CAPACITY & (DelayLine::CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+DelayLine::DelayLine(int numLeds)
+    : _frames(CAPACITY, std::vector<RGB>(numLeds)),
+      _timestamps(CAPACITY, 0),
+      _media(CAPACITY, 0)
+{
+}
+
+void DelayLine::setDelayMs(int ms) {
+    _delayMs.store(std::min(std::max(ms, 0), MAX_DELAY_MS), std::memory_order_relaxed);
+}
+
+void DelayLine::push(const std::vector<RGB>& colors, uint64_t timestampNs, uint64_t mediaNs) {
+    if (_head - _tail == CAPACITY) {
+        ++_tail;                                     // full: lose the oldest
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    const size_t i = _head & (CAPACITY - 1);
+    std::copy_n(colors.begin(), std::min(colors.size(), _frames[i].size()), _frames[i].begin());
+    _timestamps[i] = timestampNs;
+    _media[i] = mediaNs;
+    ++_head;
+}
+
+const std::vector<RGB>* DelayLine::due(uint64_t nowNs, uint64_t& timestampNs, uint64_t& mediaNs) {
+    const uint64_t delayNs = static_cast<uint64_t>(delayMs()) * 1000000ull;
+    const std::vector<RGB>* frame = nullptr;
+    while (_tail != _head) {
+        const size_t i = _tail & (CAPACITY - 1);
+        if (_timestamps[i] + delayNs > nowNs) break;
+        if (frame) _dropped.fetch_add(1, std::memory_order_relaxed);
+        frame = &_frames[i];
+        timestampNs = _timestamps[i];
+        mediaNs = _media[i];
+        ++_tail;
+    }
+    return frame;
+}
+
+bool DelayLine::nextDue(uint64_t& dueNs) const {
+    if (empty()) return false;
+    dueNs = _timestamps[_tail & (CAPACITY - 1)] + static_cast<uint64_t>(delayMs()) * 1000000ull;
+    return true;
+}
@@ -0,0 +1,188 @@
+// cpp/src/dmx_protocol.cpp
+#include "dmx_protocol.h"
+
+#include <cstring>
+
+// E1.31-2018 layout (all multi-byte fields big endian)
+static const uint8_t ACN_ID[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+static constexpr uint32_t VECTOR_ROOT_E131_DATA = 0x00000004;
+static constexpr uint32_t VECTOR_ROOT_E131_EXTENDED = 0x00000008;
+static constexpr uint32_t VECTOR_E131_DATA_PACKET = 0x00000002;
+static constexpr uint32_t VECTOR_E131_EXTENDED_SYNCHRONIZATION = 0x00000001;
+static constexpr uint8_t VECTOR_DMP_SET_PROPERTY = 0x02;
+static constexpr uint8_t E131_OPT_PREVIEW = 0x80;
+static constexpr uint8_t E131_OPT_TERMINATED = 0x40;
+static constexpr size_t E131_DATA_HEADER = 126;   // up to the first DMX slot
+static constexpr size_t E131_SYNC_SIZE = 49;
+
+static const uint8_t ARTNET_ID[8] = { 'A', 'r', 't', '-', 'N', 'e', 't', 0 };
+static constexpr uint16_t ART_OP_DMX = 0x5000;
+static constexpr uint16_t ART_OP_SYNC = 0x5200;
+static constexpr uint16_t ART_PROTOCOL = 14;
+static constexpr size_t ART_DMX_HEADER = 18;
+static constexpr size_t ART_SYNC_SIZE = 14;
+
+// -----------------------------
+// Hilfsfunktionen
+// -----------------------------
+static inline uint16_t be16(const uint8_t* p) { return static_cast<uint16_t>(p[0] << 8 | p[1]); }
+static inline uint32_t be32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | p[2] << 8 | p[3];
+}
+static inline void putBe16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v);
+}
+static inline void putBe32(uint8_t* p, uint32_t v) {
+    putBe16(p, static_cast<uint16_t>(v >> 16));
+    putBe16(p + 2, static_cast<uint16_t>(v));
+}
+// ACN PDU flags (0x7) + length of the PDU starting at p, up to the packet end
+static inline void putFlagsLength(uint8_t* p, size_t pduLength) {
+    putBe16(p, static_cast<uint16_t>(0x7000 | (pduLength & 0x0FFF)));
+}
+
+static size_t putE131Root(uint8_t* out, const uint8_t cid[16], uint32_t vector, size_t total) {
+    putBe16(out, 0x0010);                    // preamble size
+    putBe16(out + 2, 0x0000);                // postamble size
+    std::memcpy(out + 4, ACN_ID, sizeof(ACN_ID));
+    putFlagsLength(out + 16, total - 16);
+    putBe32(out + 18, vector);
+    std::memcpy(out + 22, cid, 16);
+    return 38;
+}
+
+// -----------------------------
+// E1.31
+// -----------------------------
+bool parseE131(const uint8_t* buf, size_t len, DmxPacket& out) {
+    if (len < E131_SYNC_SIZE || be16(buf) != 0x0010 || std::memcmp(buf + 4, ACN_ID, sizeof(ACN_ID)) != 0) {
+        return false;
+    }
+    const uint32_t rootVector = be32(buf + 18);
+
+    if (rootVector == VECTOR_ROOT_E131_EXTENDED) {
+        if (be32(buf + 40) != VECTOR_E131_EXTENDED_SYNCHRONIZATION) return false;
+        out.type = DmxPacket::Type::Sync;
+        out.sequence = buf[44];
+        out.universe = be16(buf + 45);
+        out.syncAddress = out.universe;
+        out.data = nullptr;
+        out.length = 0;
+        return true;
+    }
+
+    if (rootVector != VECTOR_ROOT_E131_DATA || len < E131_DATA_HEADER) return false;
+    if (be32(buf + 40) != VECTOR_E131_DATA_PACKET) return false;
+    const uint8_t options = buf[112];
+    if (options & (E131_OPT_PREVIEW | E131_OPT_TERMINATED)) return false;
+    if (buf[117] != VECTOR_DMP_SET_PROPERTY || buf[118] != 0xA1) return false;
+    const uint16_t count = be16(buf + 123);               // includes the start code
+    if (count < 1 || buf[125] != 0x00) return false;      // DMX data only
+    if (E131_DATA_HEADER + count - 1 > len) return false;
+
+    out.type = DmxPacket::Type::Data;
+    out.priority = buf[108];
+    out.syncAddress = be16(buf + 109);
+    out.sequence = buf[111];
+    out.universe = be16(buf + 113);
+    out.data = buf + E131_DATA_HEADER;
+    out.length = static_cast<uint16_t>(count - 1);
+    return true;
+}
+
+size_t buildE131Data(uint8_t* out, const uint8_t cid[16], uint16_t universe, uint8_t sequence,
+                     uint16_t syncAddress, const uint8_t* data, uint16_t length) {
+    if (length > DMX_CHANNELS) length = DMX_CHANNELS;
+    const size_t total = E131_DATA_HEADER + length;
+    std::memset(out, 0, E131_DATA_HEADER);
+    putE131Root(out, cid, VECTOR_ROOT_E131_DATA, total);
+
+    // framing layer
+    putFlagsLength(out + 38, total - 38);
+    putBe32(out + 40, VECTOR_E131_DATA_PACKET);
+    std::memcpy(out + 44, "ambilight dmx_send", 18);  // source name, 64 bytes
+    out[108] = 100;                                     // priority
+    putBe16(out + 109, syncAddress);
+    out[111] = sequence;
+    out[112] = 0;                                       // options
+    putBe16(out + 113, universe);
+
+    // DMP layer
+    putFlagsLength(out + 115, total - 115);
+    out[117] = VECTOR_DMP_SET_PROPERTY;
+    out[118] = 0xA1;                                    // address + data type
+    putBe16(out + 119, 0);                              // first property address
+    putBe16(out + 121, 1);                              // address increment
+    putBe16(out + 123, static_cast<uint16_t>(length + 1));
+    out[125] = 0x00;                                    // start code
+    std::memcpy(out + E131_DATA_HEADER, data, length);
+    return total;
+}
+
+size_t buildE131Sync(uint8_t* out, const uint8_t cid[16], uint16_t syncAddress, uint8_t sequence) {
+    std::memset(out, 0, E131_SYNC_SIZE);
+    putE131Root(out, cid, VECTOR_ROOT_E131_EXTENDED, E131_SYNC_SIZE);
+    putFlagsLength(out + 38, E131_SYNC_SIZE - 38);
+    putBe32(out + 40, VECTOR_E131_EXTENDED_SYNCHRONIZATION);
+    out[44] = sequence;
+    putBe16(out + 45, syncAddress);
+    return E131_SYNC_SIZE;
+}
+
+// -----------------------------
+// Art-Net
+// -----------------------------
+bool parseArtNet(const uint8_t* buf, size_t len, DmxPacket& out) {
+    if (len < ART_SYNC_SIZE || std::memcmp(buf, ARTNET_ID, sizeof(ARTNET_ID)) != 0) return false;
+    const uint16_t op = static_cast<uint16_t>(buf[8] | buf[9] << 8);   // little endian
+
+    if (op == ART_OP_SYNC) {
+        out.type = DmxPacket::Type::Sync;
+        out.universe = 0;
+        out.syncAddress = 0;
+        out.sequence = 0;
+        out.data = nullptr;
+        out.length = 0;
+        return true;
+    }
+    if (op != ART_OP_DMX || len < ART_DMX_HEADER) return false;
+
+    const uint16_t length = be16(buf + 16);
+    if (length > DMX_CHANNELS || ART_DMX_HEADER + length > len) return false;
+    out.type = DmxPacket::Type::Data;
+    out.sequence = buf[12];
+    out.universe = static_cast<uint16_t>((buf[15] & 0x7F) << 8 | buf[14]);   // Net:SubUni
+    out.syncAddress = 0;
+    out.priority = 100;
+    out.data = buf + ART_DMX_HEADER;
+    out.length = length;
+    return true;
+}
+
+size_t buildArtDmx(uint8_t* out, uint16_t universe, uint8_t sequence, const uint8_t* data, uint16_t length) {
+    if (length > DMX_CHANNELS) length = DMX_CHANNELS;
+    const uint16_t padded = static_cast<uint16_t>((length + 1) & ~1);   // even length required
+    std::memcpy(out, ARTNET_ID, sizeof(ARTNET_ID));
+    out[8] = static_cast<uint8_t>(ART_OP_DMX);
+    out[9] = static_cast<uint8_t>(ART_OP_DMX >> 8);
+    putBe16(out + 10, ART_PROTOCOL);
+    out[12] = sequence;
+    out[13] = 0;                                          // physical port
+    out[14] = static_cast<uint8_t>(universe);             // SubUni
+    out[15] = static_cast<uint8_t>((universe >> 8) & 0x7F);   // Net
+    putBe16(out + 16, padded);
+    std::memcpy(out + ART_DMX_HEADER, data, length);           // only the caller's bytes
+    if (padded != length) out[ART_DMX_HEADER + length] = 0;
+    return ART_DMX_HEADER + padded;
+}
+
+size_t buildArtSync(uint8_t* out) {
+    std::memcpy(out, ARTNET_ID, sizeof(ARTNET_ID));
+    out[8] = static_cast<uint8_t>(ART_OP_SYNC);
+    out[9] = static_cast<uint8_t>(ART_OP_SYNC >> 8);
+    putBe16(out + 10, ART_PROTOCOL);
+    out[12] = 0;
+    out[13] = 0;
+    return ART_SYNC_SIZE;
+}
@@ -0,0 +1,228 @@
+// cpp/src/dmx_receiver.cpp
+#include "dmx_receiver.h"
+#include "frame_source.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+DmxReceiver::DmxReceiver(FrameTarget& target, const Params& params)
+    : _target(target),
+      _params(params),
+      _numLeds(target.numLeds())
+{
+    const bool e131 = _params.protocol == Protocol::E131;
+    if (_params.port <= 0) _params.port = e131 ? E131_PORT : ARTNET_PORT;
+    if (_params.startUniverse < 0) _params.startUniverse = e131 ? 1 : 0;
+    _params.ledsPerUniverse = std::clamp(_params.ledsPerUniverse, 1, LEDS_PER_UNIVERSE);
+    _universes = (_numLeds + _params.ledsPerUniverse - 1) / _params.ledsPerUniverse;
+
+    _frame.assign(_numLeds, RGB{0, 0, 0});
+    _received.assign((_universes + 63) / 64, 0);
+    _lastSeq.assign(_universes, 0);
+    _seqValid.assign(_universes, 0);
+
+    _buffers.resize(size_t(BATCH) * DMX_PACKET_MAX);
+    std::memset(_msgs, 0, sizeof(_msgs));
+    for (int i = 0; i < BATCH; ++i) {
+        _iov[i].iov_base = _buffers.data() + size_t(i) * DMX_PACKET_MAX;
+        _iov[i].iov_len = DMX_PACKET_MAX;
+        _msgs[i].msg_hdr.msg_iov = &_iov[i];
+        _msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+DmxReceiver::~DmxReceiver() {
+    stop();
+}
+
+// -----------------------------
+// Start / Stop
+// -----------------------------
+bool DmxReceiver::start() {
+    stop();
+    _fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_fd < 0 || _wakeFd < 0) {
+        perror("[DMX] socket");
+        stop();
+        return false;
+    }
+
+    int opt = 1;
+    setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    // room for a few frames of bursts while the thread is descheduled
+    int rcvbuf = RCVBUF_BYTES;
+    setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(_params.port);
+    if (bind(_fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror(("[DMX] bind " + std::to_string(_params.port)).c_str());
+        stop();
+        return false;
+    }
+    if (_params.protocol == Protocol::E131) joinMulticast();
+
+    _thread = std::thread(&DmxReceiver::loop, this);
+    pthread_setname_np(_thread.native_handle(), _params.protocol == Protocol::E131 ? "amb-e131" : "amb-artnet");
+    std::cout << "[DMX] " << name() << " on port " << _params.port << ", universes " << _params.startUniverse
+              << ".." << _params.startUniverse + _universes - 1 << std::endl;
+    return true;
+}
+
+void DmxReceiver::stop() {
+    if (_thread.joinable()) {
+        uint64_t one = 1;
+        if (write(_wakeFd, &one, sizeof(one)) < 0) perror("[DMX] wake");
+        _thread.join();
+    }
+    if (_fd >= 0) close(_fd);
+    if (_wakeFd >= 0) close(_wakeFd);
+    _fd = _wakeFd = -1;
+}
+
+// sACN multicast group 239.255.<universe hi>.<universe lo>; unicast works
+// without it, so a host without a multicast route only gets a warning
+void DmxReceiver::joinMulticast() {
+    for (int k = 0; k < _universes; ++k) {
+        const int u = _params.startUniverse + k;
+        ip_mreq mreq{};
+        mreq.imr_multiaddr.s_addr = htonl(0xEFFF0000u | (u & 0xFFFF));
+        mreq.imr_interface.s_addr = INADDR_ANY;
+        if (setsockopt(_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            perror("[DMX] multicast join (unicast only)");
+            return;
+        }
+    }
+}
+
+DmxReceiver::Stats DmxReceiver::stats() const {
+    Stats s;
+    s.packets = _packets.load(std::memory_order_relaxed);
+    s.batches = _batches.load(std::memory_order_relaxed);
+    s.frames = _frames.load(std::memory_order_relaxed);
+    s.partial = _partial.load(std::memory_order_relaxed);
+    s.stale = _stale.load(std::memory_order_relaxed);
+    s.ignored = _ignored.load(std::memory_order_relaxed);
+    return s;
+}
+
+// -----------------------------
+// Empfang
+// -----------------------------
+void DmxReceiver::loop() {
+    pollfd fds[2] = { { _fd, POLLIN, 0 }, { _wakeFd, POLLIN, 0 } };
+    for (;;) {
+        const int ready = poll(fds, 2, FRAME_TIMEOUT_MS);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            perror("[DMX] poll");
+            return;
+        }
+        if (fds[1].revents) return;
+
+        // drain the socket, BATCH datagrams per syscall
+        int n = BATCH;
+        while (n == BATCH) {
+            n = recvmmsg(_fd, _msgs, BATCH, MSG_DONTWAIT, nullptr);
+            if (n <= 0) {
+                if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) perror("[DMX] recvmmsg");
+                break;
+            }
+            _batches.fetch_add(1, std::memory_order_relaxed);
+            _packets.fetch_add(n, std::memory_order_relaxed);
+            const uint64_t now = monotonicNs();
+            for (int i = 0; i < n; ++i) {
+                if (_msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                    _ignored.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                handlePacket(static_cast<const uint8_t*>(_iov[i].iov_base), _msgs[i].msg_len, now);
+            }
+        }
+
+        // sender stopped mid-frame: show what arrived
+        const uint64_t now = monotonicNs();
+        if (_receivedCount > 0 && now - _lastSyncNs >= SYNC_TIMEOUT_NS &&
+            now - _frameStartNs >= uint64_t(FRAME_TIMEOUT_MS) * 1000000) {
+            render(false);
+        }
+    }
+}
+
+void DmxReceiver::handlePacket(const uint8_t* buf, size_t len, uint64_t now) {
+    DmxPacket pkt;
+    const bool e131 = _params.protocol == Protocol::E131;
+    if (!(e131 ? parseE131(buf, len, pkt) : parseArtNet(buf, len, pkt))) {
+        _ignored.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (pkt.type == DmxPacket::Type::Data) {
+        handleData(pkt, now);
+        return;
+    }
+
+    // sync: E1.31 only for the universe our data packets point at
+    if (e131 && (_syncAddress == 0 || pkt.universe != _syncAddress)) {
+        _ignored.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    _lastSyncNs = now;
+    if (_receivedCount > 0) render(_receivedCount == _universes);
+}
+
+void DmxReceiver::handleData(const DmxPacket& pkt, uint64_t now) {
+    const bool e131 = _params.protocol == Protocol::E131;
+    const int k = int(pkt.universe) - _params.startUniverse;
+    if (k < 0 || k >= _universes) {
+        _ignored.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Art-Net sequence 0 = sender does not number its packets
+    if (e131 || pkt.sequence != 0) {
+        if (_seqValid[k] && sequenceStale(_lastSeq[k], pkt.sequence)) {
+            _stale.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        _lastSeq[k] = pkt.sequence;
+        _seqValid[k] = 1;
+    }
+
+    if (e131) _syncAddress = pkt.syncAddress;
+    const bool synced = (!e131 || pkt.syncAddress != 0) && _lastSyncNs != 0 && now - _lastSyncNs < SYNC_TIMEOUT_NS;
+
+    uint64_t& word = _received[k >> 6];
+    const uint64_t bit = uint64_t(1) << (k & 63);
+    if ((word & bit) && !synced) render(false);   // next frame started before this one completed
+
+    const int first = k * _params.ledsPerUniverse;
+    const int leds = std::min(_params.ledsPerUniverse, _numLeds - first);
+    const size_t bytes = std::min<size_t>(pkt.length, size_t(leds) * 3);
+    std::memcpy(reinterpret_cast<uint8_t*>(_frame.data() + first), pkt.data, bytes);
+
+    if (!(word & bit)) {
+        word |= bit;
+        if (_receivedCount++ == 0) _frameStartNs = now;
+    }
+    if (!synced && _receivedCount == _universes) render(true);
+}
+
+void DmxReceiver::render(bool complete) {
+    _target.submitFrame(_frame);
+    (complete ? _frames : _partial).fetch_add(1, std::memory_order_relaxed);
+    std::fill(_received.begin(), _received.end(), 0);
+    _receivedCount = 0;
+}
@@ -0,0 +1,44 @@
+// cpp/src/downscale.cpp
+#include "downscale.h"
+
+// F is a compile-time power of two: the inner sum unrolls and the division
+// is a shift. The sum runs at a stride of 3 bytes, which -O3 does not
+// vectorize; a shuffle-free variant (log2(F) shifted adds over the
+// contiguous bytes) vectorizes but measured slower per row on x86, so the
+// scalar loop stays.
+template <int F, int SHIFT>
+static void boxFilterRowT(const uint8_t* src, uint8_t* dst, int outPixels) {
+    for (int x = 0; x < outPixels; ++x) {
+        const uint8_t* p = src + x * F * 3;
+        uint32_t r = 0, g = 0, b = 0;
+        for (int k = 0; k < F; ++k) {
+            r += p[k * 3 + 0];
+            g += p[k * 3 + 1];
+            b += p[k * 3 + 2];
+        }
+        uint8_t* d = dst + x * 3;
+        d[0] = static_cast<uint8_t>((r + F / 2) >> SHIFT);
+        d[1] = static_cast<uint8_t>((g + F / 2) >> SHIFT);
+        d[2] = static_cast<uint8_t>((b + F / 2) >> SHIFT);
+    }
+}
+
+void boxFilterRow(const uint8_t* src, uint8_t* dst, int outPixels, int factor) {
+    switch (factor) {
+        case 2: boxFilterRowT<2, 1>(src, dst, outPixels); break;
+        case 4: boxFilterRowT<4, 2>(src, dst, outPixels); break;
+        case 8: boxFilterRowT<8, 3>(src, dst, outPixels); break;
+        default:
+            for (int i = 0; i < outPixels * 3; ++i) dst[i] = src[i];
+            break;
+    }
+}
+
+void pointSampleRow(const uint8_t* src, uint8_t* dst, int outPixels, int factor) {
+    const uint8_t* p = src + (factor / 2) * 3;
+    for (int x = 0; x < outPixels; ++x, p += factor * 3) {
+        dst[x * 3 + 0] = p[0];
+        dst[x * 3 + 1] = p[1];
+        dst[x * 3 + 2] = p[2];
+    }
+}
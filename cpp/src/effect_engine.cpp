@@ -0,0 +1,490 @@
+// cpp/src/effect_engine.cpp
+#include "effect_engine.h"
+#include "frame_source.h"
+
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+// -----------------------------
+// Tabellen
+// -----------------------------
+// Built once on first use; the only libm calls in the engine.
+struct EffectTables
+{
+    uint8_t sine[256];            // 128 + 127 sin(2 pi i / 256)
+    uint8_t ease[256];            // smoothstep, for noise interpolation
+    uint8_t perm[256];            // noise lattice hash
+    RGB palettes[4][256];
+
+    EffectTables() {
+        for (int i = 0; i < 256; ++i) {
+            sine[i] = static_cast<uint8_t>(std::lround(128.0 + 127.0 * std::sin(i * 2.0 * M_PI / 256.0)));
+            const double t = i / 255.0;
+            ease[i] = static_cast<uint8_t>(std::lround(255.0 * t * t * (3.0 - 2.0 * t)));
+            perm[i] = static_cast<uint8_t>(i);
+        }
+        uint32_t seed = 1234567;
+        for (int i = 255; i > 0; --i) {
+            seed = seed * 1664525u + 1013904223u;
+            std::swap(perm[i], perm[(seed >> 16) % (i + 1)]);
+        }
+
+        // hue wheel, full saturation
+        for (int i = 0; i < 256; ++i) {
+            const uint8_t up = static_cast<uint8_t>(i * 6 % 256), down = static_cast<uint8_t>(255 - up);
+            RGB& c = palettes[int(Palette::Rainbow)][i];
+            switch (i * 6 / 256) {
+            case 0: c = RGB{255, up, 0}; break;
+            case 1: c = RGB{down, 255, 0}; break;
+            case 2: c = RGB{0, 255, up}; break;
+            case 3: c = RGB{0, down, 255}; break;
+            case 4: c = RGB{up, 0, 255}; break;
+            default: c = RGB{255, 0, down}; break;
+            }
+        }
+        gradient(Palette::Heat, { { 0, RGB{0, 0, 0} }, { 85, RGB{255, 0, 0} }, { 170, RGB{255, 255, 0} },
+                                  { 255, RGB{255, 255, 255} } });
+        gradient(Palette::Ocean, { { 0, RGB{0, 0, 32} }, { 96, RGB{0, 64, 160} }, { 176, RGB{0, 160, 200} },
+                                   { 255, RGB{180, 255, 255} } });
+        gradient(Palette::Forest, { { 0, RGB{0, 32, 0} }, { 96, RGB{16, 96, 16} }, { 176, RGB{96, 160, 32} },
+                                    { 255, RGB{200, 220, 96} } });
+    }
+
+    struct Stop
+    {
+        int index;
+        RGB color;
+    };
+
+    void gradient(Palette palette, std::initializer_list<Stop> stops) {
+        RGB* out = palettes[int(palette)];
+        const Stop* s = stops.begin();
+        for (int i = 0; i < 256; ++i) {
+            while (i > s[1].index) ++s;
+            const int span = s[1].index - s[0].index;
+            const int w = (i - s[0].index) * 256 / span;
+            auto mix = [w](uint8_t a, uint8_t b) { return static_cast<uint8_t>((a * (256 - w) + b * w) >> 8); };
+            out[i] = RGB{mix(s[0].color.r, s[1].color.r), mix(s[0].color.g, s[1].color.g),
+                         mix(s[0].color.b, s[1].color.b)};
+        }
+    }
+};
+
+static const EffectTables& tables() {
+    static const EffectTables t;
+    return t;
+}
+
+// t 0..255 -> weight 0..256, so t = 255 reaches b
+static inline uint8_t lerp8(uint8_t a, uint8_t b, uint32_t t) {
+    const uint32_t w = t + (t >> 7);
+    return static_cast<uint8_t>((a * (256 - w) + b * w) >> 8);
+}
+
+static inline RGB lerpRGB(const RGB& a, const RGB& b, uint32_t t) {
+    return RGB{lerp8(a.r, b.r, t), lerp8(a.g, b.g, t), lerp8(a.b, b.b, t)};
+}
+
+static inline uint8_t scale8(uint8_t v, uint32_t s) {
+    return static_cast<uint8_t>((v * (s + 1)) >> 8);
+}
+
+// -----------------------------
+// Parameter
+// -----------------------------
+static const struct { EffectType type; const char* name; } EFFECT_NAMES[] = {
+    { EffectType::Off, "off" },
+    { EffectType::Rainbow, "rainbow" },
+    { EffectType::Breathing, "breathing" },
+    { EffectType::Chase, "chase" },
+    { EffectType::Fire, "fire" },
+    { EffectType::Noise, "noise" },
+    { EffectType::Gradient, "gradient" },
+    { EffectType::Expression, "expr" },
+};
+
+static const struct { Palette palette; const char* name; } PALETTE_NAMES[] = {
+    { Palette::Rainbow, "rainbow" },
+    { Palette::Heat, "heat" },
+    { Palette::Ocean, "ocean" },
+    { Palette::Forest, "forest" },
+};
+
+const char* effectName(EffectType type) {
+    for (const auto& e : EFFECT_NAMES) {
+        if (e.type == type) return e.name;
+    }
+    return "?";
+}
+
+static EffectParams defaultsFor(EffectType type) {
+    EffectParams p;
+    p.type = type;
+    switch (type) {
+    case EffectType::Rainbow: p.speed = 0.1f; break;
+    case EffectType::Chase: p.speed = 0.5f; break;
+    case EffectType::Fire: p.speed = 1.0f; p.palette = Palette::Heat; break;
+    case EffectType::Noise: p.speed = 0.2f; p.palette = Palette::Ocean; break;
+    case EffectType::Gradient: p.speed = 0.1f; p.color2 = RGB{16, 32, 255}; break;
+    case EffectType::Expression: p.speed = 1.0f; break;
+    default: break;
+    }
+    return p;
+}
+
+static bool parseHexColor(std::string text, RGB& out) {
+    if (!text.empty() && text[0] == '#') text.erase(0, 1);
+    if (text.size() != 6 || text.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) return false;
+    const unsigned long v = std::stoul(text, nullptr, 16);
+    out = RGB{static_cast<uint8_t>(v >> 16), static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v)};
+    return true;
+}
+
+template <typename T>
+static bool parseNumber(const std::string& text, T& out) {
+    std::istringstream iss(text);
+    T v;
+    if (!(iss >> v) || !(iss >> std::ws).eof()) return false;
+    out = v;
+    return true;
+}
+
+bool parseEffect(const std::string& text, EffectParams& out, std::string& error) {
+    std::istringstream iss(text);
+    std::string name;
+    if (!(iss >> name)) {
+        error = "missing effect name";
+        return false;
+    }
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    const auto* e = std::find_if(std::begin(EFFECT_NAMES), std::end(EFFECT_NAMES),
+                                 [&](const auto& x) { return name == x.name; });
+    if (e == std::end(EFFECT_NAMES)) {
+        error = "unknown effect '" + name + "'";
+        return false;
+    }
+    EffectParams p = defaultsFor(e->type);
+
+    if (p.type == EffectType::Expression) {
+        std::string source;
+        std::getline(iss, source, '\0');
+        p.program = ExprProgram::compile(source, error);
+        if (!p.program) {
+            error = "expr: " + error;
+            return false;
+        }
+        out = p;
+        return true;
+    }
+    std::string arg;
+    while (iss >> arg) {
+        const size_t eq = arg.find('=');
+        const std::string key = arg.substr(0, eq);
+        const std::string val = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        bool ok = false;
+        if (key == "speed") ok = parseNumber(val, p.speed) && p.speed >= 0.0f && p.speed <= 16.0f;
+        else if (key == "scale") ok = parseNumber(val, p.scale) && p.scale > 0.0f && p.scale <= 64.0f;
+        else if (key == "color") ok = parseHexColor(val, p.color);
+        else if (key == "color2") ok = parseHexColor(val, p.color2);
+        else if (key == "size") ok = parseNumber(val, p.size) && p.size > 0;
+        else if (key == "cooling") ok = parseNumber(val, p.cooling) && p.cooling >= 0 && p.cooling <= 255;
+        else if (key == "sparking") ok = parseNumber(val, p.sparking) && p.sparking >= 0 && p.sparking <= 255;
+        else if (key == "palette") {
+            for (const auto& pn : PALETTE_NAMES) {
+                if (val == pn.name) {
+                    p.palette = pn.palette;
+                    ok = true;
+                }
+            }
+        }
+        if (!ok) {
+            error = "bad parameter '" + arg + "'";
+            return false;
+        }
+    }
+    out = p;
+    return true;
+}
+
+// -----------------------------
+// EffectEngine
+// -----------------------------
+EffectEngine::EffectEngine(FrameTarget& target, int rateHz)
+    : _target(target),
+      _rateHz(std::max(1, rateHz)),
+      _frame(target.numLeds())
+{
+    tables();
+}
+
+EffectEngine::~EffectEngine() {
+    stop();
+}
+
+bool EffectEngine::start() {
+    stop();
+    _timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_timerFd < 0 || _wakeFd < 0) {
+        perror("[Effects] timerfd");
+        stop();
+        return false;
+    }
+    _stopping = false;
+    _changed = true;        // arm for an effect set before start()
+    wake();                 // ... which the first poll would otherwise wait out
+    _thread = std::thread(&EffectEngine::loop, this);
+    pthread_setname_np(_thread.native_handle(), "amb-effects");
+    return true;
+}
+
+void EffectEngine::stop() {
+    if (_thread.joinable()) {
+        _stopping = true;
+        wake();
+        _thread.join();
+    }
+    if (_timerFd >= 0) close(_timerFd);
+    if (_wakeFd >= 0) close(_wakeFd);
+    _timerFd = _wakeFd = -1;
+}
+
+void EffectEngine::wake() {
+    uint64_t one = 1;
+    if (_wakeFd >= 0 && write(_wakeFd, &one, sizeof(one)) < 0) perror("[Effects] wake");
+}
+
+void EffectEngine::set(const EffectParams& params) {
+    {
+        std::lock_guard<std::mutex> lock(_paramsMutex);
+        _pending = params;
+    }
+    _changed.store(true, std::memory_order_release);
+    wake();
+}
+
+bool EffectEngine::command(const std::string& text, std::string& error) {
+    EffectParams p;
+    if (!parseEffect(text, p, error)) return false;
+    set(p);
+    return true;
+}
+
+EffectParams EffectEngine::params() const {
+    std::lock_guard<std::mutex> lock(_paramsMutex);
+    return _pending;
+}
+
+EffectEngine::Stats EffectEngine::stats() const {
+    Stats s;
+    s.type = static_cast<EffectType>(_activeType.load(std::memory_order_relaxed));
+    s.frames = _frames.load(std::memory_order_relaxed);
+    s.late = _late.load(std::memory_order_relaxed);
+    s.renderNs = _renderNs.load(std::memory_order_relaxed);
+    s.maxRenderNs = _maxRenderNs.load(std::memory_order_relaxed);
+    return s;
+}
+
+// -----------------------------
+// Render-Thread
+// -----------------------------
+bool EffectEngine::arm(bool on) {
+    itimerspec spec{};
+    if (on) {
+        // tv_nsec must stay below one second, so 1 Hz goes into tv_sec
+        const long periodNs = 1000000000L / _rateHz;
+        spec.it_interval.tv_sec = periodNs / 1000000000L;
+        spec.it_interval.tv_nsec = periodNs % 1000000000L;
+        spec.it_value.tv_nsec = 1;     // first frame right away
+    }
+    if (timerfd_settime(_timerFd, 0, &spec, nullptr) < 0) {
+        perror("[Effects] timerfd_settime");
+        return false;
+    }
+    return true;
+}
+
+void EffectEngine::apply(const EffectParams& params) {
+    const int n = static_cast<int>(_frame.size());
+    if (params.type != _params.type) {
+        _phase = 0;
+        _lastNs = 0;
+        _heat.assign(n, 0);
+        std::cout << "[Effects] " << effectName(params.type) << std::endl;
+    }
+    _params = params;
+    _turnsQ32 = static_cast<uint64_t>(params.speed * 4294967296.0);
+    _ledStep = static_cast<uint32_t>(std::min(4294967295.0, params.scale * 4294967296.0 / std::max(1, n)));
+    _activeType.store(static_cast<uint8_t>(params.type), std::memory_order_relaxed);
+}
+
+void EffectEngine::loop() {
+    pollfd fds[2] = { { _timerFd, POLLIN, 0 }, { _wakeFd, POLLIN, 0 } };
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("[Effects] poll");
+            return;
+        }
+        if (fds[1].revents) {
+            uint64_t count;
+            if (read(_wakeFd, &count, sizeof(count)) < 0 && errno != EAGAIN) perror("[Effects] read");
+            if (_stopping) return;
+        }
+        if (_changed.exchange(false, std::memory_order_acq_rel)) {
+            EffectParams p;
+            {
+                std::lock_guard<std::mutex> lock(_paramsMutex);
+                p = _pending;
+            }
+            const bool wasOn = _params.type != EffectType::Off;
+            apply(p);
+            arm(p.type != EffectType::Off);
+            if (wasOn && p.type == EffectType::Off) _target.release();
+        }
+        if (!fds[0].revents) continue;
+
+        uint64_t ticks = 0;
+        if (read(_timerFd, &ticks, sizeof(ticks)) != sizeof(ticks)) continue;   // disarmed meanwhile
+        if (ticks > 1) _late.fetch_add(ticks - 1, std::memory_order_relaxed);
+        if (_params.type == EffectType::Off) continue;
+
+        const uint64_t t0 = monotonicNs();
+        const std::vector<RGB>& frame = render(t0);
+        const uint64_t ns = monotonicNs() - t0;
+        _frames.fetch_add(1, std::memory_order_relaxed);
+        _renderNs.fetch_add(ns, std::memory_order_relaxed);
+        if (ns > _maxRenderNs.load(std::memory_order_relaxed)) _maxRenderNs.store(ns, std::memory_order_relaxed);
+        _target.submitFrame(frame);
+    }
+}
+
+const std::vector<RGB>& EffectEngine::render(uint64_t nowNs) {
+    const uint64_t dt = (_lastNs && nowNs > _lastNs) ? std::min(nowNs - _lastNs, MAX_STEP_NS) : 0;
+    _lastNs = nowNs;
+    const uint64_t before = _phase;
+    _phase += _turnsQ32 * (dt / 1000) / 1000000;     // Q32 turns/s * us
+
+    switch (_params.type) {
+    case EffectType::Off: std::fill(_frame.begin(), _frame.end(), RGB{0, 0, 0}); break;
+    case EffectType::Rainbow: renderRainbow(); break;
+    case EffectType::Breathing: renderBreathing(); break;
+    case EffectType::Chase: renderChase(); break;
+    case EffectType::Fire:
+        // 64 simulation steps per turn
+        renderFire(std::min<uint64_t>((_phase >> 26) - (before >> 26), MAX_FIRE_STEPS));
+        break;
+    case EffectType::Noise: renderNoise(); break;
+    case EffectType::Gradient: renderGradient(); break;
+    case EffectType::Expression: renderExpression(); break;
+    }
+    return _frame;
+}
+
+// -----------------------------
+// Effekte
+// -----------------------------
+// Angles are the low 32 bits of the phase; the top 8 bits index a table.
+void EffectEngine::renderRainbow() {
+    const RGB* palette = tables().palettes[int(_params.palette)];
+    uint32_t p = static_cast<uint32_t>(_phase);
+    for (RGB& c : _frame) {
+        c = palette[p >> 24];
+        p += _ledStep;
+    }
+}
+
+void EffectEngine::renderBreathing() {
+    const uint32_t level = tables().sine[static_cast<uint32_t>(_phase) >> 24];
+    const RGB& c = _params.color;
+    std::fill(_frame.begin(), _frame.end(), RGB{scale8(c.r, level), scale8(c.g, level), scale8(c.b, level)});
+}
+
+// head moves one lap per turn, with a tail of size LEDs fading behind it
+// and the LED ahead lit by the fractional position (no stepping at low speed).
+// The tail stops short of that LED on short strips instead of wrapping onto it.
+void EffectEngine::renderChase() {
+    const int n = static_cast<int>(_frame.size());
+    std::fill(_frame.begin(), _frame.end(), _params.color2);
+    if (n == 0) return;
+    const uint32_t head = static_cast<uint32_t>((static_cast<uint64_t>(static_cast<uint32_t>(_phase)) * n) >> 24);  // Q8 LEDs
+    const int size = std::max(0, std::min(_params.size, n - 2));
+    const uint32_t frac = head & 0xFF;
+    const uint32_t len = static_cast<uint32_t>(size + 1) << 8;
+    const int first = static_cast<int>(head >> 8);
+    _frame[(first + 1) % n] = lerpRGB(_params.color2, _params.color, frac);
+    for (int k = 0; k <= size; ++k) {
+        const uint32_t d = (static_cast<uint32_t>(k) << 8) + frac;
+        if (d >= len) break;
+        _frame[(first - k + n) % n] = lerpRGB(_params.color2, _params.color, 255 - d * 255 / len);
+    }
+}
+
+// Fire2012: cool every cell, heat drifts up (away from LED 0), random
+// sparks near the bottom; heat indexes the palette
+void EffectEngine::renderFire(uint64_t steps) {
+    const int n = static_cast<int>(_heat.size());
+    const int coolMax = std::min(255, _params.cooling * 10 / std::max(1, n) + 2);
+    for (uint64_t s = 0; s < steps; ++s) {
+        for (uint8_t& h : _heat) {
+            const int cool = random8() % coolMax;
+            h = static_cast<uint8_t>(h > cool ? h - cool : 0);
+        }
+        for (int k = n - 1; k >= 2; --k) {
+            _heat[k] = static_cast<uint8_t>((_heat[k - 1] + 2 * _heat[k - 2]) / 3);
+        }
+        if (n > 0 && random8() < _params.sparking) {
+            const int y = random8() % std::min(7, n);
+            _heat[y] = static_cast<uint8_t>(std::min(255, _heat[y] + 160 + random8() % 96));
+        }
+    }
+    const RGB* palette = tables().palettes[int(_params.palette)];
+    for (int i = 0; i < n; ++i) _frame[i] = palette[_heat[i]];
+}
+
+// 2D value noise (LED position x time) on a byte lattice, smoothstep
+// interpolated; 8 x scale lattice cells across the strip, one per turn
+void EffectEngine::renderNoise() {
+    const EffectTables& t = tables();
+    const RGB* palette = t.palettes[int(_params.palette)];
+    auto hash = [&t](uint32_t x, uint32_t y) -> uint8_t { return t.perm[(t.perm[x & 0xFF] + y) & 0xFF]; };
+
+    const uint32_t time = static_cast<uint32_t>(_phase >> 24);      // Q8 cells
+    const uint32_t ty = time >> 8;
+    const uint32_t tf = t.ease[time & 0xFF];
+    const uint32_t step = _ledStep >> 13;                            // Q16 cells per LED
+    uint32_t x = 0;
+    for (RGB& c : _frame) {
+        const uint32_t xi = x >> 16;
+        const uint32_t xf = t.ease[(x >> 8) & 0xFF];
+        const uint8_t a = lerp8(hash(xi, ty), hash(xi + 1, ty), xf);
+        const uint8_t b = lerp8(hash(xi, ty + 1), hash(xi + 1, ty + 1), xf);
+        c = palette[lerp8(a, b, tf)];
+        x += step;
+    }
+}
+
+// color -> color2 -> color once per repeat (triangle wave), scrolling
+void EffectEngine::renderGradient() {
+    uint32_t p = static_cast<uint32_t>(_phase);
+    for (RGB& c : _frame) {
+        const uint32_t t9 = p >> 23;
+        c = lerpRGB(_params.color, _params.color2, (t9 & 0x100) ? 511 - t9 : t9);
+        p += _ledStep;
+    }
+}
+
+// t = turns at speed, i.e. seconds at the default speed 1
+void EffectEngine::renderExpression() {
+    _vm.run(*_params.program, static_cast<float>(static_cast<double>(_phase) / 4294967296.0), _frame);
+}
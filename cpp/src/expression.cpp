@@ -0,0 +1,424 @@
+// cpp/src/expression.cpp
+#include "expression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using Op = ExprProgram::Op;
+static constexpr int BATCH = ExprProgram::BATCH;
+
+// -----------------------------
+// Mathe (skalar + Lanes)
+// -----------------------------
+// No branches or float selects: with the default -ftrapping-math the
+// compiler won't if-convert float comparisons feeding arithmetic, which
+// would keep the lane loops below from vectorizing. Constant folding uses
+// the same functions, so folded and evaluated results match.
+
+// round to nearest by adding and removing 1.5 * 2^23, then correct by the
+// comparison as an integer; exact for |v| < 2^22
+static inline float exprFloor(float v) {
+    const float r = (v + 12582912.0f) - 12582912.0f;
+    const int32_t above = r > v;
+    return r - static_cast<float>(above);
+}
+
+// reduce to [-pi, pi], odd Taylor polynomial to y^13, |error| < 2e-4
+static inline float exprSin(float v) {
+    float u = v * 0.159154943f;                      // turns
+    u -= exprFloor(u + 0.5f);                        // -0.5 .. 0.5
+    const float y = u * 6.28318531f;
+    const float y2 = y * y;
+    return y * (1.0f + y2 * (-1.66666667e-1f + y2 * (8.33333333e-3f + y2 * (-1.98412698e-4f +
+           y2 * (2.75573192e-6f + y2 * (-2.50521084e-8f + y2 * 1.60590438e-10f))))));
+}
+
+float ExprProgram::evalScalar(Op op, float a, float b, float c) {
+    switch (op) {
+    case Op::Add: return a + b;
+    case Op::Sub: return a - b;
+    case Op::Mul: return a * b;
+    case Op::Div: return a / b;
+    case Op::Mod: return a - b * exprFloor(a / b);
+    case Op::Less: return a < b ? 1.0f : 0.0f;
+    case Op::Greater: return a > b ? 1.0f : 0.0f;
+    case Op::Neg: return -a;
+    case Op::Sin: return exprSin(a);
+    case Op::Cos: return exprSin(a + 1.57079633f);
+    case Op::Abs: return std::fabs(a);
+    case Op::Floor: return exprFloor(a);
+    case Op::Fract: return a - exprFloor(a);
+    case Op::Sqrt: return std::sqrt(a > 0.0f ? a : 0.0f);
+    case Op::Min: return a < b ? a : b;
+    case Op::Max: return a > b ? a : b;
+    case Op::Step: return b < a ? 0.0f : 1.0f;
+    case Op::Clamp: return a < b ? b : (a > c ? c : a);
+    case Op::Mix: return a + (b - a) * c;
+    }
+    return 0.0f;
+}
+
+// -----------------------------
+// Compiler
+// -----------------------------
+static const struct { const char* name; Op op; int arity; } FUNCTIONS[] = {
+    { "sin", Op::Sin, 1 },     { "cos", Op::Cos, 1 },     { "abs", Op::Abs, 1 },
+    { "floor", Op::Floor, 1 }, { "fract", Op::Fract, 1 }, { "sqrt", Op::Sqrt, 1 },
+    { "min", Op::Min, 2 },     { "max", Op::Max, 2 },     { "step", Op::Step, 2 },
+    { "clamp", Op::Clamp, 3 }, { "mix", Op::Mix, 3 },
+};
+
+class ExprCompiler
+{
+public:
+    ExprCompiler(const std::string& text, ExprProgram& program) : _text(text), _p(program) {}
+
+    bool compile(std::string& error);
+
+private:
+    // a value known at compile time, or a register
+    struct Operand
+    {
+        bool constant = true;
+        float value = 0.0f;
+        uint8_t reg = 0;
+    };
+
+    const std::string& _text;
+    ExprProgram& _p;
+    size_t _pos = 0;
+    std::string _error;
+    size_t _errorPos = 0;
+    int _depth = 0;                     // unary() nesting, bounded by MAX_DEPTH
+    std::vector<std::pair<std::string, Operand>> _locals;
+    Operand _outputs[3];
+
+    bool fail(const std::string& message) {
+        if (_error.empty()) {
+            _error = message;
+            _errorPos = _pos;
+        }
+        return false;
+    }
+
+    // newlines separate statements, so only blanks are skipped inside one
+    void skipBlanks() {
+        while (_pos < _text.size() && (_text[_pos] == ' ' || _text[_pos] == '\t' || _text[_pos] == '\r')) ++_pos;
+    }
+    bool accept(char c) {
+        skipBlanks();
+        if (_pos < _text.size() && _text[_pos] == c) {
+            ++_pos;
+            return true;
+        }
+        return false;
+    }
+    bool expect(char c) { return accept(c) || fail(std::string("expected '") + c + "'"); }
+    bool identifier(std::string& out);
+
+    bool statement();
+    bool expression(Operand& out);
+    bool additive(Operand& out);
+    bool multiplicative(Operand& out);
+    bool unary(Operand& out);
+    bool primary(Operand& out);
+    bool call(const std::string& name, Operand& out);
+
+    bool emit(Op op, const Operand* args, int arity, Operand& out);
+    bool newRegister(uint8_t& reg);
+    bool toRegister(const Operand& v, uint8_t& reg);
+};
+
+bool ExprCompiler::identifier(std::string& out) {
+    skipBlanks();
+    const size_t start = _pos;
+    if (_pos >= _text.size() || !(std::isalpha(static_cast<unsigned char>(_text[_pos])) || _text[_pos] == '_')) {
+        return false;
+    }
+    while (_pos < _text.size() && (std::isalnum(static_cast<unsigned char>(_text[_pos])) || _text[_pos] == '_')) ++_pos;
+    out = _text.substr(start, _pos - start);
+    return true;
+}
+
+bool ExprCompiler::compile(std::string& error) {
+    int statements = 0;
+    for (;;) {
+        while (_pos < _text.size() && (std::isspace(static_cast<unsigned char>(_text[_pos])) || _text[_pos] == ';')) ++_pos;
+        if (_pos >= _text.size()) break;
+        if (!statement()) break;
+        ++statements;
+    }
+    if (_error.empty() && statements == 0) fail("no statements");
+    for (int k = 0; k < 3 && _error.empty(); ++k) toRegister(_outputs[k], _p._out[k]);
+    if (!_error.empty()) {
+        error = "col " + std::to_string(_errorPos + 1) + ": " + _error;
+        return false;
+    }
+    return true;
+}
+
+bool ExprCompiler::statement() {
+    std::string name;
+    if (!identifier(name)) return fail("expected a name");
+    if (name == "t" || name == "i" || name == "n" || name == "x") return fail("'" + name + "' is an input");
+    Operand value;
+    if (!expect('=') || !expression(value)) return false;
+    skipBlanks();
+    if (_pos < _text.size() && _text[_pos] != ';' && _text[_pos] != '\n') return fail("expected ';' or end of line");
+
+    if (name == "r") _outputs[0] = value;
+    else if (name == "g") _outputs[1] = value;
+    else if (name == "b") _outputs[2] = value;
+    for (auto& local : _locals) {
+        if (local.first == name) {
+            local.second = value;       // a new register, earlier reads keep the old one
+            return true;
+        }
+    }
+    _locals.emplace_back(name, value);
+    return true;
+}
+
+bool ExprCompiler::expression(Operand& out) {
+    if (!additive(out)) return false;
+    for (;;) {
+        Op op;
+        if (accept('<')) op = Op::Less;
+        else if (accept('>')) op = Op::Greater;
+        else return true;
+        Operand args[2] = { out, {} };
+        if (!additive(args[1]) || !emit(op, args, 2, out)) return false;
+    }
+}
+
+bool ExprCompiler::additive(Operand& out) {
+    if (!multiplicative(out)) return false;
+    for (;;) {
+        Op op;
+        if (accept('+')) op = Op::Add;
+        else if (accept('-')) op = Op::Sub;
+        else return true;
+        Operand args[2] = { out, {} };
+        if (!multiplicative(args[1]) || !emit(op, args, 2, out)) return false;
+    }
+}
+
+bool ExprCompiler::multiplicative(Operand& out) {
+    if (!unary(out)) return false;
+    for (;;) {
+        Op op;
+        if (accept('*')) op = Op::Mul;
+        else if (accept('/')) op = Op::Div;
+        else if (accept('%')) op = Op::Mod;
+        else return true;
+        Operand args[2] = { out, {} };
+        if (!unary(args[1]) || !emit(op, args, 2, out)) return false;
+    }
+}
+
+// every nesting (parentheses, function arguments, unary minus) passes
+// through here, so this is where the recursion depth is counted
+bool ExprCompiler::unary(Operand& out) {
+    if (_depth >= ExprProgram::MAX_DEPTH) return fail("expression too deep");
+    ++_depth;
+    bool ok;
+    if (accept('-')) {
+        Operand arg;
+        ok = unary(arg) && emit(Op::Neg, &arg, 1, out);
+    } else {
+        ok = primary(out);
+    }
+    --_depth;
+    return ok;
+}
+
+bool ExprCompiler::primary(Operand& out) {
+    skipBlanks();
+    if (accept('(')) return expression(out) && expect(')');
+
+    if (_pos < _text.size() && (std::isdigit(static_cast<unsigned char>(_text[_pos])) || _text[_pos] == '.')) {
+        const char* start = _text.c_str() + _pos;
+        char* end = nullptr;
+        const float v = std::strtof(start, &end);
+        if (end == start) return fail("bad number");
+        _pos += end - start;
+        out = Operand{};
+        out.value = v;
+        return true;
+    }
+
+    std::string name;
+    if (!identifier(name)) return fail("expected a value");
+    if (accept('(')) return call(name, out);
+    for (const auto& local : _locals) {
+        if (local.first == name) {
+            out = local.second;
+            return true;
+        }
+    }
+    static const struct { const char* name; uint8_t reg; } INPUTS[] = {
+        { "t", ExprProgram::REG_T }, { "i", ExprProgram::REG_I }, { "n", ExprProgram::REG_N }, { "x", ExprProgram::REG_X },
+    };
+    for (const auto& in : INPUTS) {
+        if (name == in.name) {
+            out.constant = false;
+            out.reg = in.reg;
+            return true;
+        }
+    }
+    return fail("unknown name '" + name + "'");
+}
+
+bool ExprCompiler::call(const std::string& name, Operand& out) {
+    for (const auto& f : FUNCTIONS) {
+        if (name != f.name) continue;
+        Operand args[3];
+        for (int k = 0; k < f.arity; ++k) {
+            if (k > 0 && !expect(',')) return false;
+            if (!expression(args[k])) return false;
+        }
+        return expect(')') && emit(f.op, args, f.arity, out);
+    }
+    return fail("unknown function '" + name + "'");
+}
+
+bool ExprCompiler::emit(Op op, const Operand* args, int arity, Operand& out) {
+    bool constant = true;
+    for (int k = 0; k < arity; ++k) constant = constant && args[k].constant;
+    if (constant) {
+        out = Operand{};
+        out.value = ExprProgram::evalScalar(op, args[0].value, arity > 1 ? args[1].value : 0.0f,
+                                            arity > 2 ? args[2].value : 0.0f);
+        return true;
+    }
+    ExprProgram::Instr in{op, 0, 0, 0, 0};
+    uint8_t* regs[3] = { &in.a, &in.b, &in.c };
+    for (int k = 0; k < arity; ++k) {
+        if (!toRegister(args[k], *regs[k])) return false;
+    }
+    if (!newRegister(in.dst)) return false;
+    _p._code.push_back(in);
+    out.constant = false;
+    out.reg = in.dst;
+    return true;
+}
+
+bool ExprCompiler::newRegister(uint8_t& reg) {
+    if (_p._registers >= ExprProgram::MAX_REGISTERS) return fail("expression too long");
+    reg = static_cast<uint8_t>(_p._registers++);
+    return true;
+}
+
+// constants get one register each, shared by equal values
+bool ExprCompiler::toRegister(const Operand& v, uint8_t& reg) {
+    if (!v.constant) {
+        reg = v.reg;
+        return true;
+    }
+    for (const auto& c : _p._constants) {
+        if (std::memcmp(&c.second, &v.value, sizeof(float)) == 0) {
+            reg = c.first;
+            return true;
+        }
+    }
+    if (!newRegister(reg)) return false;
+    _p._constants.emplace_back(reg, v.value);
+    return true;
+}
+
+std::shared_ptr<const ExprProgram> ExprProgram::compile(const std::string& text, std::string& error) {
+    static std::atomic<uint64_t> nextId{1};
+    if (text.size() > MAX_SOURCE) {
+        error = "col " + std::to_string(MAX_SOURCE + 1) + ": longer than " + std::to_string(MAX_SOURCE) + " characters";
+        return nullptr;
+    }
+    auto program = std::make_shared<ExprProgram>();
+    program->_source = text;
+    ExprCompiler compiler(text, *program);
+    if (!compiler.compile(error)) return nullptr;
+    program->_id = nextId.fetch_add(1, std::memory_order_relaxed);
+    return program;
+}
+
+// -----------------------------
+// VM
+// -----------------------------
+template <typename F>
+static inline void lanes(float* d, const float* a, F f) {
+    for (int k = 0; k < BATCH; ++k) d[k] = f(a[k]);
+}
+
+template <typename F>
+static inline void lanes(float* d, const float* a, const float* b, F f) {
+    for (int k = 0; k < BATCH; ++k) d[k] = f(a[k], b[k]);
+}
+
+template <typename F>
+static inline void lanes(float* d, const float* a, const float* b, const float* c, F f) {
+    for (int k = 0; k < BATCH; ++k) d[k] = f(a[k], b[k], c[k]);
+}
+
+static inline uint8_t toByte(float v) {
+    return static_cast<uint8_t>((v > 0.0f ? (v < 255.0f ? v : 255.0f) : 0.0f) + 0.5f);   // NaN -> 0
+}
+
+void ExprVM::run(const ExprProgram& program, float t, std::vector<RGB>& frame) {
+    if (_loaded != program._id) {
+        _regs.assign(static_cast<size_t>(program._registers) * BATCH, 0.0f);
+        for (const auto& c : program._constants) std::fill_n(reg(c.first), BATCH, c.second);
+        _loaded = program._id;
+    }
+    const int count = static_cast<int>(frame.size());
+    const float n = static_cast<float>(count);
+    const float invN = count ? 1.0f / n : 0.0f;
+    std::fill_n(reg(ExprProgram::REG_T), BATCH, t);
+    std::fill_n(reg(ExprProgram::REG_N), BATCH, n);
+    float* ri = reg(ExprProgram::REG_I);
+    float* rx = reg(ExprProgram::REG_X);
+
+    for (int base = 0; base < count; base += BATCH) {
+        for (int k = 0; k < BATCH; ++k) {
+            ri[k] = static_cast<float>(base + k);
+            rx[k] = ri[k] * invN;
+        }
+        for (const ExprProgram::Instr& in : program._code) {
+            float* d = reg(in.dst);
+            const float* a = reg(in.a);
+            const float* b = reg(in.b);
+            const float* c = reg(in.c);
+            switch (in.op) {
+            case Op::Add: lanes(d, a, b, [](float x, float y) { return x + y; }); break;
+            case Op::Sub: lanes(d, a, b, [](float x, float y) { return x - y; }); break;
+            case Op::Mul: lanes(d, a, b, [](float x, float y) { return x * y; }); break;
+            case Op::Div: lanes(d, a, b, [](float x, float y) { return x / y; }); break;
+            case Op::Mod: lanes(d, a, b, [](float x, float y) { return x - y * exprFloor(x / y); }); break;
+            case Op::Less: lanes(d, a, b, [](float x, float y) { return x < y ? 1.0f : 0.0f; }); break;
+            case Op::Greater: lanes(d, a, b, [](float x, float y) { return x > y ? 1.0f : 0.0f; }); break;
+            case Op::Neg: lanes(d, a, [](float x) { return -x; }); break;
+            case Op::Sin: lanes(d, a, [](float x) { return exprSin(x); }); break;
+            case Op::Cos: lanes(d, a, [](float x) { return exprSin(x + 1.57079633f); }); break;
+            case Op::Abs: lanes(d, a, [](float x) { return std::fabs(x); }); break;
+            case Op::Floor: lanes(d, a, [](float x) { return exprFloor(x); }); break;
+            case Op::Fract: lanes(d, a, [](float x) { return x - exprFloor(x); }); break;
+            case Op::Sqrt: lanes(d, a, [](float x) { return std::sqrt(x > 0.0f ? x : 0.0f); }); break;
+            case Op::Min: lanes(d, a, b, [](float x, float y) { return x < y ? x : y; }); break;
+            case Op::Max: lanes(d, a, b, [](float x, float y) { return x > y ? x : y; }); break;
+            case Op::Step: lanes(d, a, b, [](float e, float x) { return x < e ? 0.0f : 1.0f; }); break;
+            case Op::Clamp:
+                lanes(d, a, b, c, [](float x, float lo, float hi) { return x < lo ? lo : (x > hi ? hi : x); });
+                break;
+            case Op::Mix: lanes(d, a, b, c, [](float x, float y, float f) { return x + (y - x) * f; }); break;
+            }
+        }
+        const float* r = reg(program._out[0]);
+        const float* g = reg(program._out[1]);
+        const float* b = reg(program._out[2]);
+        const int end = std::min(BATCH, count - base);
+        RGB* out = frame.data() + base;
+        for (int k = 0; k < end; ++k) out[k] = RGB{toByte(r[k]), toByte(g[k]), toByte(b[k])};
+    }
+}
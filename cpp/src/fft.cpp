@@ -0,0 +1,78 @@
+// cpp/src/fft.cpp
+#include "fft.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+RealFft::RealFft(int size)
+    : _n(size)
+{
+    if (size < 16 || (size & (size - 1)) != 0) {
+        throw std::invalid_argument("FFT size " + std::to_string(size) + " is not a power of two >= 16");
+    }
+    const int m = _n / 2;
+    _twRe.resize(m / 2);
+    _twIm.resize(m / 2);
+    for (int j = 0; j < m / 2; ++j) {
+        const double a = -2.0 * M_PI * j / m;
+        _twRe[j] = static_cast<float>(std::cos(a));
+        _twIm[j] = static_cast<float>(std::sin(a));
+    }
+    _splitRe.resize(m + 1);
+    _splitIm.resize(m + 1);
+    for (int k = 0; k <= m; ++k) {
+        const double a = -2.0 * M_PI * k / _n;
+        _splitRe[k] = static_cast<float>(std::cos(a));
+        _splitIm[k] = static_cast<float>(std::sin(a));
+    }
+    int bits = 0;
+    while ((1 << bits) < m) ++bits;
+    _bitrev.resize(m);
+    for (int i = 0; i < m; ++i) {
+        uint32_t r = 0;
+        for (int b = 0; b < bits; ++b) r |= ((i >> b) & 1u) << (bits - 1 - b);
+        _bitrev[i] = r;
+    }
+    _re.resize(m);
+    _im.resize(m);
+}
+
+void RealFft::power(const float* in, float* out) {
+    const int m = _n / 2;
+    // pack even/odd samples, bit-reversed
+    for (int i = 0; i < m; ++i) {
+        _re[_bitrev[i]] = in[2 * i];
+        _im[_bitrev[i]] = in[2 * i + 1];
+    }
+
+    // radix-2 DIT butterflies, twiddle stride halves every stage
+    for (int half = 1, stride = m / 2; half < m; half *= 2, stride /= 2) {
+        for (int start = 0; start < m; start += 2 * half) {
+            for (int j = 0; j < half; ++j) {
+                const float wr = _twRe[j * stride], wi = _twIm[j * stride];
+                const int a = start + j, b = a + half;
+                const float tr = _re[b] * wr - _im[b] * wi;
+                const float ti = _re[b] * wi + _im[b] * wr;
+                _re[b] = _re[a] - tr;
+                _im[b] = _im[a] - ti;
+                _re[a] += tr;
+                _im[a] += ti;
+            }
+        }
+    }
+
+    // split: X[k] = E[k] + W^k O[k] with E, O from Z[k] and conj(Z[m - k])
+    for (int k = 0; k <= m; ++k) {
+        const int ka = k == m ? 0 : k;
+        const int kb = k == 0 ? 0 : m - k;
+        const float ar = _re[ka], ai = _im[ka];
+        const float zr = _re[kb], zi = _im[kb];
+        const float er = 0.5f * (ar + zr), ei = 0.5f * (ai - zi);
+        const float orr = 0.5f * (ai + zi), oi = -0.5f * (ar - zr);
+        const float xr = er + _splitRe[k] * orr - _splitIm[k] * oi;
+        const float xi = ei + _splitRe[k] * oi + _splitIm[k] * orr;
+        out[k] = xr * xr + xi * xi;
+    }
+}
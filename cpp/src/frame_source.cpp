@@ -0,0 +1,61 @@
+// cpp/src/frame_source.cpp
+#include "frame_source.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+uint64_t monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// -----------------------------
+// FramePacer
+// -----------------------------
+FramePacer::FramePacer(double fps)
+    : _periodNs(fps > 0.0 ? static_cast<uint64_t>(1e9 / fps) : 0)
+{
+}
+
+void FramePacer::wait() {
+    if (_periodNs == 0) return;
+    const uint64_t now = monotonicNs();
+    if (_next > now) std::this_thread::sleep_for(std::chrono::nanoseconds(_next - now));
+    _next = std::max(_next, now) + _periodNs;
+}
+
+// -----------------------------
+// DummySource
+// -----------------------------
+DummySource::DummySource(int width, int height, int fps)
+    : _width(std::max(1, width)),
+      _height(std::max(1, height)),
+      _pacer(std::max(1, fps))
+{
+}
+
+bool DummySource::capture(Frame& frame) {
+    _pacer.wait();
+
+    frame.timestampNs = monotonicNs();
+    frame.mediaNs = frame.timestampNs;
+    frame.width = _width;
+    frame.height = _height;
+    frame.seq = _seq;
+    frame.external = nullptr;
+    frame.data.resize(static_cast<size_t>(_width) * _height * 3);
+
+    // Fake animation pattern
+    const double t = static_cast<double>(_seq++);
+    const uint8_t r = static_cast<uint8_t>((std::sin(t * 0.05) * 0.5 + 0.5) * 255);
+    const uint8_t g = static_cast<uint8_t>((std::cos(t * 0.07) * 0.5 + 0.5) * 255);
+    uint8_t* p = frame.data.data();
+    for (size_t i = 0; i < frame.data.size(); i += 3) {
+        p[i + 0] = r;
+        p[i + 1] = g;
+        p[i + 2] = 0;
+    }
+    return true;
+}
@@ -1,71 +1,259 @@
 // cpp/src/ipc_server.cpp
 #include "ipc_server.h"
 #include "led_driver.h"
+#include "effect_engine.h"
+#include "expression.h"
+#include "pipeline.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <iomanip>
 #include <thread>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
 #include <unistd.h>
 
-static constexpr int PORT = 9000;
+// longest command line; room for an EFFECT expr program of
+// ExprProgram::MAX_SOURCE characters. A client sending more without a
+// newline is disconnected.
+static constexpr size_t MAX_LINE = 8192;
+static_assert(MAX_LINE > ExprProgram::MAX_SOURCE + 64, "EFFECT expr must fit on one line");
 
-void runIPCServer(LEDDriver* driver) {
-    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd < 0) {
-        perror("socket");
-        return;
+// EFFECT ...; false = not an effect command
+static bool handleEffectCommand(EffectEngine* effects, const std::string& line) {
+    std::istringstream iss(line);
+    std::string token;
+    if (!(iss >> token) || token != "EFFECT") return false;
+    std::string args;
+    std::getline(iss, args);
+    std::string error;
+    if (!effects->command(args, error)) std::cerr << "[IPC] EFFECT: " << error << std::endl;
+    return true;
+}
+
+// DELAY [ms]; false = not a delay command
+static bool handleDelayCommand(Pipeline* pipeline, const std::string& line) {
+    std::istringstream iss(line);
+    std::string token;
+    if (!(iss >> token) || token != "DELAY") return false;
+    int ms;
+    if (iss >> ms) {
+        if (ms < 0 || ms > DelayLine::MAX_DELAY_MS) {
+            std::cerr << "[IPC] DELAY: 0.." << DelayLine::MAX_DELAY_MS << " ms" << std::endl;
+            return true;
+        }
+        pipeline->setDelayMs(ms);
+    }
+    std::cout << "[IPC] A/V delay " << pipeline->delayMs() << " ms" << std::endl;
+    return true;
+}
+
+// STATUS: the capture side; LEDDriver::handleCommand prints the output side
+static void printCaptureStatus(Pipeline* pipeline) {
+    const AmbientProcessor::Stats a = pipeline->stats().ambient;
+    const double frames = a.frames ? double(a.frames) : 1.0;
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1) << "frames=" << a.frames << " crop=" << a.crop.top << "/"
+        << a.crop.bottom << "/" << a.crop.left << "/" << a.crop.right << " cropChanges=" << a.cropChanges
+        << " border=" << a.borderNs / 1000.0 / frames << "us process=" << a.processNs / 1000.0 / frames << "us";
+    if (!a.workerNs.empty()) {
+        oss << " workers=";
+        for (size_t i = 0; i < a.workerNs.size(); ++i) oss << (i ? "," : "") << a.workerNs[i] / 1000.0 / frames;
+        oss << "us";
+    }
+    std::cout << "[IPC STATUS] " << oss.str() << std::endl;
+}
+
+// -----------------------------
+// Start / Stop
+// -----------------------------
+IpcServer::IpcServer(LEDDriver& driver, int port, SourceManager::Input* colors, EffectEngine* effects,
+                     Pipeline* pipeline)
+    : _driver(driver),
+      _port(port),
+      _colors(colors),
+      _effects(effects),
+      _pipeline(pipeline)
+{
+    if (_colors) _frame.assign(_colors->numLeds(), RGB{0, 0, 0});
+}
+
+IpcServer::~IpcServer() {
+    stop();
+}
+
+bool IpcServer::start() {
+    stop();
+    _listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_listenFd < 0 || _wakeFd < 0) {
+        perror("[IPC] socket");
+        stop();
+        return false;
     }
 
     int opt = 1;
-    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
 
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = INADDR_ANY;   // 0.0.0.0
-    addr.sin_port = htons(PORT);
+    addr.sin_port = htons(_port);
+    if (bind(_listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(_listenFd, 3) < 0) {
+        perror(("[IPC] bind " + std::to_string(_port)).c_str());
+        stop();
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_clientsMutex);
+        _stopping = false;
+    }
+    _thread = std::thread(&IpcServer::acceptLoop, this);
+    pthread_setname_np(_thread.native_handle(), "amb-ipc");
+    std::cout << "[IPC] Listening on port " << _port << std::endl;
+    return true;
+}
 
-    if (bind(server_fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
-        perror("bind");
-        close(server_fd);
-        return;
+// no command runs once this returns: the accept thread is joined first (no
+// new clients), then every client socket is shut down, which ends the
+// blocking read(), and each client thread is joined
+void IpcServer::stop() {
+    if (_thread.joinable()) {
+        uint64_t one = 1;
+        if (write(_wakeFd, &one, sizeof(one)) < 0) perror("[IPC] wake");
+        _thread.join();
     }
 
-    if (listen(server_fd, 3) < 0) {
-        perror("listen");
-        close(server_fd);
-        return;
+    std::vector<std::unique_ptr<Client>> clients;
+    {
+        std::lock_guard<std::mutex> lock(_clientsMutex);
+        _stopping = true;
+        clients.swap(_clients);
     }
+    for (auto& c : clients) shutdown(c->fd, SHUT_RDWR);
+    for (auto& c : clients) {
+        c->thread.join();
+        close(c->fd);
+    }
+
+    if (_listenFd >= 0) close(_listenFd);
+    if (_wakeFd >= 0) close(_wakeFd);
+    _listenFd = _wakeFd = -1;
+}
 
-    std::cout << "[IPC] Listening on port " << PORT << std::endl;
+// -----------------------------
+// Clients
+// -----------------------------
+void IpcServer::acceptLoop() {
+    pollfd fds[2] = { { _listenFd, POLLIN, 0 }, { _wakeFd, POLLIN, 0 } };
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("[IPC] poll");
+            return;
+        }
+        if (fds[1].revents) return;
 
-    while (true) {
-        int client = accept(server_fd, nullptr, nullptr);
-        if (client < 0) continue;
+        for (;;) {
+            // blocking reads in the client thread
+            const int fd = accept4(_listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) break;
+            std::lock_guard<std::mutex> lock(_clientsMutex);
+            reapClients();
+            if (_stopping) {
+                close(fd);
+                continue;
+            }
+            auto c = std::make_unique<Client>();
+            c->fd = fd;
+            Client& client = *c;
+            _clients.push_back(std::move(c));
+            client.thread = std::thread(&IpcServer::clientLoop, this, std::ref(client));
+        }
+    }
+}
+
+void IpcServer::reapClients() {
+    size_t kept = 0;
+    for (size_t i = 0; i < _clients.size(); ++i) {
+        if (_clients[i]->done.load(std::memory_order_acquire)) {
+            _clients[i]->thread.join();
+            close(_clients[i]->fd);
+            continue;
+        }
+        _clients[kept++] = std::move(_clients[i]);
+    }
+    _clients.resize(kept);
+}
 
-        std::thread([driver, client]() {
-            char buf[1024];
-            std::string cmd;
+void IpcServer::clientLoop(Client& c) {
+    char buf[1024];
+    std::string cmd;
+
+    while (true) {
+        ssize_t n = read(c.fd, buf, sizeof(buf));
+        if (n <= 0) break;
 
-            while (true) {
-                ssize_t n = read(client, buf, sizeof(buf));
-                if (n <= 0) break;
+        cmd.append(buf, n);
 
-                cmd.append(buf, n);
+        // split by newline (Python sends "\n")
+        size_t pos;
+        while ((pos = cmd.find('\n')) != std::string::npos) {
+            std::string line = cmd.substr(0, pos);
+            cmd.erase(0, pos+1);
+            handleLine(line);
+        }
+        if (cmd.size() > MAX_LINE) {
+            std::cerr << "[IPC] line longer than " << MAX_LINE << " bytes, closing connection" << std::endl;
+            break;
+        }
+    }
 
-                // split by newline (Python sends "\n")
-                size_t pos;
-                while ((pos = cmd.find('\n')) != std::string::npos) {
-                    std::string line = cmd.substr(0, pos);
-                    cmd.erase(0, pos+1);
+    // the fd stays open until the join, so stop() never shuts down a reused number
+    shutdown(c.fd, SHUT_RDWR);
+    c.done.store(true, std::memory_order_release);
+}
 
-                    driver->handleCommand(line);
-                }
-            }
+// COLOR / PIX / RELEASE against the IPC frame; false = not a pixel command
+bool IpcServer::handlePixelCommand(const std::string& line) {
+    std::istringstream iss(line);
+    std::string token;
+    if (!(iss >> token)) return false;
+    auto clamp255 = [](int v) { return static_cast<uint8_t>(v < 0 ? 0 : v > 255 ? 255 : v); };
 
-            close(client);
-        }).detach();
+    std::lock_guard<std::mutex> lock(_frameMutex);
+    if (token == "COLOR") {
+        int r, g, b;
+        if (iss >> r >> g >> b) {
+            std::fill(_frame.begin(), _frame.end(), RGB{clamp255(r), clamp255(g), clamp255(b)});
+            _colors->submitFrame(_frame);
+        }
+    } else if (token == "PIX") {
+        int idx, r, g, b;
+        if ((iss >> idx >> r >> g >> b) && idx >= 0 && idx < static_cast<int>(_frame.size())) {
+            _frame[idx] = RGB{clamp255(r), clamp255(g), clamp255(b)};
+            _colors->submitFrame(_frame);
+        }
+    } else if (token == "RELEASE") {
+        _colors->release();
+    } else {
+        return false;
     }
+    return true;
+}
 
-    close(server_fd);
+void IpcServer::handleLine(const std::string& line) {
+    if (_effects && handleEffectCommand(_effects, line)) return;
+    if (_pipeline && handleDelayCommand(_pipeline, line)) return;
+    if (_pipeline && line.compare(0, 6, "STATUS") == 0) printCaptureStatus(_pipeline);
+    if (!_colors || !handlePixelCommand(line)) _driver.handleCommand(line);
 }
@@ -0,0 +1,223 @@
+// cpp/src/latency_harness.cpp
+#include "latency_harness.h"
+#include "ambient_processor.h"
+#include "frame_source.h"
+#include "led_driver.h"
+#include "output_sink.h"
+#include "pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// gray levels the probes cycle through: cuts, fast-attack and slow steps
+static const uint8_t PROBE_LEVELS[] = { 32, 224, 64, 80, 192, 160 };
+static constexpr int NUM_LEVELS = sizeof(PROBE_LEVELS) / sizeof(PROBE_LEVELS[0]);
+static constexpr double RESPONSE_FRACTION = 0.05;   // 5% of the step = "moved" / "settled"
+static constexpr double MIN_STEP = 1.0;             // ignore probes that do not move the output
+
+// -----------------------------
+// Synthetic source + fake sink
+// -----------------------------
+// Whole frame at the probe level; the probe start (timestamp of its first
+// frame) is recorded for the analysis. Written by the capture thread only,
+// read after the pipeline has finished.
+class ProbeSource : public FrameSource
+{
+public:
+    ProbeSource(const LatencyOptions& o)
+        : _pacer(o.fps), _width(o.width), _height(o.height), _hold(std::max(1, o.holdFrames)),
+          _frames(static_cast<uint64_t>(o.probes) * _hold)
+    {
+        _starts.reserve(o.probes);
+    }
+
+    bool capture(Frame& frame) override {
+        if (_seq == _frames) return false;
+        _pacer.wait();
+        frame.timestampNs = monotonicNs();
+        frame.mediaNs = frame.timestampNs;
+        frame.width = _width;
+        frame.height = _height;
+        frame.external = nullptr;
+        frame.data.assign(static_cast<size_t>(_width) * _height * 3, PROBE_LEVELS[(_seq / _hold) % NUM_LEVELS]);
+        if (_seq % _hold == 0) _starts.push_back(frame.timestampNs);
+        frame.seq = _seq++;
+        return true;
+    }
+
+    const std::vector<uint64_t>& starts() const { return _starts; }
+
+private:
+    FramePacer _pacer;
+    int _width;
+    int _height;
+    uint64_t _hold;
+    uint64_t _frames;
+    uint64_t _seq = 0;
+    std::vector<uint64_t> _starts;
+};
+
+// timestamp + mean wire level of every frame; preallocated, never blocks
+class RecordingSink : public OutputSink
+{
+public:
+    struct Sample
+    {
+        uint64_t ns;
+        double level;
+    };
+
+    explicit RecordingSink(size_t capacity) { _samples.reserve(capacity); }
+
+    bool write(const uint8_t* data, size_t size) override {
+        if (_samples.size() == _samples.capacity()) return true;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < size; ++i) sum += data[i];
+        _samples.push_back({ monotonicNs(), size ? static_cast<double>(sum) / size : 0.0 });
+        return true;
+    }
+
+    const std::vector<Sample>& samples() const { return _samples; }
+
+private:
+    std::vector<Sample> _samples;
+};
+
+// counts frames and bytes, nothing else
+class CountingSink : public OutputSink
+{
+public:
+    bool write(const uint8_t*, size_t size) override {
+        ++frames;
+        bytes += size;
+        return true;
+    }
+
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+};
+
+// -----------------------------
+// Hilfsfunktionen
+// -----------------------------
+static double percentileMs(std::vector<uint64_t>& v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    const size_t idx = static_cast<size_t>(std::ceil(p * v.size())) - (p > 0.0 ? 1 : 0);
+    return v[std::min(idx, v.size() - 1)] / 1e6;
+}
+
+static void printDistribution(const char* name, std::vector<uint64_t> v) {
+    std::printf("  %-14s n=%-5zu p50 %7.2f  p90 %7.2f  p99 %7.2f  max %7.2f ms\n", name, v.size(),
+                percentileMs(v, 0.50), percentileMs(v, 0.90), percentileMs(v, 0.99), percentileMs(v, 1.0));
+}
+
+static void printStage(const char* name, const Pipeline::StageStats& s) {
+    std::printf("  %-14s avg %8.1f us  max %8.1f us  frames %llu\n", name, s.avgUs(), s.maxNs / 1000.0,
+                static_cast<unsigned long long>(s.frames));
+}
+
+static void printPipeline(const Pipeline::Stats& st) {
+    std::printf("Pipeline:\n");
+    printStage("capture", st.capture);
+    printStage("process", st.process);
+    printStage("output", st.output);
+    printStage("queued", st.queued);
+    printStage("latency", st.latency);
+    std::printf("  dropped %llu (process busy) %llu (output busy)\n",
+                static_cast<unsigned long long>(st.droppedCapture),
+                static_cast<unsigned long long>(st.droppedProcess));
+}
+
+// -----------------------------
+// Harness
+// -----------------------------
+int runLatencyHarness(const LatencyOptions& o) {
+    const size_t frames = static_cast<size_t>(std::max(1, o.probes)) * std::max(1, o.holdFrames);
+    auto sinkPtr = std::make_unique<RecordingSink>(frames + 16);
+    RecordingSink& sink = *sinkPtr;
+
+    LEDDriver driver(std::move(sinkPtr), o.leds);
+    AmbientProcessor ambient(o.leds);
+    ProbeSource source(o);
+    const size_t initial = sink.samples().size();   // clear() in the constructor
+
+    Pipeline pipeline(source, ambient, driver);
+    pipeline.start();
+    while (!pipeline.finished()) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    pipeline.stop();
+
+    // match probe windows against the sink samples
+    const auto& starts = source.starts();
+    const auto& samples = sink.samples();
+    std::vector<uint64_t> firstChange, settled;
+    int unsettled = 0;
+    size_t s = initial;
+    double prev = initial ? samples[initial - 1].level : 0.0;
+    for (size_t k = 0; k < starts.size(); ++k) {
+        const uint64_t t0 = starts[k];
+        const uint64_t t1 = k + 1 < starts.size() ? starts[k + 1] : UINT64_MAX;
+        while (s < samples.size() && samples[s].ns < t0) prev = samples[s++].level;
+        size_t end = s;
+        while (end < samples.size() && samples[end].ns < t1) ++end;
+        if (end == s) continue;
+
+        const double final = samples[end - 1].level;
+        const double step = std::fabs(final - prev);
+        if (step >= MIN_STEP) {
+            const double tol = RESPONSE_FRACTION * step;
+            size_t first = s;
+            while (first < end && std::fabs(samples[first].level - prev) < tol) ++first;
+            size_t last = end;                  // first sample of the final in-tolerance run
+            while (last > s && std::fabs(samples[last - 1].level - final) <= tol) --last;
+            if (first < end) firstChange.push_back(samples[first].ns - t0);
+            if (last < end) settled.push_back(samples[last].ns - t0);
+            // still moving at the end of the window: hold is too short
+            if (end - s >= 2 && std::fabs(samples[end - 2].level - final) > tol / 5) ++unsettled;
+        }
+        prev = samples[end - 1].level;
+        s = end;
+    }
+
+    std::printf("Glass-to-LED latency: %zu probes x %d frames @ %d fps, %dx%d -> %d LEDs\n",
+                starts.size(), o.holdFrames, o.fps, o.width, o.height, o.leds);
+    printDistribution("first change", firstChange);
+    printDistribution("settled", settled);
+    if (unsettled > 0) {
+        std::printf("  %d probes still moving at the end of their window (raise holdFrames)\n", unsettled);
+    }
+    printPipeline(pipeline.stats());
+    return firstChange.empty() ? 1 : 0;
+}
+
+int runThroughputHarness(FrameSource& source, int leds, const std::string& tracePath) {
+    auto sinkPtr = std::make_unique<CountingSink>();
+    CountingSink& sink = *sinkPtr;
+    LEDDriver driver(std::move(sinkPtr), leds);
+    AmbientProcessor ambient(leds);
+    const uint64_t initial = sink.frames;
+    if (!tracePath.empty() && !driver.startTrace(tracePath)) return 1;
+
+    Pipeline::Params params = Pipeline::defaultParams();
+    params.blocking = true;
+    Pipeline pipeline(source, ambient, driver, params);
+    const uint64_t t0 = monotonicNs();
+    pipeline.start();
+    while (!pipeline.finished()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    const uint64_t t1 = monotonicNs();
+    pipeline.stop();
+
+    const uint64_t frames = sink.frames - initial;
+    const double secs = (t1 - t0) / 1e9;
+    std::printf("Throughput: %llu frames in %.3f s = %.1f fps (%d LEDs)\n",
+                static_cast<unsigned long long>(frames), secs, secs > 0.0 ? frames / secs : 0.0, leds);
+    printPipeline(pipeline.stats());
+    driver.stopTrace();
+    return frames ? 0 : 1;
+}
@@ -1,10 +1,6 @@
 // cpp/src/led_driver.cpp
 #include "led_driver.h"
-
-#include <fcntl.h>
-#include <sys/ioctl.h>
-#include <linux/spi/spidev.h>
-#include <unistd.h>
+#include "frame_source.h"
 
 #include <cstring>
 #include <iostream>
@@ -13,14 +9,13 @@
 #include <cmath>
 #include <algorithm>
 #include <iomanip>
+#include <chrono>
+#include <ctime>
 
 // -----------------------------
 // Konfiguration / Defaults
 // -----------------------------
-static constexpr uint32_t DEFAULT_SPI_SPEED_HZ = 8000000; // 8MHz (WS2801 safe)
-static constexpr uint8_t DEFAULT_SPI_MODE = SPI_MODE_0;
-static constexpr int DEFAULT_BITS_PER_WORD = 8;
-static constexpr useconds_t LATCH_US = 500; // small pause to latch WS2801
+static constexpr int MAX_REFRESH_HZ = 400;
 
 // -----------------------------
 // Hilfsfunktionen
@@ -31,127 +26,185 @@ static inline uint8_t clamp255(int v) {
     return static_cast<uint8_t>(v);
 }
 
+// 8.8 fixed point -> byte, rounded
+static void quantizeRounded(const uint16_t* in, uint8_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<uint8_t>((in[i] + 128u) >> 8);
+    }
+}
+
+// 8.8 fixed point -> byte with temporal dithering: the dropped fraction is
+// carried per channel into the next refresh (error diffusion over time), so
+// on average the strip shows the exact LUT value. Max in + acc is
+// 65280 + 255, no overflow. Plain data-parallel loop; -O3 vectorizes it
+// (NEON on the Pi, SSE2/AVX2 on x86).
+static void quantizeDithered(const uint16_t* in, uint16_t* acc, uint8_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        uint16_t sum = static_cast<uint16_t>(in[i] + acc[i]);
+        out[i] = static_cast<uint8_t>(sum >> 8);
+        acc[i] = static_cast<uint16_t>(sum & 0xFF);
+    }
+}
+
 // -----------------------------
 // LEDDriver Implementation
 // -----------------------------
 LEDDriver::LEDDriver(const std::string& spi_dev, int num_leds)
-    : spiDev_(spi_dev),
-      spiFd_(-1),
+    : LEDDriver(std::make_unique<SpiSink>(spi_dev), num_leds)
+{
+}
+
+LEDDriver::LEDDriver(std::unique_ptr<OutputSink> sink, int num_leds)
+    : sink_(std::move(sink)),
       numLeds_(std::max(1, num_leds)),
       buffer_(numLeds_ * 3, 0),
       lastBuffer_(numLeds_ * 3, 0),
       gamma_(2.2f),
       brightness_(1.0f),
-      smoothingAlpha_(0.25f)
+      smoothingMs_(57.9f)                  // alpha 0.25 per frame at 60 Hz
 {
     // allocate float history for smoothing (better precision)
     lastFloatBuffer_.assign(numLeds_ * 3, 0.0f);
+    logicalBuffer_.assign(numLeds_ * 3, 0);
+    wire16_.assign(numLeds_ * 3, 0);
+    ditherAcc_.assign(numLeds_ * 3, 0);
+
+    // default: one plain RGB segment over the whole strip
+    segments_.push_back(LedSegment{0, numLeds_, ColorOrder::RGB, false});
+    calibrations_.assign(1, stripCalibration_);
 
-    openSPI();
-    buildGammaLUT(gamma_);
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        rebuildTables();
+    }
     // ensure initial state clear
     clear();
     show();
 }
 
 LEDDriver::~LEDDriver() {
+    stopOutputThread();
     // clear LEDs before exit
     clear();
     show();
-    closeSPI();
 }
 
 // -----------------------------
-// SPI open/close
+// Output tables (gamma LUTs, calibration, layout)
 // -----------------------------
-void LEDDriver::openSPI() {
-    spiFd_ = open(spiDev_.c_str(), O_RDWR);
-    if (spiFd_ < 0) {
-        perror(("open SPI " + spiDev_).c_str());
-        throw std::runtime_error("Failed to open SPI device: " + spiDev_);
+// Per segment: calibration gain, gamma and brightness folded into one table
+// per channel. Entries keep 8 fractional bits for the dithering stage
+// (max 255 * 256 = 65280).
+void LEDDriver::rebuildTables() {
+    auto tables = std::make_shared<OutputTables>();
+    tables->segments = segments_;
+    tables->power = power_;
+    tables->calib.resize(segments_.size());
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        compileCalibration(calibrations_[i], gamma_, brightness_, tables->calib[i]);
     }
+    std::atomic_store(&tables_, std::shared_ptr<const OutputTables>(std::move(tables)));
+}
 
-    // mode
-    if (ioctl(spiFd_, SPI_IOC_WR_MODE, &DEFAULT_SPI_MODE) < 0) {
-        perror("SPI set mode");
-    }
+// -----------------------------
+// apply gamma + brightness to lastFloatBuffer_ => buffer_ (uint8_t)
+// -----------------------------
+void LEDDriver::applyGammaAndBrightness() {
+    const auto tables = std::atomic_load(&tables_);
 
-    // bits per word
-    if (ioctl(spiFd_, SPI_IOC_WR_BITS_PER_WORD, &DEFAULT_BITS_PER_WORD) < 0) {
-        perror("SPI set bits per word");
+    // quantize lastFloatBuffer_ (0..255 floats) to the nearest LUT index
+    for (size_t i = 0; i < logicalBuffer_.size(); ++i) {
+        float val = std::clamp(lastFloatBuffer_[i], 0.0f, 255.0f);
+        logicalBuffer_[i] = static_cast<uint8_t>(val + 0.5f);
     }
 
-    // max speed
-    uint32_t speed = DEFAULT_SPI_SPEED_HZ;
-    if (ioctl(spiFd_, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0) {
-        perror("SPI set max speed");
+    for (size_t s = 0; s < tables->segments.size(); ++s) {
+        const LedSegment& seg = tables->segments[s];
+        const CompiledCalibration& calib = tables->calib[s];
+        // color correction matrix (no-op for identity / white balance only)
+        applyColorMatrix(calib, logicalBuffer_.data() + seg.start * 3, seg.count);
+        // final encoding pass: LUT lookup + per-segment byte order / direction
+        encodeSegment(seg, logicalBuffer_.data(), wire16_.data(), calib.lut);
     }
 
-    // Good to know
-    std::cerr << "[LEDDriver] Opened SPI " << spiDev_ << " fd=" << spiFd_
-              << " speed=" << speed << "Hz\n";
-}
+    limitPower(*tables);
 
-void LEDDriver::closeSPI() {
-    if (spiFd_ >= 0) {
-        close(spiFd_);
-        spiFd_ = -1;
+    // 8.8 -> bytes
+    if (dithering_) {
+        quantizeDithered(wire16_.data(), ditherAcc_.data(), buffer_.data(), buffer_.size());
+    } else {
+        quantizeRounded(wire16_.data(), buffer_.data(), buffer_.size());
     }
 }
 
 // -----------------------------
-// Gamma LUT
+// Power limiter: estimate the supply current of the post-gamma frame and,
+// if it exceeds the budget, scale all wire values down by the same factor
+// (keeps hue, dithering still applies afterwards)
 // -----------------------------
-void LEDDriver::buildGammaLUT(float gamma) {
-    gamma_ = gamma;
-    gammaLUT_.resize(256);
-    for (int i = 0; i < 256; ++i) {
-        float normalized = i / 255.0f;
-        float corrected = powf(normalized, gamma_);
-        gammaLUT_[i] = corrected * 255.0f;
+void LEDDriver::limitPower(const OutputTables& tables) {
+    const PowerModel& pm = tables.power;
+
+    // per logical channel sums of the 8.8 wire values
+    double chan[3] = { 0.0, 0.0, 0.0 };
+    for (const auto& seg : tables.segments) {
+        uint64_t pos[3];
+        sumTriplets(wire16_.data() + seg.start * 3, seg.count, pos);
+        for (int p = 0; p < 3; ++p) chan[wireChannel(seg.order, p)] += static_cast<double>(pos[p]);
     }
-}
 
-// -----------------------------
-// apply gamma + brightness to lastFloatBuffer_ => buffer_ (uint8_t)
-// -----------------------------
-void LEDDriver::applyGammaAndBrightness() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    const double idle = pm.idlemA * numLeds_;
+    double mA = idle;
+    for (int c = 0; c < 3; ++c) mA += chan[c] * pm.channelmA[c] / 65280.0;
 
-    // convert lastFloatBuffer_ (0..255 floats) through gamma LUT and brightness
-    for (size_t i = 0; i < buffer_.size(); ++i) {
-        float val = lastFloatBuffer_[i];
-        // clamp float to 0..255
-        if (val < 0.0f) val = 0.0f;
-        if (val > 255.0f) val = 255.0f;
+    powermW_ = static_cast<uint32_t>(mA * pm.volts);
+    ++powerFrames_;
 
-        // nearest index into LUT
-        int idx = static_cast<int>(val + 0.5f);
-        if (idx < 0) idx = 0;
-        if (idx > 255) idx = 255;
+    if (pm.budgetmA <= 0.0f || mA <= pm.budgetmA) return;
 
-        float gammaed = gammaLUT_[idx] * brightness_; // scaled 0..255 * brightness
-        int out = static_cast<int>(gammaed + 0.5f);
-        buffer_[i] = clamp255(out);
-    }
+    // idle current does not scale with the frame
+    double scale = (pm.budgetmA - idle) / (mA - idle);
+    scale = std::clamp(scale, 0.0, 1.0);
+    scaleFrame(wire16_.data(), wire16_.size(), static_cast<uint32_t>(scale * 65536.0));
+    ++powerLimited_;
 }
 
 // -----------------------------
 // Smoothing (EMA): updates lastFloatBuffer_ using newbuf (raw RGB bytes)
+// the time constant adapts to the change metric: slow for static content,
+// fast attack for large changes, snap on cuts; alpha follows from the time
+// between the frames' timestamps, so COLOR rate and frame drops don't
+// change the fade, and a replay fades the same however fast it runs
 // -----------------------------
-void LEDDriver::doSmoothing(const std::vector<uint8_t>& newbuf) {
+void LEDDriver::doSmoothing(const uint8_t* newbuf, size_t count, uint64_t timestampNs) {
     std::lock_guard<std::mutex> lock(mutex_);
-    if (newbuf.size() != lastFloatBuffer_.size()) {
+    if (count != lastFloatBuffer_.size()) {
         std::cerr << "[LEDDriver] doSmoothing: size mismatch\n";
         return;
     }
 
+    // a first frame, or one from before the previous (another time base),
+    // counts as one frame at the reference rate
+    const uint64_t now = timestampNs ? timestampNs : monotonicNs();
+    const uint64_t dt = lastSmoothNs_ && now >= lastSmoothNs_ ? std::min(now - lastSmoothNs_, MAX_SMOOTHING_STEP_NS)
+                                                               : 1000000000ull / SMOOTHING_REFERENCE_HZ;
+    lastSmoothNs_ = now;
+
+    const size_t n = lastFloatBuffer_.size();
+    const uint32_t sad = sumAbsDiff(newbuf, lastFloatBuffer_.data(), n);
+    float tau = smoothingMs_;
+    switch (classifyChange(static_cast<float>(sad) / n, adaptive_)) {
+        case SmoothingResponse::Slow: break;
+        case SmoothingResponse::Fast: tau = std::min(tau, smoothingFastMs_); ++smoothFast_; break;
+        case SmoothingResponse::Snap: tau = 0.0f; ++smoothCuts_; break;
+    }
+
     // EMA: last = last + alpha * (new - last)
-    const float a = std::clamp(smoothingAlpha_, 0.0f, 1.0f);
-    for (size_t i = 0; i < lastFloatBuffer_.size(); ++i) {
-        float n = static_cast<float>(newbuf[i]);
+    const float a = emaAlpha(dt, tau);
+    for (size_t i = 0; i < n; ++i) {
+        const float target = static_cast<float>(newbuf[i]);
         float &l = lastFloatBuffer_[i];
-        l = l + a * (n - l);
+        l = l + a * (target - l);
     }
 }
 
@@ -160,16 +213,14 @@ void LEDDriver::doSmoothing(const std::vector<uint8_t>& newbuf) {
 // -----------------------------
 void LEDDriver::setAll(uint8_t r, uint8_t g, uint8_t b) {
     std::lock_guard<std::mutex> lock(mutex_);
-    // Byte order: assume strip is RGB order. Many strips are GRB; adapt if needed.
+    // Logical order is always R, G, B; the wire order is applied per segment
+    // in applyGammaAndBrightness (see setColorOrder / setSegments).
     for (int i = 0; i < numLeds_; ++i) {
         size_t off = i * 3;
-        // Store as raw order (we choose R, G, B)
         lastFloatBuffer_[off + 0] = static_cast<float>(r);
         lastFloatBuffer_[off + 1] = static_cast<float>(g);
         lastFloatBuffer_[off + 2] = static_cast<float>(b);
     }
-    // Apply gamma & brightness to produce buffer_
-    applyGammaAndBrightness();
 }
 
 void LEDDriver::setPixel(int idx, uint8_t r, uint8_t g, uint8_t b) {
@@ -179,58 +230,273 @@ void LEDDriver::setPixel(int idx, uint8_t r, uint8_t g, uint8_t b) {
     lastFloatBuffer_[off + 0] = static_cast<float>(r);
     lastFloatBuffer_[off + 1] = static_cast<float>(g);
     lastFloatBuffer_[off + 2] = static_cast<float>(b);
-    applyGammaAndBrightness();
 }
 
-void LEDDriver::show() {
-    // ensure buffer_ is consistent with lastFloatBuffer_
-    applyGammaAndBrightness();
-
-    // write buffer to SPI
-    if (spiFd_ < 0) {
-        std::cerr << "[LEDDriver] show: SPI not opened\n";
+// one complete frame from the ambient pipeline: smoothing step + output
+void LEDDriver::submitFrame(const std::vector<RGB>& colors, uint64_t timestampNs) {
+    if (static_cast<int>(colors.size()) != numLeds_) {
+        std::cerr << "[LEDDriver] submitFrame: got " << colors.size() << " colors for "
+                  << numLeds_ << " LEDs\n";
         return;
     }
+    doSmoothing(reinterpret_cast<const uint8_t*>(colors.data()), colors.size() * 3, timestampNs);
+    requestShow();
+}
 
-    ssize_t written = write(spiFd_, buffer_.data(), buffer_.size());
-    if (written < 0) {
-        perror("SPI write");
-    } else if (static_cast<size_t>(written) != buffer_.size()) {
-        std::cerr << "[LEDDriver] Warning: partial SPI write " << written << "/" << buffer_.size() << "\n";
+// buffer_ is only rendered here, once per physical refresh, so the dither
+// accumulators advance exactly once per frame on the wire. outputMutex_
+// keeps the bytes stable during write(); mutex_ is released before the sink
+// write (SPI transfer) so command handlers never wait on the bus.
+// Tracing copies the frame and takes traceMutex_ before outputMutex_ is
+// released (frames stay in wire order), then delta-encodes and writes the
+// record outside it, so the next frame's render and write don't wait on disk.
+void LEDDriver::show() {
+    std::unique_lock<std::mutex> outLock(outputMutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // ensure buffer_ is consistent with lastFloatBuffer_
+        applyGammaAndBrightness();
     }
 
-    // small pause for latch
-    usleep(LATCH_US);
+    // write buffer to the sink (SPI, or a test sink)
+    sink_->write(buffer_.data(), buffer_.size());
+
+    if (!tracing_.load(std::memory_order_relaxed)) return;
+    std::lock_guard<std::mutex> traceLock(traceMutex_);
+    if (!trace_.isOpen()) return;
+    traceFrame_.assign(buffer_.begin(), buffer_.end());
+    outLock.unlock();
+
+    const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    trace_.append(traceFrame_.data(), ns);
 }
 
 void LEDDriver::clear() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    for (size_t i = 0; i < lastFloatBuffer_.size(); ++i) lastFloatBuffer_[i] = 0.0f;
-    for (size_t i = 0; i < buffer_.size(); ++i) buffer_[i] = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < lastFloatBuffer_.size(); ++i) lastFloatBuffer_[i] = 0.0f;
+        std::fill(ditherAcc_.begin(), ditherAcc_.end(), 0);
+    }
     // send immediately
     show();
 }
 
+void LEDDriver::requestShow() {
+    if (outputRunning_) return; // next refresh picks it up
+    show();
+}
+
+// -----------------------------
+// Output trace
+// -----------------------------
+bool LEDDriver::startTrace(const std::string& path, bool exclusive) {
+    std::lock_guard<std::mutex> lock(traceMutex_);
+    if (!trace_.open(path, buffer_.size(), exclusive)) return false;
+    tracing_ = true;
+    std::cerr << "[LEDDriver] Tracing output to " << path << "\n";
+    return true;
+}
+
+void LEDDriver::stopTrace() {
+    std::lock_guard<std::mutex> lock(traceMutex_);
+    tracing_ = false;
+    trace_.close();
+}
+
+void LEDDriver::setTraceDir(const std::string& dir) {
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    traceDir_ = dir;
+}
+
+// TRACE ON [name]: a new file in traceDir_, never a path and never an
+// existing file (the port is open to the network, the daemon runs as root)
+void LEDDriver::startNamedTrace(std::string name) {
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> lock(outputMutex_);
+        dir = traceDir_;
+    }
+    if (dir.empty()) {
+        std::cerr << "[LEDDriver] TRACE: no trace directory configured (trace.dir)\n";
+        return;
+    }
+    if (name.empty()) {
+        char stamp[32];
+        const std::time_t now = std::time(nullptr);
+        std::tm tm{};
+        localtime_r(&now, &tm);
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm);
+        name = std::string("trace-") + stamp + ".trace";
+    }
+    if (name.find('/') != std::string::npos || name.find("..") != std::string::npos || name[0] == '.') {
+        std::cerr << "[LEDDriver] TRACE: '" << name << "' is not a plain file name\n";
+        return;
+    }
+    startTrace(dir + "/" + name, true);
+}
+
+// -----------------------------
+// Refresh thread
+// -----------------------------
+// start/stop come from IPC client threads and the config watcher, so
+// threadMutex_ serializes them: move-assigning over a joinable thread
+// would terminate the process
+void LEDDriver::startOutputThread(int refreshHz) {
+    std::lock_guard<std::mutex> lock(threadMutex_);
+    joinOutputThread();
+    if (refreshHz <= 0) return;
+    refreshHz = std::min(refreshHz, MAX_REFRESH_HZ);
+    refreshHz_ = refreshHz;
+    outputRunning_ = true;
+    outputThread_ = std::thread(&LEDDriver::outputLoop, this, refreshHz);
+}
+
+void LEDDriver::stopOutputThread() {
+    std::lock_guard<std::mutex> lock(threadMutex_);
+    joinOutputThread();
+}
+
+void LEDDriver::joinOutputThread() {
+    outputRunning_ = false;
+    if (outputThread_.joinable()) outputThread_.join();
+    refreshHz_ = 0;
+}
+
+void LEDDriver::outputLoop(int refreshHz) {
+    using clock = std::chrono::steady_clock;
+    const auto period = std::chrono::nanoseconds(1000000000LL / refreshHz);
+    auto next = clock::now();
+    while (outputRunning_) {
+        show();
+        next += period;
+        auto now = clock::now();
+        if (next < now) next = now; // overrun: don't try to catch up
+        std::this_thread::sleep_until(next);
+    }
+}
+
 // -----------------------------
 // Config setters
 // -----------------------------
 void LEDDriver::setGamma(float gamma) {
     if (gamma <= 0.01f) return;
-    std::lock_guard<std::mutex> lock(mutex_);
-    buildGammaLUT(gamma);
-    // rebuild output with new gamma
-    applyGammaAndBrightness();
+    std::lock_guard<std::mutex> lock(configMutex_);
+    gamma_ = gamma;
+    rebuildTables();
 }
 
 void LEDDriver::setBrightness(float brightness) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(configMutex_);
     brightness_ = std::clamp(brightness, 0.0f, 1.0f);
-    applyGammaAndBrightness();
+    rebuildTables();
+}
+
+void LEDDriver::setSmoothingTime(float tauMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    smoothingMs_ = std::clamp(tauMs, 0.0f, MAX_SMOOTHING_MS);
 }
 
 void LEDDriver::setSmoothingAlpha(float alpha) {
+    setSmoothingTime(alphaToTauMs(alpha));
+}
+
+void LEDDriver::setAdaptiveSmoothing(float fastTauMs, const AdaptiveSmoothing& params) {
     std::lock_guard<std::mutex> lock(mutex_);
-    smoothingAlpha_ = std::clamp(alpha, 0.0f, 1.0f);
+    smoothingFastMs_ = std::clamp(fastTauMs, 0.0f, MAX_SMOOTHING_MS);
+    adaptive_ = params;
+}
+
+void LEDDriver::setDithering(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    dithering_ = enabled;
+    std::fill(ditherAcc_.begin(), ditherAcc_.end(), 0);
+}
+
+void LEDDriver::setColorOrder(ColorOrder order) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    for (auto& seg : segments_) seg.order = order;
+    rebuildTables();
+}
+
+bool LEDDriver::setSegments(std::vector<LedSegment> segments) {
+    if (!validateSegments(segments, numLeds_)) {
+        std::cerr << "[LEDDriver] setSegments: segments must cover 0.." << numLeds_ - 1
+                  << " without gaps or overlap\n";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(configMutex_);
+    segments_ = std::move(segments);
+    // a new layout starts from the whole-strip calibration
+    calibrations_.assign(segments_.size(), stripCalibration_);
+    rebuildTables();
+    return true;
+}
+
+bool LEDDriver::setCalibration(int segment, const Calibration& calib) {
+    return updateCalibration(segment, [&](Calibration& c) { c = calib; return true; });
+}
+
+bool LEDDriver::updateCalibration(int segment, const std::function<bool(Calibration&)>& fn) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    if (segment >= static_cast<int>(segments_.size())) return false;
+    Calibration calib = segment < 0 ? stripCalibration_ : calibrations_[segment];
+    if (!fn(calib)) return false;
+    if (segment < 0) {
+        stripCalibration_ = calib;
+        calibrations_.assign(segments_.size(), calib);
+    } else {
+        calibrations_[segment] = calib;
+    }
+    rebuildTables();
+    return true;
+}
+
+void LEDDriver::setPowerModel(const PowerModel& model) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    power_ = model;
+    rebuildTables();
+}
+
+bool LEDDriver::setOutputConfig(OutputConfig config) {
+    if (config.segments.empty()) config.segments.push_back(LedSegment{0, numLeds_, ColorOrder::RGB, false});
+    if (!validateSegments(config.segments, numLeds_)) {
+        std::cerr << "[LEDDriver] setOutputConfig: segments must cover 0.." << numLeds_ - 1
+                  << " without gaps or overlap\n";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(configMutex_);
+    if (config.gamma > 0.01f) gamma_ = config.gamma;
+    brightness_ = std::clamp(config.brightness, 0.0f, 1.0f);
+    // same segment boundaries: runtime CALIB SEG n settings survive the
+    // reload, segments still on the old strip calibration follow the new one
+    const bool sameLayout = std::equal(segments_.begin(), segments_.end(), config.segments.begin(),
+                                       config.segments.end(), [](const LedSegment& a, const LedSegment& b) {
+                                           return a.start == b.start && a.count == b.count;
+                                       });
+    if (sameLayout) {
+        for (auto& calib : calibrations_) {
+            if (sameCalibration(calib, stripCalibration_)) calib = config.calibration;
+        }
+    } else {
+        calibrations_.assign(config.segments.size(), config.calibration);
+    }
+    segments_ = std::move(config.segments);
+    stripCalibration_ = config.calibration;
+    power_ = config.power;
+    rebuildTables();
+    return true;
+}
+
+PowerModel LEDDriver::powerModel() {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    return power_;
+}
+
+Calibration LEDDriver::calibration(int segment) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    if (segment < 0 || segment >= static_cast<int>(calibrations_.size())) return stripCalibration_;
+    return calibrations_[segment];
 }
 
 // -----------------------------
@@ -240,7 +506,17 @@ void LEDDriver::setSmoothingAlpha(float alpha) {
 //  PIX idx r g b
 //  BRIGHT percent_or_0to1  (e.g., BRIGHT 80  or BRIGHT 0.8)
 //  GAMMA value
-//  SMOOTH alpha (0..1)
+//  SMOOTH alpha (0..1)            (per frame at 60 Hz, converted to a time constant)
+//  SMOOTHMS tau_ms [fast_tau_ms]  (time constants)
+//  SMOOTHADAPT fast_alpha attack_diff cut_diff   (mean abs diff per channel, 0 = off)
+//  ORDER RGB|GRB|BGR|...          (all segments)
+//  SEGMENTS start:count[:ORDER][:R] ...   (R = reversed)
+//  CALIB [SEG n] WB r g b | MATRIX m00 .. m22 | GAMMA r g b | RESET
+//  POWER budget_mA                (0 = no limit)
+//  POWER MODEL mA_r mA_g mA_b idle_mA volts
+//  DITHER 0|1
+//  REFRESH hz                     (0 = only send on change)
+//  TRACE ON [name] | OFF          (record every output frame into trace.dir)
 //  SHOW
 //  CLEAR
 //  STATUS
@@ -261,16 +537,15 @@ void LEDDriver::handleCommand(const std::string &cmd) {
                 newbuf[off+1] = clamp255(g);
                 newbuf[off+2] = clamp255(b);
             }
-            doSmoothing(newbuf);
-            applyGammaAndBrightness();
-            show();
+            doSmoothing(newbuf.data(), newbuf.size(), 0);
+            requestShow();
         }
     }
     else if (token == "PIX") {
         int idx, r, g, b;
         if (iss >> idx >> r >> g >> b) {
             setPixel(idx, clamp255(r), clamp255(g), clamp255(b));
-            show();
+            requestShow();
         }
     }
     else if (token == "BRIGHT") {
@@ -289,8 +564,7 @@ void LEDDriver::handleCommand(const std::string &cmd) {
                         setBrightness(std::clamp(static_cast<float>(bi), 0.0f, 1.0f));
                     }
                 }
-                applyGammaAndBrightness();
-                show();
+                requestShow();
             } catch (...) {}
         }
     }
@@ -299,8 +573,7 @@ void LEDDriver::handleCommand(const std::string &cmd) {
         if (iss >> g) {
             setGamma(g);
             // immediate update
-            applyGammaAndBrightness();
-            show();
+            requestShow();
         }
     }
     else if (token == "SMOOTH") {
@@ -309,16 +582,167 @@ void LEDDriver::handleCommand(const std::string &cmd) {
             setSmoothingAlpha(alpha);
         }
     }
+    else if (token == "SMOOTHMS") {
+        float tau, fast;
+        if (iss >> tau) {
+            setSmoothingTime(tau);
+            if (iss >> fast) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                smoothingFastMs_ = std::clamp(fast, 0.0f, MAX_SMOOTHING_MS);
+            }
+        }
+    }
+    else if (token == "ORDER") {
+        std::string name;
+        ColorOrder order;
+        if ((iss >> name) && parseColorOrder(name, order)) {
+            setColorOrder(order);
+            requestShow();
+        } else {
+            std::cerr << "[LEDDriver] ORDER: expected RGB, RBG, GRB, GBR, BRG or BGR\n";
+        }
+    }
+    else if (token == "SEGMENTS") {
+        ColorOrder defaultOrder;
+        {
+            std::lock_guard<std::mutex> lock(configMutex_);
+            defaultOrder = segments_.front().order;
+        }
+        std::vector<LedSegment> segs;
+        std::string spec;
+        bool ok = true;
+        while (iss >> spec) {
+            LedSegment seg;
+            if (!parseSegment(spec, defaultOrder, seg)) {
+                std::cerr << "[LEDDriver] SEGMENTS: bad segment '" << spec << "'\n";
+                ok = false;
+                break;
+            }
+            segs.push_back(seg);
+        }
+        if (ok && setSegments(std::move(segs))) requestShow();
+    }
+    else if (token == "CALIB") {
+        // tables are compiled here on the command thread and swapped in;
+        // the refresh thread keeps rendering with the old ones meanwhile
+        int segment = -1;
+        if (iss >> std::ws && iss.peek() == 'S') {
+            std::string seg;
+            if (!(iss >> seg >> segment) || seg != "SEG" || segment < 0) {
+                std::cerr << "[LEDDriver] CALIB: expected SEG <index>\n";
+                return;
+            }
+        }
+        // parsed against the current value under the config lock, so two
+        // clients changing different parts (WB vs GAMMA) don't lose an update
+        std::string error;
+        const bool ok = updateCalibration(segment, [&](Calibration& calib) {
+            return parseCalibration(iss, calib, error);
+        });
+        if (ok) {
+            requestShow();
+        } else if (error.empty()) {
+            std::cerr << "[LEDDriver] CALIB: no segment " << segment << "\n";
+        } else {
+            std::cerr << "[LEDDriver] CALIB: " << error << "\n";
+        }
+    }
+    else if (token == "POWER") {
+        PowerModel pm = powerModel();
+        std::string arg;
+        if (!(iss >> arg)) return;
+        if (arg == "MODEL") {
+            if (!(iss >> pm.channelmA[0] >> pm.channelmA[1] >> pm.channelmA[2] >> pm.idlemA >> pm.volts)
+                || pm.volts <= 0.0f) {
+                std::cerr << "[LEDDriver] POWER MODEL: expected mA_r mA_g mA_b idle_mA volts\n";
+                return;
+            }
+        } else {
+            try {
+                pm.budgetmA = std::max(0.0f, std::stof(arg));
+            } catch (...) {
+                std::cerr << "[LEDDriver] POWER: expected budget in mA\n";
+                return;
+            }
+        }
+        setPowerModel(pm);
+        requestShow();
+    }
+    else if (token == "DITHER") {
+        int on;
+        if (iss >> on) {
+            setDithering(on != 0);
+            if (on && !outputRunning_) {
+                std::cerr << "[LEDDriver] DITHER: needs a refresh rate above the content rate (REFRESH hz)\n";
+            }
+        }
+    }
+    else if (token == "REFRESH") {
+        int hz;
+        if (iss >> hz) {
+            if (hz > 0) startOutputThread(hz);
+            else stopOutputThread();
+        }
+    }
+    else if (token == "SMOOTHADAPT") {
+        float fast;
+        AdaptiveSmoothing params;
+        if (iss >> fast >> params.attackThreshold >> params.cutThreshold) {
+            setAdaptiveSmoothing(alphaToTauMs(fast), params);
+        }
+    }
+    else if (token == "TRACE") {
+        std::string arg, name;
+        if (!(iss >> arg) || (arg != "ON" && arg != "OFF")) {
+            std::cerr << "[LEDDriver] TRACE: expected ON [name] or OFF\n";
+        } else if (arg == "OFF") {
+            stopTrace();
+        } else {
+            iss >> name;
+            startNamedTrace(name);
+        }
+    }
     else if (token == "SHOW") {
-        show();
+        requestShow();
     }
     else if (token == "CLEAR") {
         clear();
     }
     else if (token == "STATUS") {
         std::ostringstream oss;
-        oss << "LEDs=" << numLeds_ << " brightness=" << brightness_
-            << " gamma=" << gamma_ << " smooth=" << smoothingAlpha_;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            oss << "LEDs=" << numLeds_ << " smooth=" << smoothingMs_
+                << "/" << smoothingFastMs_ << "ms fast=" << smoothFast_ << " cuts=" << smoothCuts_
+                << " dither=" << (dithering_ ? 1 : 0);
+        }
+        {
+            std::lock_guard<std::mutex> lock(configMutex_);
+            oss << " brightness=" << brightness_ << " gamma=" << gamma_ << " refresh=" << refreshHz_;
+            oss << " segments=";
+            for (size_t i = 0; i < segments_.size(); ++i) {
+                const auto& seg = segments_[i];
+                oss << (i ? "," : "") << seg.start << ":" << seg.count << ":"
+                    << colorOrderName(seg.order) << (seg.reversed ? ":R" : "");
+            }
+            const auto tables = std::atomic_load(&tables_);
+            oss << " calib=";
+            for (size_t i = 0; i < tables->calib.size(); ++i) {
+                oss << (i ? "," : "") << (tables->calib[i].mix ? "matrix" : "lut");
+            }
+            oss << " power=" << std::fixed << std::setprecision(2) << powermW_ / 1000.0 << "W"
+                << " budget=" << std::setprecision(1) << power_.budgetmA * power_.volts / 1000.0f << "W"
+                << " limited=" << powerLimited_ << "/" << powerFrames_;
+        }
+        {
+            std::lock_guard<std::mutex> lock(traceMutex_);
+            if (trace_.isOpen()) {
+                const TraceStats& ts = trace_.stats();
+                oss << " trace=" << trace_.path() << " frames=" << ts.frames << " changed/frame="
+                    << std::setprecision(1) << (ts.frames ? double(ts.changedBytes) / ts.frames : 0.0)
+                    << " bytes=" << ts.fileBytes;
+            }
+        }
         std::string s = oss.str();
         // if called from socket handler, we might want to return or print
         std::cout << "[LEDDriver STATUS] " << s << std::endl;
@@ -1,23 +1,239 @@
 #include <iostream>
+#include <iomanip>
 #include <thread>
 #include <atomic>
 #include <csignal>
 #include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
 
 #include "led_driver.h"
+#include "ambient_processor.h"
+#include "frame_source.h"
+#include "pipeline.h"
 #include "ipc_server.h"
+#include "latency_harness.h"
+#include "replay_source.h"
+#include "config.h"
+#include "dmx_receiver.h"
+#include "ddp_receiver.h"
+#include "opc_server.h"
+#include "source_manager.h"
+#include "effect_engine.h"
+#include "audio_reactive.h"
+
+static const char* DEFAULT_CONFIG_PATH = "/etc/ambilight/ambilight.conf";
 
 // Global flag for clean shutdown
 std::atomic<bool> running(true);
 
 void signalHandler(int)
 {
-    std::cout << "\n[MAIN] Shutdown requested…" << std::endl;
     running = false;
 }
 
-int main()
+static void printStage(const char* name, const Pipeline::StageStats& s)
+{
+    std::cout << "  " << std::left << std::setw(8) << name << std::right
+              << " avg " << std::setw(8) << s.avgUs() << " us"
+              << "  max " << std::setw(8) << s.maxNs / 1000.0 << " us"
+              << "  frames " << s.frames << "\n";
+}
+
+static void printReceiver(const DmxReceiver& r)
+{
+    const DmxReceiver::Stats s = r.stats();
+    std::cout << "[MAIN] " << r.name() << ": " << s.frames << " frames, " << s.partial << " partial, "
+              << s.packets << " packets (" << (s.batches ? double(s.packets) / s.batches : 0.0)
+              << " per recvmmsg), " << s.stale << " stale, " << s.ignored << " ignored" << std::endl;
+}
+
+static void printReceiver(const DdpReceiver& r)
+{
+    const DdpReceiver::Stats s = r.stats();
+    std::cout << "[MAIN] DDP: " << s.frames << " frames, " << s.packets << " packets, " << s.bytes << " bytes, "
+              << s.lost << " lost, " << s.reordered << " reordered, " << s.clipped << " clipped, "
+              << s.ignored << " ignored, " << s.sources << " sources" << std::endl;
+}
+
+static void printReceiver(const OpcServer& r)
+{
+    const OpcServer::Stats s = r.stats();
+    std::cout << "[MAIN] OPC: " << s.frames << " frames, " << s.messages << " messages, " << s.coalesced
+              << " coalesced, " << s.skipped << " skipped, " << s.clients << " clients" << std::endl;
+}
+
+static void printEffects(const EffectEngine& e)
+{
+    const EffectEngine::Stats s = e.stats();
+    std::cout << "[MAIN] Effects: " << effectName(s.type) << ", " << s.frames << " frames, avg " << s.avgUs()
+              << " us, max " << s.maxRenderNs / 1000.0 << " us, " << s.late << " late" << std::endl;
+}
+
+static void printAudio(const AudioReactive& a)
+{
+    const AudioReactive::Stats s = a.stats();
+    std::cout << "[MAIN] Audio: " << (s.active ? "active" : "silent") << ", level " << s.levelDb << " dB, "
+              << s.blocks << " blocks, " << s.beats << " beats, process avg "
+              << s.avgProcessUs() << " us, max " << s.maxProcessNs / 1000.0 << " us, latency avg "
+              << s.avgLatencyMs() << " ms, max " << s.maxLatencyNs / 1e6 << " ms (+ " << s.windowMs
+              << " ms window)" << std::endl;
+}
+
+static void printSources(const SourceManager& sources)
+{
+    std::cout << "[MAIN] Sources:\n";
+    for (const auto& s : sources.stats())
+    {
+        std::cout << "  " << (s.active ? '*' : ' ') << " " << std::left << std::setw(8) << s.name << std::right
+                  << " prio " << std::setw(4) << s.policy.priority << " " << std::left << std::setw(8)
+                  << blendModeName(s.policy.blend) << std::right << (s.live ? "  live   " : "  idle   ")
+                  << "submitted " << s.submitted << "  shown " << s.shown << "  superseded " << s.superseded
+                  << "  expired " << s.expired << "\n";
+    }
+    std::cout << std::flush;
+}
+
+static void printStats(const Pipeline::Stats& s)
 {
+    std::cout << "[MAIN] Pipeline:\n" << std::fixed << std::setprecision(1);
+    printStage("capture", s.capture);
+    printStage("process", s.process);
+    printStage("output", s.output);
+    printStage("queued", s.queued);
+    printStage("latency", s.latency);
+    std::cout << "  dropped " << s.droppedCapture << " (process busy) "
+              << s.droppedProcess << " (output busy)";
+    if (s.delayMs > 0 || s.droppedDelay > 0) std::cout << " " << s.droppedDelay << " (delay line)";
+    std::cout << "\n  A/V delay " << s.delayMs << " ms\n";
+
+    const AmbientProcessor::Stats& a = s.ambient;
+    const double frames = a.frames ? double(a.frames) : 1.0;
+    std::cout << "[MAIN] Ambient: " << a.frames << " frames, process avg " << a.processNs / 1000.0 / frames
+              << " us, border avg " << a.borderNs / 1000.0 / frames << " us, crop " << a.crop.top << "/"
+              << a.crop.bottom << "/" << a.crop.left << "/" << a.crop.right << " (" << a.cropChanges
+              << " changes)";
+    // busy time per worker and frame; one far above the others means the
+    // LED ranges are not balanced for this layout
+    if (!a.workerNs.empty()) {
+        std::cout << ", workers";
+        for (uint64_t ns : a.workerNs) std::cout << " " << ns / 1000.0 / frames;
+        std::cout << " us";
+    }
+    std::cout << std::endl;
+}
+
+// --replay/--bench-replay options: FILE [--format F] [--size WxH] [--fps N] [--loop]
+static bool parseReplayArgs(int argc, char** argv, int first, std::string& path,
+                            ReplaySource::Options& options)
+{
+    if (first >= argc) return false;
+    path = argv[first];
+    bool haveFormat = ReplaySource::formatFromPath(path, options.format);
+    for (int i = first + 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc)
+        {
+            if (!ReplaySource::parseFormat(argv[++i], options.format)) return false;
+            haveFormat = true;
+        }
+        else if (arg == "--size" && i + 1 < argc)
+        {
+            if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2) return false;
+        }
+        else if (arg == "--fps" && i + 1 < argc)
+        {
+            options.fps = std::atof(argv[++i]);
+        }
+        else if (arg == "--loop")
+        {
+            options.loop = true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (!haveFormat)
+    {
+        std::cerr << "[MAIN] " << path << ": .yuv may be planar or packed, pass --format yuyv|rgb|y4m\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    // --trace FILE / --config FILE (any position), the rest selects the mode
+    std::string tracePath;
+    std::string configPath;
+    std::vector<char*> args;
+    for (int i = 0; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) tracePath = argv[++i];
+        else if (std::strcmp(argv[i], "--config") == 0 && i + 1 < argc) configPath = argv[++i];
+        else args.push_back(argv[i]);
+    }
+    argc = static_cast<int>(args.size());
+    argv = args.data();
+
+    // config file: explicit path must load, the default one is optional
+    Config config;
+    {
+        const bool explicitPath = !configPath.empty();
+        if (!explicitPath) configPath = DEFAULT_CONFIG_PATH;
+        std::string error;
+        if ((explicitPath || access(configPath.c_str(), R_OK) == 0) && !loadConfig(configPath, config, error))
+        {
+            std::cerr << "[MAIN] " << error << "\n";
+            return 1;
+        }
+        if (!explicitPath && access(configPath.c_str(), R_OK) != 0) configPath.clear();
+    }
+
+    // led_daemon --bench-latency [probes]: headless glass-to-LED measurement
+    if (argc > 1 && std::strcmp(argv[1], "--bench-latency") == 0)
+    {
+        LatencyOptions options;
+        options.leds = config.ledCount;
+        if (argc > 2) options.probes = std::max(1, std::atoi(argv[2]));
+        return runLatencyHarness(options);
+    }
+
+    // replay a recording instead of the dummy pattern; --bench-replay runs
+    // it headless as fast as possible and reports the throughput
+    std::unique_ptr<FrameSource> source;
+    if (argc > 1 && (std::strcmp(argv[1], "--replay") == 0 || std::strcmp(argv[1], "--bench-replay") == 0))
+    {
+        const bool bench = std::strcmp(argv[1], "--bench-replay") == 0;
+        std::string path;
+        ReplaySource::Options options;
+        options.fps = bench ? 0.0 : -1.0;    // bench: unpaced, daemon: file rate
+        if (!parseReplayArgs(argc, argv, 2, path, options))
+        {
+            std::cerr << "usage: " << argv[0] << " " << argv[1]
+                      << " FILE[.y4m|.rgb|.yuyv] [--format rgb|yuyv|y4m] [--size WxH] [--fps N] [--loop]\n";
+            return 2;
+        }
+        try
+        {
+            source = std::make_unique<ReplaySource>(path, options);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "[MAIN] " << e.what() << "\n";
+            return 1;
+        }
+        if (bench) return runThroughputHarness(*source, config.ledCount, tracePath);
+    }
+
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
 
@@ -27,86 +243,165 @@ int main()
     // 1. Create main components
     // -------------------------------------------------------
 
-    const int NUM_LEDS = 60;
+    LEDDriver driver(std::make_unique<SpiSink>(config.device, config.spiSpeedHz), config.ledCount);
+    AmbientProcessor ambient(config.ledCount);
+    applyConfig(config, nullptr, driver, ambient);
+    if (!tracePath.empty() && !driver.startTrace(tracePath)) return 1;
 
-    LEDController led(NUM_LEDS, "/dev/spidev0.0");
-    AmbientProcessor ambient(NUM_LEDS);
+    // Capture (hier erstmal nur dummy)
+    if (!source) source = std::make_unique<DummySource>(config.captureWidth, config.captureHeight, config.captureFps);
 
-    // -------------------------------------------------------
-    // 2. Start Python IPC + Webserver in threads
-    // -------------------------------------------------------
+    // every producer feeds a prioritized input, the live one on top is shown
+    SourceManager sources(driver, config.fadeMs);
+    SourceManager::Input& captureInput = sources.add("capture", config.captureSource);
+    SourceManager::Input* ipcInput = &sources.add("ipc", config.ipcSource);
+    SourceManager::Input& effectInput = sources.add("effect", config.effectSource);
+    SourceManager::Input* e131Input = config.e131 ? &sources.add("e131", config.networkSource) : nullptr;
+    SourceManager::Input* artnetInput = config.artnet ? &sources.add("artnet", config.networkSource) : nullptr;
+    SourceManager::Input* ddpInput = config.ddp ? &sources.add("ddp", config.networkSource) : nullptr;
+    SourceManager::Input* opcInput = config.opc ? &sources.add("opc", config.networkSource) : nullptr;
 
-    std::thread pythonThread([&]() {
-        if (!py.start())
+    // audio reactive mode: WAV file or stream -> spectrum + beats
+    std::unique_ptr<AudioSource> audioSource;
+    if (config.audio)
+    {
+        try
         {
-            std::cerr << "[PY] Failed to start Python Interface.\n";
-            return;
+            audioSource = openAudioSource(config.audioDevice);
         }
-
-        while (running)
+        catch (const std::exception& e)
         {
-            py.poll();   // handles incoming messages
-            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            std::cerr << "[MAIN] Audio disabled: " << e.what() << std::endl;
         }
+    }
+    SourceManager::Input* audioInput = audioSource ? &sources.add("audio", config.audioSource) : nullptr;
+    sources.start();
 
-        py.stop();
-    });
+    // built-in animations, selected with EFFECT (or effects.effect)
+    EffectEngine effects(effectInput, config.effectRate);
+    {
+        std::string error;
+        effects.command(config.effect, error);
+    }
+    effects.start();
+
+    std::unique_ptr<AudioReactive> audio;
+    if (audioInput)
+    {
+        AudioReactive::Settings settings;
+        settings.fftSize = config.audioFft;
+        settings.bands = config.audioBands;
+        settings.segments = config.output.segments;
+        audio = std::make_unique<AudioReactive>(*audioInput, std::move(audioSource), settings);
+        audio->start();
+    }
 
-    // IPC-Server starten
-    std::thread ipcThread([&driver]() {
-        runIPCServer(&driver);
-    });
+    // capture path, started below; built here so IPC and the config watcher
+    // can adjust its A/V delay
+    Pipeline pipeline(*source, ambient, captureInput);
+    pipeline.setDelayMs(config.captureDelayMs);
 
     // -------------------------------------------------------
-    // 3. Main LED loop
+    // 2. IPC-Server starten (stopped first on shutdown, before the
+    //    objects its commands reach)
     // -------------------------------------------------------
-    
-    std::cout << "[MAIN] System running.\n";
+    IpcServer ipc(driver, config.port, ipcInput, &effects, &pipeline);
+    ipc.start();
 
-    while (running)
+    // E1.31 / Art-Net: lighting consoles and other LED software
+    std::vector<std::unique_ptr<DmxReceiver>> receivers;
+    if (e131Input)
     {
-        // -----------------------------------------
-        // (A) Capture Frame (hier erstmal nur dummy)
-        // -----------------------------------------
-
-        const int WIDTH = 32;
-        const int HEIGHT = 18;
-        static uint8_t dummyFrame[WIDTH * HEIGHT * 3];
+        DmxReceiver::Params params;
+        params.protocol = DmxReceiver::Protocol::E131;
+        params.startUniverse = config.e131Universe;
+        params.ledsPerUniverse = config.ledsPerUniverse;
+        receivers.push_back(std::make_unique<DmxReceiver>(*e131Input, params));
+    }
+    if (artnetInput)
+    {
+        DmxReceiver::Params params;
+        params.protocol = DmxReceiver::Protocol::ArtNet;
+        params.startUniverse = config.artnetUniverse;
+        params.ledsPerUniverse = config.ledsPerUniverse;
+        receivers.push_back(std::make_unique<DmxReceiver>(*artnetInput, params));
+    }
+    for (auto& r : receivers) r->start();
+    std::unique_ptr<DdpReceiver> ddp;
+    if (ddpInput)
+    {
+        ddp = std::make_unique<DdpReceiver>(*ddpInput, config.ddpPort);
+        ddp->start();
+    }
+    std::unique_ptr<OpcServer> opc;
+    if (opcInput)
+    {
+        opc = std::make_unique<OpcServer>(*opcInput, config.opcPort, config.opcChannels);
+        opc->start();
+    }
 
-        // Fake animation pattern
-        static int t = 0;
-        for (int i = 0; i < WIDTH * HEIGHT * 3; i += 3)
-        {
-            dummyFrame[i + 0] = (uint8_t)((sin(t * 0.05) * 0.5 + 0.5) * 255);
-            dummyFrame[i + 1] = (uint8_t)((cos(t * 0.07) * 0.5 + 0.5) * 255);
-            dummyFrame[i + 2] = 0;
-        }
-        t++;
+    // hot reload: LUTs are rebuilt on the watcher thread and swapped in,
+    // ambient settings are picked up between two frames
+    std::unique_ptr<ConfigWatcher> watcher;
+    if (!configPath.empty())
+    {
+        watcher = std::make_unique<ConfigWatcher>(configPath, [&driver, &ambient, &effects, &pipeline, config](const Config& next) mutable {
+            applyConfig(next, &config, driver, ambient);
+            std::string error;
+            if (next.effect != config.effect) effects.command(next.effect, error);
+            if (next.captureDelayMs != config.captureDelayMs) pipeline.setDelayMs(next.captureDelayMs);
+            config = next;
+        });
+        watcher->start();
+    }
 
-        // -----------------------------------------
-        // (B) Compute LED colors
-        // -----------------------------------------
-        std::vector<RGB> ledColors = ambient.processFrame(dummyFrame, WIDTH, HEIGHT);
+    // -------------------------------------------------------
+    // 3. Capture -> Process -> Output, one thread per stage
+    // -------------------------------------------------------
+    pipeline.start();
 
-        // -----------------------------------------
-        // (C) LED → SPI output
-        // -----------------------------------------
-        led.setPixels(ledColors);
-        led.send();
+    std::cout << "[MAIN] System running.\n";
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(16)); // ~60 FPS
+    auto nextReport = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (running && !pipeline.finished())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (std::chrono::steady_clock::now() >= nextReport)
+        {
+            printStats(pipeline.stats());
+            for (const auto& r : receivers) printReceiver(*r);
+            if (ddp) printReceiver(*ddp);
+            if (opc) printReceiver(*opc);
+            printEffects(effects);
+            if (audio) printAudio(*audio);
+            printSources(sources);
+            nextReport += std::chrono::seconds(10);
+        }
     }
 
     // -------------------------------------------------------
     // 4. Shutdown
     // -------------------------------------------------------
-    std::cout << "[MAIN] Stopping…\n";
+    std::cout << "\n[MAIN] Stopping…\n";
 
-    pythonThread.join();
-    ipcThread.join();
+    ipc.stop();
+    if (watcher) watcher->stop();
+    for (auto& r : receivers) r->stop();
+    if (ddp) ddp->stop();
+    if (opc) opc->stop();
+    effects.stop();
+    if (audio) audio->stop();
+    pipeline.stop();
+    printStats(pipeline.stats());
+    for (const auto& r : receivers) printReceiver(*r);
+    if (ddp) printReceiver(*ddp);
+    if (opc) printReceiver(*opc);
+    printEffects(effects);
+    if (audio) printAudio(*audio);
+    sources.stop();
+    printSources(sources);
 
-    led.clear();
-    led.send();
+    driver.clear();
 
     std::cout << "==== Ambilight System Stopped ====\n";
     return 0;
@@ -0,0 +1,252 @@
+// cpp/src/opc_server.cpp
+#include "opc_server.h"
+#include "frame_source.h"
+
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+OpcServer::OpcServer(FrameTarget& target, int port, std::vector<Mapping> mapping)
+    : _target(target),
+      _port(port),
+      _mapping(std::move(mapping)),
+      _frame(target.numLeds(), RGB{0, 0, 0}),
+      _scratch(4096)
+{
+    const int numLeds = target.numLeds();
+    if (_mapping.empty()) _mapping.push_back(Mapping{1, 0, numLeds});
+    for (Mapping& m : _mapping) {
+        m.start = std::clamp(m.start, 0, numLeds);
+        m.count = std::clamp(m.count, 0, numLeds - m.start);
+    }
+    _clients.reserve(MAX_CLIENTS);
+}
+
+OpcServer::~OpcServer() {
+    stop();
+}
+
+bool OpcServer::parseMapping(const std::string& spec, std::vector<Mapping>& out) {
+    std::vector<Mapping> result;
+    std::istringstream iss(spec);
+    std::string entry;
+    while (iss >> entry) {
+        int channel = 0, start = 0, count = 0;
+        char tail = 0;
+        if (std::sscanf(entry.c_str(), "%d:%d:%d%c", &channel, &start, &count, &tail) != 3) return false;
+        if (channel < 1 || channel > 255 || start < 0 || count <= 0) return false;
+        result.push_back(Mapping{static_cast<uint8_t>(channel), start, count});
+    }
+    out = std::move(result);
+    return true;
+}
+
+// -----------------------------
+// Start / Stop
+// -----------------------------
+bool OpcServer::start() {
+    stop();
+    _listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_listenFd < 0 || _wakeFd < 0) {
+        perror("[OPC] socket");
+        stop();
+        return false;
+    }
+
+    int opt = 1;
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(_port);
+    if (bind(_listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(_listenFd, 3) < 0) {
+        perror(("[OPC] bind " + std::to_string(_port)).c_str());
+        stop();
+        return false;
+    }
+
+    _thread = std::thread(&OpcServer::loop, this);
+    pthread_setname_np(_thread.native_handle(), "amb-opc");
+    std::cout << "[OPC] Listening on port " << _port << ", " << _mapping.size() << " channel(s)" << std::endl;
+    return true;
+}
+
+void OpcServer::stop() {
+    if (_thread.joinable()) {
+        uint64_t one = 1;
+        if (write(_wakeFd, &one, sizeof(one)) < 0) perror("[OPC] wake");
+        _thread.join();
+    }
+    for (Client& c : _clients) close(c.fd);
+    _clients.clear();
+    if (_listenFd >= 0) close(_listenFd);
+    if (_wakeFd >= 0) close(_wakeFd);
+    _listenFd = _wakeFd = -1;
+}
+
+OpcServer::Stats OpcServer::stats() const {
+    Stats s;
+    s.messages = _messages.load(std::memory_order_relaxed);
+    s.frames = _frames.load(std::memory_order_relaxed);
+    s.coalesced = _coalesced.load(std::memory_order_relaxed);
+    s.skipped = _skipped.load(std::memory_order_relaxed);
+    s.clients = _accepted.load(std::memory_order_relaxed);
+    return s;
+}
+
+// -----------------------------
+// Empfang
+// -----------------------------
+void OpcServer::loop() {
+    std::vector<pollfd> fds;
+    uint64_t pendingSinceNs = 0;
+    for (;;) {
+        fds.clear();
+        fds.push_back({ _listenFd, POLLIN, 0 });
+        fds.push_back({ _wakeFd, POLLIN, 0 });
+        for (const Client& c : _clients) fds.push_back({ c.fd, POLLIN, 0 });
+
+        if (poll(fds.data(), fds.size(), _pending ? STALL_MS : -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("[OPC] poll");
+            return;
+        }
+        if (fds[1].revents) return;
+
+        // drain every readable client; closed ones are dropped
+        size_t kept = 0;
+        for (size_t i = 0; i < _clients.size(); ++i) {
+            Client& c = _clients[i];
+            if (fds[i + 2].revents && !readClient(c)) {
+                close(c.fd);
+                continue;
+            }
+            if (kept != i) _clients[kept] = c;
+            ++kept;
+        }
+        _clients.resize(kept);
+        if (fds[0].revents) acceptClients();
+
+        // one render per round, never in the middle of a payload
+        if (_pending) {
+            const uint64_t now = monotonicNs();
+            if (pendingSinceNs == 0) pendingSinceNs = now;
+            const bool midMessage = std::any_of(_clients.begin(), _clients.end(),
+                                                [](const Client& c) { return c.headerGot > 0; });
+            if (!midMessage || now - pendingSinceNs >= uint64_t(STALL_MS) * 1000000) {
+                render();
+                pendingSinceNs = 0;
+            }
+        }
+    }
+}
+
+void OpcServer::acceptClients() {
+    for (;;) {
+        const int fd = accept4(_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        if (_clients.size() >= MAX_CLIENTS) {
+            std::cerr << "[OPC] too many clients, connection refused\n";
+            close(fd);
+            continue;
+        }
+        Client c;
+        c.fd = fd;
+        _clients.push_back(c);
+        _accepted.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// reads until EAGAIN: header on its own, payload in place
+bool OpcServer::readClient(Client& c) {
+    for (;;) {
+        uint8_t* dst;
+        size_t want;
+        if (c.headerGot < HEADER) {
+            dst = c.header + c.headerGot;
+            want = HEADER - c.headerGot;
+        } else {
+            const size_t cap = c.target ? size_t(c.target->count) * 3 : 0;
+            if (c.pos < cap) {
+                dst = reinterpret_cast<uint8_t*>(_frame.data() + c.target->start) + c.pos;
+                want = std::min(c.remaining, cap - c.pos);
+            } else {
+                dst = _scratch.data();
+                want = std::min(c.remaining, _scratch.size());
+            }
+        }
+
+        const ssize_t n = recv(c.fd, dst, want, 0);
+        if (n == 0) return false;
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        if (c.headerGot < HEADER) {
+            c.headerGot += n;
+            if (c.headerGot == HEADER) beginPayload(c);
+        } else {
+            c.pos += n;
+            c.remaining -= n;
+        }
+        if (c.headerGot == HEADER && c.remaining == 0) finishMessage(c);
+    }
+}
+
+void OpcServer::beginPayload(Client& c) {
+    const uint8_t channel = c.header[0];
+    const uint8_t command = c.header[1];
+    c.remaining = static_cast<size_t>(c.header[2] << 8 | c.header[3]);
+    c.pos = 0;
+    c.target = nullptr;
+    c.broadcast = channel == 0;
+    if (command != CMD_SET_PIXELS) return;
+    if (c.broadcast) {
+        c.target = &_mapping.front();
+        return;
+    }
+    for (const Mapping& m : _mapping) {
+        if (m.channel == channel) {
+            c.target = &m;
+            break;
+        }
+    }
+}
+
+void OpcServer::finishMessage(Client& c) {
+    if (c.target) {
+        // broadcast: the first range received it, the others get a copy
+        if (c.broadcast) {
+            const size_t bytes = std::min(c.pos, size_t(c.target->count) * 3);
+            const uint8_t* src = reinterpret_cast<const uint8_t*>(_frame.data() + c.target->start);
+            for (size_t i = 1; i < _mapping.size(); ++i) {
+                const Mapping& m = _mapping[i];
+                std::memmove(_frame.data() + m.start, src, std::min(bytes, size_t(m.count) * 3));
+            }
+        }
+        _messages.fetch_add(1, std::memory_order_relaxed);
+        ++_pending;
+    } else {
+        _skipped.fetch_add(1, std::memory_order_relaxed);
+    }
+    c.headerGot = 0;
+    c.pos = 0;
+    c.target = nullptr;
+}
+
+void OpcServer::render() {
+    _target.submitFrame(_frame);
+    _frames.fetch_add(1, std::memory_order_relaxed);
+    _coalesced.fetch_add(_pending - 1, std::memory_order_relaxed);
+    _pending = 0;
+}
@@ -0,0 +1,74 @@
+// cpp/src/output_sink.cpp
+#include "output_sink.h"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+// -----------------------------
+// Konfiguration / Defaults
+// -----------------------------
+static constexpr uint8_t DEFAULT_SPI_MODE = SPI_MODE_0;
+static constexpr int DEFAULT_BITS_PER_WORD = 8;
+static constexpr useconds_t LATCH_US = 500; // small pause to latch WS2801
+
+// -----------------------------
+// SPI open/close
+// -----------------------------
+SpiSink::SpiSink(const std::string& device, uint32_t speedHz)
+    : _device(device)
+{
+    _fd = open(_device.c_str(), O_RDWR);
+    if (_fd < 0) {
+        perror(("open SPI " + _device).c_str());
+        throw std::runtime_error("Failed to open SPI device: " + _device);
+    }
+
+    // mode
+    if (ioctl(_fd, SPI_IOC_WR_MODE, &DEFAULT_SPI_MODE) < 0) {
+        perror("SPI set mode");
+    }
+
+    // bits per word
+    if (ioctl(_fd, SPI_IOC_WR_BITS_PER_WORD, &DEFAULT_BITS_PER_WORD) < 0) {
+        perror("SPI set bits per word");
+    }
+
+    // max speed
+    uint32_t speed = speedHz;
+    if (ioctl(_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0) {
+        perror("SPI set max speed");
+    }
+
+    // Good to know
+    std::cerr << "[LEDDriver] Opened SPI " << _device << " fd=" << _fd
+              << " speed=" << speed << "Hz\n";
+}
+
+SpiSink::~SpiSink() {
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+bool SpiSink::write(const uint8_t* data, size_t size) {
+    ssize_t written = ::write(_fd, data, size);
+    bool ok = true;
+    if (written < 0) {
+        perror("SPI write");
+        ok = false;
+    } else if (static_cast<size_t>(written) != size) {
+        std::cerr << "[LEDDriver] Warning: partial SPI write " << written << "/" << size << "\n";
+        ok = false;
+    }
+
+    // small pause for latch
+    usleep(LATCH_US);
+    return ok;
+}
@@ -0,0 +1,296 @@
+// cpp/src/pipeline.cpp
+#include "pipeline.h"
+#include "ambient_processor.h"
+#include "frame_target.h"
+
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstring>
+#include <iostream>
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32-bit word");
+
+static constexpr int SPIN_ITERATIONS = 2000;
+
+// -----------------------------
+// Hilfsfunktionen
+// -----------------------------
+static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+static inline void futexWait(std::atomic<uint32_t>& word, uint32_t expected, uint64_t timeoutNs) {
+    timespec ts{ static_cast<time_t>(timeoutNs / 1000000000ull), static_cast<long>(timeoutNs % 1000000000ull) };
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected,
+            timeoutNs ? &ts : nullptr, nullptr, 0);
+}
+
+static inline void futexWake(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static void setupThread(std::thread& t, int core, const char* name) {
+    pthread_setname_np(t.native_handle(), name);
+    if (core < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    int err = pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+    if (err != 0) {
+        std::cerr << "[Pipeline] could not pin " << name << " to core " << core
+                  << ": " << std::strerror(err) << "\n";
+    }
+}
+
+// -----------------------------
+// Wakeup
+// -----------------------------
+// The sleeper count is raised before the futex re-checks _seq, and notify()
+// bumps _seq before reading the count (both seq_cst): either the notifier
+// sees the sleeper and wakes it, or the futex sees the new _seq and returns.
+void Pipeline::Wakeup::wait(uint32_t seen, int& spins, uint64_t timeoutNs) {
+    if (spins < SPIN_ITERATIONS) {
+        ++spins;
+        cpuRelax();
+        return;
+    }
+    _sleepers.fetch_add(1);
+    futexWait(_seq, seen, timeoutNs);
+    _sleepers.fetch_sub(1);
+}
+
+void Pipeline::Wakeup::notify() {
+    _seq.fetch_add(1);
+    if (_sleepers.load() > 0) futexWake(_seq);
+}
+
+// -----------------------------
+// Stage counters
+// -----------------------------
+void Pipeline::StageCounter::add(uint64_t ns) {
+    // single writer: plain load/store pairs are enough
+    frames.store(frames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    totalNs.store(totalNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    if (ns > maxNs.load(std::memory_order_relaxed)) maxNs.store(ns, std::memory_order_relaxed);
+}
+
+Pipeline::StageStats Pipeline::StageCounter::snapshot() const {
+    StageStats s;
+    s.frames = frames.load(std::memory_order_relaxed);
+    s.totalNs = totalNs.load(std::memory_order_relaxed);
+    s.maxNs = maxNs.load(std::memory_order_relaxed);
+    return s;
+}
+
+// -----------------------------
+// Pipeline Implementation
+// -----------------------------
+Pipeline::Params Pipeline::defaultParams() {
+    Params p;
+    if (std::thread::hardware_concurrency() >= 4) {
+        p.cores[0] = 1;
+        p.cores[1] = 2;
+        p.cores[2] = 3;
+    }
+    return p;
+}
+
+Pipeline::Pipeline(FrameSource& source, AmbientProcessor& processor, FrameTarget& target,
+                   const Params& params)
+    : _source(source),
+      _processor(processor),
+      _target(target),
+      _params(params),
+      _delay(target.numLeds())
+{
+    for (auto& slot : _colors) slot.colors.reserve(target.numLeds());
+    // capture and process each start out holding slot 0
+    for (int i = 1; i < static_cast<int>(SLOTS); ++i) {
+        _freeFrames.tryPush(i);
+        _freeColors.tryPush(i);
+    }
+}
+
+Pipeline::~Pipeline() {
+    stop();
+}
+
+void Pipeline::start() {
+    if (_running) return;
+    _running = true;
+    _threads[0] = std::thread(&Pipeline::captureLoop, this);
+    _threads[1] = std::thread(&Pipeline::processLoop, this);
+    _threads[2] = std::thread(&Pipeline::outputLoop, this);
+    static const char* NAMES[3] = { "amb-capture", "amb-process", "amb-output" };
+    for (int i = 0; i < 3; ++i) setupThread(_threads[i], _params.cores[i], NAMES[i]);
+}
+
+void Pipeline::stop() {
+    _running = false;
+    for (Wakeup* w : { &_wakeCapture, &_wakeProcess, &_wakeOutput }) w->notify();
+    for (auto& t : _threads) {
+        if (t.joinable()) t.join();
+    }
+}
+
+Pipeline::Stats Pipeline::stats() const {
+    Stats s;
+    s.capture = _capture.snapshot();
+    s.process = _process.snapshot();
+    s.output = _output.snapshot();
+    s.queued = _queued.snapshot();
+    s.latency = _latency.snapshot();
+    s.droppedCapture = _droppedCapture.load(std::memory_order_relaxed);
+    s.droppedProcess = _droppedProcess.load(std::memory_order_relaxed);
+    s.delayMs = _delay.delayMs();
+    s.droppedDelay = _delay.dropped();
+    s.ambient = _processor.stats();
+    return s;
+}
+
+// false = the next stage is busy and the frame should be dropped
+bool Pipeline::push(SpscQueue<int, QUEUE_DEPTH>& queue, int slot) {
+    if (queue.tryPush(slot)) return true;
+    if (!_params.blocking) return false;
+    // the consumer of queue frees a slot and then signals the producer
+    Wakeup& wake = &queue == &_toProcess ? _wakeCapture : _wakeProcess;
+    int spins = 0;
+    for (;;) {
+        const uint32_t seen = wake.prepare();
+        if (queue.tryPush(slot)) return true;
+        if (!_running) return false;
+        wake.wait(seen, spins);
+    }
+}
+
+void Pipeline::captureLoop() {
+    int slot = 0;
+    while (_running) {
+        FrameSlot& fs = _frames[slot];
+        if (!_source.capture(fs.frame)) break;
+        const uint64_t now = monotonicNs();
+        _capture.add(now - fs.frame.timestampNs);
+
+        fs.enqueuedNs = now;
+        if (!push(_toProcess, slot)) {
+            ++_droppedCapture;       // keep the slot, overwrite it next time
+            continue;
+        }
+        _wakeProcess.notify();
+        int spins = 0;
+        for (;;) {
+            const uint32_t seen = _wakeCapture.prepare();
+            if (_freeFrames.tryPop(slot)) break;
+            if (!_running) return;
+            _wakeCapture.wait(seen, spins);
+        }
+    }
+    _captureDone = true;
+    _wakeProcess.notify();
+}
+
+void Pipeline::processLoop() {
+    int out = 0;
+    int spins = 0;
+    while (_running) {
+        const uint32_t seen = _wakeProcess.prepare();
+        int slot;
+        if (!_toProcess.tryPop(slot)) {
+            // upstream finished: one more look, its last push happened before the flag
+            if (_captureDone) {
+                if (!_toProcess.tryPop(slot)) break;
+            } else {
+                _wakeProcess.wait(seen, spins);
+                continue;
+            }
+        }
+        spins = 0;
+
+        FrameSlot& fs = _frames[slot];
+        ColorSlot& cs = _colors[out];
+        const uint64_t t0 = monotonicNs();
+        const std::vector<RGB>& colors = _processor.processFrame(fs.frame.pixels(), fs.frame.width,
+                                                                 fs.frame.height, fs.frame.mediaNs);
+        cs.colors.assign(colors.begin(), colors.end());
+        const uint64_t t1 = monotonicNs();
+        _process.add(t1 - t0);
+
+        cs.timestampNs = fs.frame.timestampNs;
+        cs.mediaNs = fs.frame.mediaNs;
+        cs.queuedNs = t0 - fs.enqueuedNs;
+        _freeFrames.tryPush(slot);   // never full: holds at most SLOTS entries
+        _wakeCapture.notify();       // also a free entry in _toProcess (blocking mode)
+
+        cs.enqueuedNs = t1;
+        if (!push(_toOutput, out)) {
+            ++_droppedProcess;
+            continue;
+        }
+        _wakeOutput.notify();
+        int waits = 0;
+        for (;;) {
+            const uint32_t seen = _wakeProcess.prepare();
+            if (_freeColors.tryPop(out)) break;
+            if (!_running) return;
+            _wakeProcess.wait(seen, waits);
+        }
+    }
+    _processDone = true;
+    _wakeOutput.notify();
+}
+
+void Pipeline::outputLoop() {
+    int spins = 0;
+    while (_running) {
+        const uint32_t seen = _wakeOutput.prepare();
+        // read before popping: upstream's last push happened before the flag
+        const bool upstreamDone = _processDone;
+        int slot;
+        const bool popped = _toOutput.tryPop(slot);
+        if (popped) {
+            spins = 0;
+            ColorSlot& cs = _colors[slot];
+            _queued.add(cs.queuedNs + (monotonicNs() - cs.enqueuedNs));
+            if (_delay.delayMs() == 0 && _delay.empty()) {
+                emit(cs.colors, cs.timestampNs, cs.mediaNs);
+            } else {
+                _delay.push(cs.colors, cs.timestampNs, cs.mediaNs);
+            }
+            _freeColors.tryPush(slot);
+            _wakeProcess.notify();   // also a free entry in _toOutput (blocking mode)
+        }
+
+        uint64_t timestampNs = 0, mediaNs = 0;
+        const uint64_t now = monotonicNs();
+        if (const std::vector<RGB>* frame = _delay.due(now, timestampNs, mediaNs)) {
+            spins = 0;
+            emit(*frame, timestampNs, mediaNs);
+            continue;
+        }
+        if (popped) continue;
+        if (upstreamDone && _delay.empty()) break;
+        // held frames: sleep no longer than until the oldest is due
+        uint64_t dueNs = 0;
+        const uint64_t timeoutNs = _delay.nextDue(dueNs) ? (dueNs > now ? dueNs - now : 1) : 0;
+        _wakeOutput.wait(seen, spins, timeoutNs);
+    }
+    _outputDone = true;
+}
+
+void Pipeline::emit(const std::vector<RGB>& colors, uint64_t timestampNs, uint64_t mediaNs) {
+    const uint64_t t0 = monotonicNs();
+    _target.submitFrame(colors, mediaNs);
+    const uint64_t t1 = monotonicNs();
+    _output.add(t1 - t0);
+    _latency.add(t1 - timestampNs);
+}
@@ -0,0 +1,23 @@
+// cpp/src/power_limiter.cpp
+#include "power_limiter.h"
+
+void sumTriplets(const uint16_t* wire, int count, uint64_t out[3]) {
+    constexpr size_t LANES = 24;   // multiple of 3: lane j always holds position j % 3
+    uint32_t acc[LANES] = {};
+    const size_t n = static_cast<size_t>(count) * 3;
+
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (size_t j = 0; j < LANES; ++j) acc[j] += wire[i + j];
+    }
+
+    out[0] = out[1] = out[2] = 0;
+    for (size_t j = 0; j < LANES; ++j) out[j % 3] += acc[j];
+    for (; i < n; ++i) out[i % 3] += wire[i];
+}
+
+void scaleFrame(uint16_t* wire, size_t n, uint32_t scaleQ16) {
+    for (size_t i = 0; i < n; ++i) {
+        wire[i] = static_cast<uint16_t>((wire[i] * scaleQ16) >> 16);
+    }
+}
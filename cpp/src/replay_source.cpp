@@ -0,0 +1,244 @@
+// cpp/src/replay_source.cpp
+#include "replay_source.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+static constexpr double DEFAULT_FPS = 60.0;
+
+// -----------------------------
+// Hilfsfunktionen
+// -----------------------------
+static inline uint8_t clamp255(int v) {
+    if (v < 0) return 0;
+    if (v > 255) return 255;
+    return static_cast<uint8_t>(v);
+}
+
+// BT.601 limited range, 8 fractional bits
+static inline void yuvToRgb(int y, int u, int v, uint8_t* out) {
+    const int c = 298 * (y - 16) + 128;
+    const int d = u - 128;
+    const int e = v - 128;
+    out[0] = clamp255((c + 409 * e) >> 8);
+    out[1] = clamp255((c - 100 * d - 208 * e) >> 8);
+    out[2] = clamp255((c + 516 * d) >> 8);
+}
+
+// one row of YUYV (Y0 U Y1 V per pixel pair)
+static void convertYuyvRow(const uint8_t* src, uint8_t* dst, int width) {
+    for (int x = 0; x + 1 < width; x += 2) {
+        const int u = src[1];
+        const int v = src[3];
+        yuvToRgb(src[0], u, v, dst);
+        yuvToRgb(src[2], u, v, dst + 3);
+        src += 4;
+        dst += 6;
+    }
+    if (width & 1) yuvToRgb(src[0], src[1], src[3], dst);
+}
+
+// one row of planar YUV; chroma already points at the row, xShift = 1 for
+// horizontally subsampled chroma
+static void convertPlanarRow(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst,
+                             int width, int xShift) {
+    for (int x = 0; x < width; ++x) {
+        yuvToRgb(y[x], u[x >> xShift], v[x >> xShift], dst + x * 3);
+    }
+}
+
+// -----------------------------
+// ReplaySource Implementation
+// -----------------------------
+bool ReplaySource::formatFromPath(const std::string& path, Format& format) {
+    auto endsWith = [&](const char* ext) {
+        const size_t n = std::strlen(ext);
+        return path.size() >= n && path.compare(path.size() - n, n, ext) == 0;
+    };
+    if (endsWith(".yuv")) return false;
+    if (endsWith(".y4m")) format = Format::Y4M;
+    else if (endsWith(".yuyv")) format = Format::YUYV;
+    else format = Format::RGB24;
+    return true;
+}
+
+bool ReplaySource::parseFormat(const std::string& name, Format& format) {
+    if (name == "rgb") format = Format::RGB24;
+    else if (name == "yuyv") format = Format::YUYV;
+    else if (name == "y4m") format = Format::Y4M;
+    else return false;
+    return true;
+}
+
+ReplaySource::ReplaySource(const std::string& path, const Options& options)
+    : _format(options.format),
+      _loop(options.loop),
+      _pacer(0.0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        perror(("open " + path).c_str());
+        throw std::runtime_error("Failed to open replay file: " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Empty replay file: " + path);
+    }
+    _size = static_cast<size_t>(st.st_size);
+    void* map = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);   // the mapping keeps the file
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        throw std::runtime_error("Failed to map replay file: " + path);
+    }
+    _map = static_cast<const uint8_t*>(map);
+    madvise(map, _size, MADV_SEQUENTIAL);
+
+    try {
+        if (_format == Format::Y4M) {
+            parseY4M(path);
+        } else {
+            _width = options.width;
+            _height = options.height;
+            if (_width <= 0 || _height <= 0) {
+                throw std::runtime_error("Raw replay needs the frame size: " + path);
+            }
+            const size_t px = static_cast<size_t>(_width) * _height;
+            indexRaw(_format == Format::RGB24 ? px * 3 : ((_width + 1) / 2) * static_cast<size_t>(_height) * 4,
+                     path);
+        }
+    } catch (...) {
+        munmap(const_cast<uint8_t*>(_map), _size);
+        throw;
+    }
+
+    double fps = options.fps;
+    if (fps < 0.0) fps = _fileFps > 0.0 ? _fileFps : DEFAULT_FPS;
+    _pacer = FramePacer(fps);
+    const double mediaFps = fps > 0.0 ? fps : _fileFps > 0.0 ? _fileFps : DEFAULT_FPS;
+    _mediaStepNs = static_cast<uint64_t>(1e9 / mediaFps + 0.5);
+
+    std::cerr << "[Replay] " << path << ": " << _frames.size() << " frames " << _width << "x" << _height
+              << (fps > 0.0 ? " @ " + std::to_string(fps) + " fps" : std::string(" unpaced")) << "\n";
+}
+
+ReplaySource::~ReplaySource() {
+    if (_map) munmap(const_cast<uint8_t*>(_map), _size);
+}
+
+void ReplaySource::indexRaw(size_t frameBytes, const std::string& path) {
+    const size_t count = _size / frameBytes;
+    if (count == 0) throw std::runtime_error("Replay file shorter than one frame: " + path);
+    if (_size % frameBytes != 0) {
+        std::cerr << "[Replay] " << path << ": " << _size % frameBytes << " trailing bytes ignored\n";
+    }
+    _frames.resize(count);
+    for (size_t i = 0; i < count; ++i) _frames[i] = i * frameBytes;
+}
+
+// "YUV4MPEG2 W640 H360 F30000:1001 Ip A1:1 C420jpeg\n" then per frame
+// "FRAME[ params]\n" + Y, U, V planes
+void ReplaySource::parseY4M(const std::string& path) {
+    const char* text = reinterpret_cast<const char*>(_map);
+    const uint8_t* eol = static_cast<const uint8_t*>(std::memchr(_map, '\n', std::min<size_t>(_size, 1024)));
+    if (_size < 10 || std::memcmp(text, "YUV4MPEG2 ", 10) != 0 || !eol) {
+        throw std::runtime_error("Not a Y4M file: " + path);
+    }
+
+    _chroma = Chroma::C420;
+    std::istringstream header(std::string(text + 10, reinterpret_cast<const char*>(eol)));
+    std::string tag;
+    while (header >> tag) {
+        const std::string val = tag.substr(1);
+        switch (tag[0]) {
+            case 'W': _width = std::atoi(val.c_str()); break;
+            case 'H': _height = std::atoi(val.c_str()); break;
+            case 'F': {
+                const int num = std::atoi(val.c_str());
+                const size_t colon = val.find(':');
+                const int den = colon == std::string::npos ? 1 : std::atoi(val.c_str() + colon + 1);
+                if (num > 0 && den > 0) _fileFps = static_cast<double>(num) / den;
+                break;
+            }
+            case 'C':
+                if (val.compare(0, 3, "420") == 0) _chroma = Chroma::C420;
+                else if (val == "422") _chroma = Chroma::C422;
+                else if (val == "444") _chroma = Chroma::C444;
+                else throw std::runtime_error("Unsupported Y4M colorspace C" + val + ": " + path);
+                break;
+            default: break;   // interlacing, aspect, comments
+        }
+    }
+    if (_width <= 0 || _height <= 0) throw std::runtime_error("Y4M header without size: " + path);
+
+    const size_t luma = static_cast<size_t>(_width) * _height;
+    const size_t cw = _chroma == Chroma::C444 ? _width : (_width + 1) / 2;
+    const size_t ch = _chroma == Chroma::C420 ? (_height + 1) / 2 : _height;
+    const size_t frameBytes = luma + 2 * cw * ch;
+
+    size_t pos = static_cast<size_t>(eol - _map) + 1;
+    while (pos + 5 <= _size && std::memcmp(_map + pos, "FRAME", 5) == 0) {
+        const void* nl = std::memchr(_map + pos, '\n', std::min<size_t>(_size - pos, 256));
+        if (!nl) break;
+        const size_t data = static_cast<size_t>(static_cast<const uint8_t*>(nl) - _map) + 1;
+        if (data + frameBytes > _size) break;    // truncated last frame
+        _frames.push_back(data);
+        pos = data + frameBytes;
+    }
+    if (_frames.empty()) throw std::runtime_error("Y4M file without frames: " + path);
+}
+
+bool ReplaySource::capture(Frame& frame) {
+    if (_next == _frames.size()) {
+        if (!_loop) return false;
+        _next = 0;
+    }
+    _pacer.wait();
+
+    const uint8_t* src = _map + _frames[_next++];
+    frame.timestampNs = monotonicNs();
+    frame.mediaNs = (_seq + 1) * _mediaStepNs;   // not 0, which the filters read as "now"
+    frame.width = _width;
+    frame.height = _height;
+    frame.seq = _seq++;
+
+    if (_format == Format::RGB24) {
+        frame.external = src;        // zero-copy from the mapping
+        return true;
+    }
+
+    frame.external = nullptr;
+    frame.data.resize(static_cast<size_t>(_width) * _height * 3);
+    uint8_t* dst = frame.data.data();
+    const size_t rowBytes = static_cast<size_t>(_width) * 3;
+
+    if (_format == Format::YUYV) {
+        const size_t srcStride = static_cast<size_t>((_width + 1) / 2) * 4;
+        for (int y = 0; y < _height; ++y) convertYuyvRow(src + y * srcStride, dst + y * rowBytes, _width);
+        return true;
+    }
+
+    const size_t cw = _chroma == Chroma::C444 ? _width : (_width + 1) / 2;
+    const size_t ch = _chroma == Chroma::C420 ? (_height + 1) / 2 : _height;
+    const uint8_t* yPlane = src;
+    const uint8_t* uPlane = yPlane + static_cast<size_t>(_width) * _height;
+    const uint8_t* vPlane = uPlane + cw * ch;
+    const int xShift = _chroma == Chroma::C444 ? 0 : 1;
+    const int yShift = _chroma == Chroma::C420 ? 1 : 0;
+    for (int y = 0; y < _height; ++y) {
+        const size_t crow = static_cast<size_t>(y >> yShift) * cw;
+        convertPlanarRow(yPlane + static_cast<size_t>(y) * _width, uPlane + crow, vPlane + crow,
+                         dst + y * rowBytes, _width, xShift);
+    }
+    return true;
+}
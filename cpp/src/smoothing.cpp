@@ -0,0 +1,77 @@
+// cpp/src/smoothing.cpp
+#include "smoothing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// -----------------------------
+// exp-Tabelle
+// -----------------------------
+static constexpr int EXP_TABLE_SIZE = 256;
+static constexpr float EXP_TABLE_RANGE = 8.0f;              // x = 0..8, exp(-8) = 3e-4
+
+struct ExpTable
+{
+    float v[EXP_TABLE_SIZE + 1];                            // + 1 for the interpolation
+
+    ExpTable() {
+        for (int i = 0; i <= EXP_TABLE_SIZE; ++i) {
+            v[i] = static_cast<float>(std::exp(-static_cast<double>(i) * EXP_TABLE_RANGE / EXP_TABLE_SIZE));
+        }
+    }
+};
+
+static const ExpTable& expTable() {
+    static const ExpTable table;
+    return table;
+}
+
+float emaAlpha(uint64_t dtNs, float tauMs) {
+    if (tauMs <= 0.0f) return 1.0f;
+    const float x = static_cast<float>(dtNs) * 1e-6f / tauMs * (EXP_TABLE_SIZE / EXP_TABLE_RANGE);
+    if (x >= static_cast<float>(EXP_TABLE_SIZE)) return 1.0f;
+    const float* v = expTable().v;
+    const int i = static_cast<int>(x);
+    return 1.0f - (v[i] + (v[i + 1] - v[i]) * (x - static_cast<float>(i)));
+}
+
+float alphaToTauMs(float alpha) {
+    if (alpha >= 1.0f) return 0.0f;
+    if (alpha <= 0.0f) return MAX_SMOOTHING_MS;
+    const float tau = -1000.0f / SMOOTHING_REFERENCE_HZ / std::log(1.0f - alpha);
+    return std::min(tau, MAX_SMOOTHING_MS);
+}
+
+float windowToTauMs(int frames) {
+    return std::max(0, frames - 1) * 500.0f / SMOOTHING_REFERENCE_HZ;
+}
+
+// -----------------------------
+// Änderungsmaß
+// -----------------------------
+
+SmoothingResponse classifyChange(float meanAbsDiff, const AdaptiveSmoothing& params) {
+    if (params.cutThreshold > 0.0f && meanAbsDiff >= params.cutThreshold) return SmoothingResponse::Snap;
+    if (params.attackThreshold > 0.0f && meanAbsDiff >= params.attackThreshold) return SmoothingResponse::Fast;
+    return SmoothingResponse::Slow;
+}
+
+uint32_t sumAbsDiff(const uint8_t* a, const uint8_t* b, size_t n) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += static_cast<uint32_t>(std::abs(static_cast<int>(a[i]) - static_cast<int>(b[i])));
+    }
+    return sum;
+}
+
+// integer accumulation (rounded state) so the reduction vectorizes without
+// -ffast-math; the metric only needs whole steps
+uint32_t sumAbsDiff(const uint8_t* a, const float* b, size_t n) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int v = static_cast<int>(b[i] + 0.5f);
+        sum += static_cast<uint32_t>(std::abs(static_cast<int>(a[i]) - v));
+    }
+    return sum;
+}
@@ -0,0 +1,259 @@
+// cpp/src/source_manager.cpp
+#include "source_manager.h"
+#include "frame_source.h"
+
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+// -----------------------------
+// Input (Producer-Seite)
+// -----------------------------
+void SourceManager::Input::submitFrame(const std::vector<RGB>& colors, uint64_t) {
+    _manager->publish(*this, colors);
+}
+
+int SourceManager::Input::numLeds() const {
+    return _manager->_numLeds;
+}
+
+void SourceManager::Input::release() {
+    _manager->release(*this);
+}
+
+void SourceManager::publish(Input& in, const std::vector<RGB>& colors) {
+    if (colors.size() != size_t(_numLeds)) return;
+    std::copy(colors.begin(), colors.end(), in._buffers[in._back].begin());
+    const uint8_t prev = in._middle.exchange(in._back | Input::FRESH, std::memory_order_acq_rel);
+    in._back = prev & Input::INDEX;
+    if (prev & Input::FRESH) in._superseded.fetch_add(1, std::memory_order_relaxed);
+    in._submitted.fetch_add(1, std::memory_order_relaxed);
+
+    in._lastNs.store(monotonicNs(), std::memory_order_relaxed);
+    _live.fetch_or(in._bit, std::memory_order_release);
+    if (in._rank <= _winner.load(std::memory_order_relaxed)) wake();
+}
+
+void SourceManager::release(Input& in) {
+    in._lastNs.store(0, std::memory_order_relaxed);
+    _live.fetch_and(~in._bit, std::memory_order_release);
+    if (in._rank <= _winner.load(std::memory_order_relaxed)) wake();
+}
+
+void SourceManager::wake() {
+    uint64_t one = 1;
+    if (_wakeFd >= 0 && write(_wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) perror("[Sources] wake");
+}
+
+// -----------------------------
+// Verwaltung
+// -----------------------------
+SourceManager::SourceManager(FrameTarget& target, int fadeMs)
+    : _target(target),
+      _numLeds(target.numLeds()),
+      _fadeNs(uint64_t(std::max(0, fadeMs)) * 1000000),
+      _compositor(target.numLeds())
+{
+    _inputs.reserve(MAX_SOURCES);
+    _layers.reserve(MAX_SOURCES);
+}
+
+SourceManager::~SourceManager() {
+    stop();
+}
+
+SourceManager::Input& SourceManager::add(const std::string& name, const SourcePolicy& policy) {
+    if (_inputs.size() >= MAX_SOURCES) throw std::runtime_error("[Sources] too many sources");
+    auto in = std::make_unique<Input>();
+    in->_manager = this;
+    in->_name = name;
+    in->_policy = policy;
+    in->_timeoutNs = uint64_t(std::max(0, policy.timeoutMs)) * 1000000;
+    in->_opacity = static_cast<uint32_t>(std::clamp(policy.opacity, 0.0f, 1.0f) * OPAQUE + 0.5f);
+    for (auto& b : in->_buffers) b.assign(_numLeds, RGB{0, 0, 0});
+    _inputs.push_back(std::move(in));
+
+    // bit order = priority order (stable for equal priorities)
+    _byRank.clear();
+    for (auto& i : _inputs) _byRank.push_back(i.get());
+    std::stable_sort(_byRank.begin(), _byRank.end(),
+                     [](const Input* a, const Input* b) { return a->_policy.priority > b->_policy.priority; });
+    _opaqueMask = 0;
+    for (size_t r = 0; r < _byRank.size(); ++r) {
+        Input& i = *_byRank[r];
+        i._rank = static_cast<int>(r);
+        i._bit = 1u << r;
+        if (i._policy.blend == BlendMode::Normal && i._opacity == OPAQUE) _opaqueMask |= i._bit;
+    }
+    return *_inputs.back();
+}
+
+bool SourceManager::start() {
+    stop();
+    _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_wakeFd < 0) {
+        perror("[Sources] eventfd");
+        return false;
+    }
+    _stopping = false;
+    wake();                            // first pass picks up frames published before start()
+    _thread = std::thread(&SourceManager::loop, this);
+    pthread_setname_np(_thread.native_handle(), "amb-sources");
+    return true;
+}
+
+void SourceManager::stop() {
+    if (_thread.joinable()) {
+        _stopping = true;
+        wake();
+        _thread.join();
+    }
+    if (_wakeFd >= 0) close(_wakeFd);
+    _wakeFd = -1;
+}
+
+std::vector<SourceManager::SourceStats> SourceManager::stats() const {
+    const uint64_t now = monotonicNs();
+    const int winner = _winner.load(std::memory_order_relaxed);
+    std::vector<SourceStats> out;
+    for (const Input* in : _byRank) {
+        SourceStats s;
+        s.name = in->_name;
+        s.policy = in->_policy;
+        s.submitted = in->_submitted.load(std::memory_order_relaxed);
+        s.shown = in->_shown.load(std::memory_order_relaxed);
+        s.superseded = in->_superseded.load(std::memory_order_relaxed);
+        s.expired = in->_expired.load(std::memory_order_relaxed);
+        s.live = (_live.load(std::memory_order_relaxed) & in->_bit) && !stale(*in, now);
+        s.active = in->_rank == winner;
+        out.push_back(s);
+    }
+    return out;
+}
+
+// -----------------------------
+// Auswahl (Manager-Thread)
+// -----------------------------
+bool SourceManager::stale(const Input& in, uint64_t now) const {
+    const uint64_t last = in._lastNs.load(std::memory_order_relaxed);
+    return in._timeoutNs != 0 && now > last && now - last > in._timeoutNs;
+}
+
+// lowest live opaque bit = base layer; expired inputs on the way (base and
+// overlays above it) are cleared, each once
+int SourceManager::select(uint64_t now) {
+    uint32_t mask = _live.load(std::memory_order_acquire);
+    while (mask) {
+        const int r = __builtin_ctz(mask);
+        Input& in = *_byRank[r];
+        if (!stale(in, now)) {
+            if (in._bit & _opaqueMask) return r;
+            mask &= ~in._bit;          // live overlay
+            continue;
+        }
+        _live.fetch_and(~in._bit, std::memory_order_acq_rel);
+        // a frame that raced with the expiry keeps the input alive
+        if (!stale(in, now)) {
+            _live.fetch_or(in._bit, std::memory_order_release);
+            continue;
+        }
+        in._expired.fetch_add(1, std::memory_order_relaxed);
+        std::cout << "[Sources] " << in._name << " expired" << std::endl;
+        mask &= ~in._bit;
+    }
+    return NONE;
+}
+
+// sleep until the next fade step, or until a visible input would expire
+int SourceManager::nextTimeoutMs(bool fading) const {
+    if (fading) return FADE_TICK_MS;
+    const uint64_t now = monotonicNs();
+    uint64_t next = UINT64_MAX;
+    for (const Input* in : _byRank) {
+        if (!in->_level.visible() || !in->_timeoutNs) continue;
+        next = std::min(next, in->_lastNs.load(std::memory_order_relaxed) + in->_timeoutNs);
+    }
+    if (next == UINT64_MAX) return -1;
+    return next > now ? int((next - now) / 1000000) + 1 : 0;
+}
+
+void SourceManager::loop() {
+    int base = NONE;
+    bool fading = false;
+    uint64_t lastTick = monotonicNs();
+    pollfd pfd = { _wakeFd, POLLIN, 0 };
+    for (;;) {
+        if (poll(&pfd, 1, nextTimeoutMs(fading)) < 0 && errno != EINTR) {
+            perror("[Sources] poll");
+            return;
+        }
+        uint64_t count;
+        if (read(_wakeFd, &count, sizeof(count)) < 0 && errno != EAGAIN) perror("[Sources] read");
+        if (_stopping) return;
+
+        const uint64_t now = monotonicNs();
+        const uint64_t elapsed = fading ? now - lastTick : 0;   // a new fade starts now
+        lastTick = now;
+        const int r = select(now);
+        _winner.store(r, std::memory_order_relaxed);
+        if (r != base) {
+            if (r == NONE) std::cout << "[Sources] no opaque source, holding the last frame" << std::endl;
+            else std::cout << "[Sources] active: " << _byRank[r]->_name << std::endl;
+            base = r;
+        }
+
+        // wanted: the base and the live overlays above it; everything else
+        // fades out, except opaque inputs below the base: they stay
+        // underneath until the base is fully in (no base: hold them).
+        // Newest frames are taken for every visible layer.
+        const uint32_t live = _live.load(std::memory_order_acquire);
+        const Input* top = base == NONE ? nullptr : _byRank[base];
+        bool changed = fading;
+        fading = false;
+        for (Input* in : _byRank) {     // rank order: the base before the inputs below it
+            const bool want = (live & in->_bit) && in->_rank <= base && !stale(*in, now);
+            const bool wasVisible = in->_level.visible();
+            if (!want && (in->_bit & _opaqueMask) && in->_rank >= base) {
+                if (top && top->_level.full()) in->_level.snap(false);
+            } else if (in->_level.step(want, elapsed, _fadeNs)) {
+                fading = true;
+            }
+            if (in->_level.visible() != wasVisible) changed = true;
+            if (!in->_level.visible()) continue;
+            if (in->_middle.load(std::memory_order_acquire) & Input::FRESH) {
+                in->_front = in->_middle.exchange(in->_front, std::memory_order_acq_rel) & Input::INDEX;
+                in->_shown.fetch_add(1, std::memory_order_relaxed);
+                changed = true;
+            }
+        }
+        if (!changed) continue;
+
+        // bottom (lowest priority) to top; the bottom opaque layer is drawn
+        // fully, so a fading layer above it crossfades instead of dimming.
+        // A base with nothing below it has nothing to fade from.
+        _layers.clear();
+        for (auto it = _byRank.rbegin(); it != _byRank.rend(); ++it) {
+            Input& in = **it;
+            if (!in._level.visible()) continue;
+            Layer layer;
+            layer.colors = in._buffers[in._front].data();
+            layer.mode = in._policy.blend;
+            if (_layers.empty() && (in._bit & _opaqueMask)) {
+                if (&in == top) in._level.snap(true);
+                layer.alpha = OPAQUE;
+            } else {
+                layer.alpha = (in._level.alpha() * in._opacity + 128) >> 8;
+            }
+            _layers.push_back(layer);
+        }
+        if (_layers.empty()) continue;
+        _target.submitFrame(_compositor.compose(_layers.data(), _layers.size()));
+    }
+}
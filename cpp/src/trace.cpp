@@ -0,0 +1,219 @@
+// cpp/src/trace.cpp
+#include "trace.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static constexpr size_t HEADER_BYTES = sizeof(TRACE_MAGIC) + 8;
+static constexpr size_t RECORD_HEADER_BYTES = 16;
+static constexpr size_t MERGE_GAP = 3;   // a new run costs >= 2 varint bytes
+
+// -----------------------------
+// Hilfsfunktionen
+// -----------------------------
+static inline void putU32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static inline void putU64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static inline uint32_t getU32(const uint8_t* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    return v;
+}
+
+static inline uint64_t getU64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+static inline void putVarint(std::vector<uint8_t>& out, size_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+// false on overrun
+static inline bool getVarint(const uint8_t*& p, const uint8_t* end, size_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        const uint8_t b = *p++;
+        v |= static_cast<size_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static bool writeAll(int fd, const uint8_t* data, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(fd, data, n);
+        if (w < 0) return false;
+        data += w;
+        n -= static_cast<size_t>(w);
+    }
+    return true;
+}
+
+// -----------------------------
+// TraceWriter
+// -----------------------------
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const std::string& path, size_t frameBytes, bool exclusive) {
+    close();
+    const int mode = exclusive ? O_EXCL | O_NOFOLLOW : O_TRUNC;
+    _fd = ::open(path.c_str(), O_WRONLY | O_CREAT | mode | O_APPEND | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+        perror(("open trace " + path).c_str());
+        return false;
+    }
+    uint8_t header[HEADER_BYTES];
+    std::memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    putU32(header + 8, TRACE_VERSION);
+    putU32(header + 12, static_cast<uint32_t>(frameBytes));
+    if (!writeAll(_fd, header, sizeof(header))) {
+        perror("write trace header");
+        close();
+        return false;
+    }
+    _path = path;
+    _prev.assign(frameBytes, 0);
+    _record.clear();
+    _record.reserve(RECORD_HEADER_BYTES + frameBytes + frameBytes / 2);
+    _stats = TraceStats{};
+    _stats.fileBytes = sizeof(header);
+    return true;
+}
+
+void TraceWriter::close() {
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
+
+void TraceWriter::append(const uint8_t* frame, uint64_t timestampNs) {
+    if (_fd < 0) return;
+    const size_t n = _prev.size();
+
+    _record.resize(RECORD_HEADER_BYTES);
+    uint32_t runs = 0;
+    uint64_t changed = 0;
+    size_t pos = 0;                  // end of the previous run
+    size_t i = 0;
+    while (i < n) {
+        if (frame[i] == _prev[i]) {
+            ++i;
+            continue;
+        }
+        // run: changed bytes, absorbing unchanged gaps shorter than MERGE_GAP
+        size_t end = i + 1;
+        size_t last = i;             // last changed byte
+        while (end < n && end - last <= MERGE_GAP) {
+            if (frame[end] != _prev[end]) last = end;
+            ++end;
+        }
+        end = last + 1;
+        putVarint(_record, i - pos);
+        putVarint(_record, end - i);
+        _record.insert(_record.end(), frame + i, frame + end);
+        for (size_t k = i; k < end; ++k) changed += frame[k] != _prev[k];
+        ++runs;
+        pos = end;
+        i = end;
+    }
+    std::memcpy(_prev.data(), frame, n);
+
+    putU32(_record.data(), static_cast<uint32_t>(_record.size() - RECORD_HEADER_BYTES));
+    putU32(_record.data() + 4, runs);
+    putU64(_record.data() + 8, timestampNs);
+    if (!writeAll(_fd, _record.data(), _record.size())) {
+        perror("write trace");
+        close();
+        return;
+    }
+    ++_stats.frames;
+    _stats.changedBytes += changed;
+    _stats.fileBytes += _record.size();
+}
+
+// -----------------------------
+// TraceReader
+// -----------------------------
+TraceReader::~TraceReader() {
+    if (_map) munmap(const_cast<uint8_t*>(_map), _size);
+}
+
+bool TraceReader::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror(("open trace " + path).c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < HEADER_BYTES) {
+        std::cerr << "[Trace] " << path << ": not a trace file\n";
+        ::close(fd);
+        return false;
+    }
+    _size = static_cast<size_t>(st.st_size);
+    void* map = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap trace");
+        return false;
+    }
+    _map = static_cast<const uint8_t*>(map);
+    madvise(map, _size, MADV_SEQUENTIAL);
+
+    if (std::memcmp(_map, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || getU32(_map + 8) != TRACE_VERSION) {
+        std::cerr << "[Trace] " << path << ": bad magic or version\n";
+        return false;
+    }
+    _frame.assign(getU32(_map + 12), 0);
+    _pos = HEADER_BYTES;
+    return true;
+}
+
+bool TraceReader::next() {
+    if (!_map || _pos + RECORD_HEADER_BYTES > _size) return false;
+    const uint8_t* rec = _map + _pos;
+    const uint32_t payload = getU32(rec);
+    const uint32_t runs = getU32(rec + 4);
+    if (_pos + RECORD_HEADER_BYTES + payload > _size) return false;   // truncated tail
+
+    const uint8_t* p = rec + RECORD_HEADER_BYTES;
+    const uint8_t* end = p + payload;
+    size_t pos = 0;
+    uint32_t changed = 0;
+    for (uint32_t r = 0; r < runs; ++r) {
+        size_t skip, len;
+        if (!getVarint(p, end, skip) || !getVarint(p, end, len)) return false;
+        // subtraction form: a corrupt varint near SIZE_MAX must not wrap pos
+        if (skip > _frame.size() - pos) return false;
+        pos += skip;
+        if (len > _frame.size() - pos || len > static_cast<size_t>(end - p)) return false;
+        for (size_t k = 0; k < len; ++k) changed += _frame[pos + k] != p[k];
+        std::memcpy(_frame.data() + pos, p, len);
+        p += len;
+        pos += len;
+    }
+    _timestampNs = getU64(rec + 8);
+    _changed = changed;
+    _pos += RECORD_HEADER_BYTES + payload;
+    return true;
+}
@@ -0,0 +1,109 @@
+// cpp/src/worker_pool.cpp
+#include "worker_pool.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32-bit word");
+
+static constexpr int SPIN_ITERATIONS = 4000;
+
+// -----------------------------
+// Hilfsfunktionen
+// -----------------------------
+static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+static inline void futexWait(std::atomic<uint32_t>& word, uint32_t expected) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+static inline void futexWake(std::atomic<uint32_t>& word, int count) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+static inline uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// -----------------------------
+// WorkerPool Implementation
+// -----------------------------
+WorkerPool::WorkerPool(int size)
+    : _size(std::max(1, size)),
+      _slots(_size)
+{
+    for (int i = 1; i < _size; ++i) {
+        _threads.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    _stop = true;
+    _epoch.fetch_add(1);
+    futexWake(_epoch, INT_MAX);
+    for (auto& t : _threads) t.join();
+}
+
+void WorkerPool::runImpl(void (*fn)(void*, int), void* ctx) {
+    _fn = fn;
+    _ctx = ctx;
+    _pending.store(static_cast<uint32_t>(_size - 1));
+
+    // publish: workers read _fn/_ctx after seeing the new epoch
+    _epoch.fetch_add(1);
+    if (_sleepers.load() > 0) futexWake(_epoch, INT_MAX);
+
+    const uint64_t t0 = nowNs();
+    fn(ctx, 0);
+    _slots[0].busyNs += nowNs() - t0;
+
+    int spins = 0;
+    uint32_t p;
+    while ((p = _pending.load()) != 0) {
+        if (++spins < SPIN_ITERATIONS) {
+            cpuRelax();
+            continue;
+        }
+        _callerWaiting.store(1);
+        if (_pending.load() == p) futexWait(_pending, p);
+        _callerWaiting.store(0);
+    }
+}
+
+void WorkerPool::workerLoop(int index) {
+    uint32_t seen = 0;                 // epoch at construction; a run may already be pending
+    for (;;) {
+        int spins = 0;
+        uint32_t e;
+        while ((e = _epoch.load()) == seen) {
+            if (++spins < SPIN_ITERATIONS) {
+                cpuRelax();
+                continue;
+            }
+            // seq_cst pairs with the producer's epoch bump + _sleepers check
+            _sleepers.fetch_add(1);
+            if (_epoch.load() == seen) futexWait(_epoch, seen);
+            _sleepers.fetch_sub(1);
+        }
+        seen = e;
+        if (_stop) return;
+
+        const uint64_t t0 = nowNs();
+        _fn(_ctx, index);
+        _slots[index].busyNs += nowNs() - t0;
+
+        if (_pending.fetch_sub(1) == 1 && _callerWaiting.load()) futexWake(_pending, 1);
+    }
+}
@@ -0,0 +1,342 @@
+// cpp/tests/test_ambient.cpp
+// AmbientProcessor building blocks: border detection hysteresis, WorkerPool
+// runs, threaded processFrame, downscale check, sample and dominant modes
+#include "ambient_processor.h"
+#include "border_detector.h"
+#include "downscale.h"
+#include "worker_pool.h"
+#include "test_util.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+static constexpr int W = 320, H = 180;
+
+// grey picture (content above the black threshold) with black bars
+static std::vector<uint8_t> barFrame(int bars, int pillars) {
+    std::vector<uint8_t> f(static_cast<size_t>(W) * H * 3, 0);
+    for (int y = bars; y < H - bars; ++y) {
+        for (int x = pillars; x < W - pillars; ++x) {
+            uint8_t* p = &f[(static_cast<size_t>(y) * W + x) * 3];
+            p[0] = 120;
+            p[1] = static_cast<uint8_t>(60 + x % 50);
+            p[2] = 90;
+        }
+    }
+    return f;
+}
+
+// feeds frame n times; returns the 1-based call that reported a change, 0 = none
+static int feed(BorderDetector& d, const std::vector<uint8_t>& frame, int n) {
+    int changedAt = 0;
+    for (int i = 1; i <= n; ++i) {
+        if (d.update(frame.data(), W, H) && !changedAt) changedAt = i;
+    }
+    return changedAt;
+}
+
+static void testBorderHysteresis() {
+    BorderDetector d;                            // 30 stable frames
+    const std::vector<uint8_t> full = barFrame(0, 0);
+    const std::vector<uint8_t> letterbox = barFrame(20, 0);
+    CHECK_EQ(feed(d, full, 5), 0);
+
+    // applied on exactly the 30th consecutive letterboxed frame
+    CHECK_EQ(feed(d, letterbox, 29), 0);
+    CHECK_EQ(d.crop().top, 0);
+    CHECK_EQ(feed(d, letterbox, 1), 1);
+    CHECK_EQ(d.crop().top, 20);
+    CHECK_EQ(d.crop().bottom, 20);
+    CHECK_EQ(d.crop().left, 0);
+
+    // jitter within the tolerance is the same crop
+    CHECK_EQ(feed(d, barFrame(21, 0), 60), 0);
+
+    // one frame of the old crop restarts the count
+    CHECK_EQ(feed(d, full, 15), 0);
+    CHECK_EQ(feed(d, letterbox, 1), 0);
+    CHECK_EQ(feed(d, full, 29), 0);
+    CHECK_EQ(d.crop().top, 20);
+    CHECK_EQ(feed(d, full, 1), 1);
+    CHECK_EQ(d.crop().top, 0);
+}
+
+// a dark scene says nothing about the bars: no change, no reset
+static void testBorderDarkFrames() {
+    BorderDetector d;
+    const std::vector<uint8_t> pillarbox = barFrame(0, 40);
+    const std::vector<uint8_t> black(static_cast<size_t>(W) * H * 3, 0);
+    CHECK_EQ(feed(d, pillarbox, 30), 30);
+    CHECK_EQ(d.crop().left, 40);
+    CHECK_EQ(d.crop().right, 40);
+    CHECK_EQ(feed(d, black, 100), 0);
+    CHECK_EQ(d.crop().left, 40);
+
+    // dark frames in the middle of a new candidate don't reset its count
+    CHECK_EQ(feed(d, barFrame(0, 0), 20), 0);
+    CHECK_EQ(feed(d, black, 50), 0);
+    CHECK_EQ(feed(d, barFrame(0, 0), 10), 10);
+    CHECK_EQ(d.crop().left, 0);
+}
+
+// subtitles in the bottom bar: the thinner bar decides
+static void testBorderSubtitles() {
+    BorderDetector d;
+    std::vector<uint8_t> f = barFrame(24, 0);
+    for (int x = 100; x < 220; ++x) {
+        uint8_t* p = &f[(static_cast<size_t>(H - 10) * W + x) * 3];
+        p[0] = p[1] = p[2] = 255;
+    }
+    CHECK_EQ(feed(d, f, 30), 30);
+    CHECK_EQ(d.crop().top, 9);
+    CHECK_EQ(d.crop().bottom, 9);
+}
+
+// the processor applies the crop and reports it
+static void testProcessorCropStats() {
+    AmbientProcessor p(60);
+    const std::vector<uint8_t> letterbox = barFrame(20, 0);
+    for (int i = 0; i < 30; ++i) p.processFrame(letterbox.data(), W, H);
+    const AmbientProcessor::Stats s = p.stats();
+    CHECK_EQ(s.frames, 30u);
+    CHECK_EQ(s.cropChanges, 1u);
+    CHECK_EQ(s.crop.top, 20);
+    CHECK(s.processNs >= s.borderNs);
+}
+
+// every participant runs exactly once per run(), and run() only returns
+// when all of them are done (the caller sees every write of the run)
+static void testWorkerPool() {
+    constexpr int RUNS = 2000;
+    for (int n = 1; n <= 4; ++n) {
+        WorkerPool pool(n);
+        CHECK_EQ(pool.size(), n);
+        std::vector<std::atomic<int>> calls(n);
+        std::vector<int> seen(n, 0);             // plain writes, read after run()
+        int bad = 0;
+        for (int r = 1; r <= RUNS; ++r) {
+            auto fn = [&](int i) {
+                calls[i].fetch_add(1, std::memory_order_relaxed);
+                seen[i] = r;
+            };
+            pool.run(fn);
+            for (int i = 0; i < n; ++i) {
+                if (calls[i].load(std::memory_order_relaxed) != r || seen[i] != r) ++bad;
+            }
+        }
+        CHECK_EQ(bad, 0);
+    }
+}
+
+// a frame with a different color per edge and some noise
+static std::vector<uint8_t> testFrame(int width, int height) {
+    std::vector<uint8_t> f(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* p = &f[(static_cast<size_t>(y) * width + x) * 3];
+            p[0] = static_cast<uint8_t>(x * 255 / width);
+            p[1] = static_cast<uint8_t>(y * 255 / height);
+            p[2] = static_cast<uint8_t>((x * 7 + y * 13) & 0xFF);
+        }
+    }
+    return f;
+}
+
+// the split over workers doesn't change the result, in every reduce mode
+static void testThreadedMatchesSingle() {
+    const int w = 320, h = 180, leds = 90;
+    const std::vector<uint8_t> frame = testFrame(w, h);
+    for (auto mode : { AmbientProcessor::ReduceMode::Mean, AmbientProcessor::ReduceMode::Sample,
+                       AmbientProcessor::ReduceMode::Dominant }) {
+        AmbientProcessor single(leds), threaded(leds);
+        for (AmbientProcessor* p : { &single, &threaded }) {
+            p->setReduceMode(mode);
+            p->setSmoothingTime(0.0f);
+            p->setBorderDetection(false);
+        }
+        threaded.setThreads(4);
+        const std::vector<RGB> a = single.processFrame(frame.data(), w, h);
+        const std::vector<RGB> b = threaded.processFrame(frame.data(), w, h);
+        int differ = 0;
+        for (int i = 0; i < leds; ++i) {
+            if (a[i].r != b[i].r || a[i].g != b[i].g || a[i].b != b[i].b) ++differ;
+        }
+        CHECK_EQ(differ, 0);
+        CHECK_EQ(threaded.stats().workerNs.size(), 4u);
+        CHECK(single.stats().workerNs.empty());
+    }
+}
+
+// frame with pixel(x, y, p) filling each pixel
+static std::vector<uint8_t> makeFrame(int width, int height, const std::function<void(int, int, uint8_t*)>& pixel) {
+    std::vector<uint8_t> f(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) pixel(x, y, &f[(static_cast<size_t>(y) * width + x) * 3]);
+    }
+    return f;
+}
+
+static constexpr AmbientProcessor::ReduceMode MEAN = AmbientProcessor::ReduceMode::Mean;
+
+// unsmoothed, no crop
+static void plain(AmbientProcessor& p, AmbientProcessor::ReduceMode mode, int downscale) {
+    p.setReduceMode(mode);
+    p.setDownscale(downscale);
+    p.setSmoothingTime(0.0f);
+    p.setBorderDetection(false);
+}
+
+static int maxDiff(const std::vector<RGB>& a, const std::vector<RGB>& b) {
+    int err = 0;
+    for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+        err = std::max({ err, std::abs(a[i].r - b[i].r), std::abs(a[i].g - b[i].g), std::abs(a[i].b - b[i].b) });
+    }
+    return a.size() == b.size() ? err : 256;
+}
+
+static void testDownscaleRows() {
+    uint8_t src[8 * 3], dst[2 * 3];
+    for (int i = 0; i < 8 * 3; ++i) src[i] = static_cast<uint8_t>(i * 10);
+    boxFilterRow(src, dst, 2, 4);
+    CHECK_EQ(dst[0], 45);                        // (0 + 30 + 60 + 90) / 4
+    CHECK_EQ(dst[3], 165);
+    CHECK_EQ(dst[5], 185);
+    pointSampleRow(src, dst, 2, 4);
+    CHECK_EQ(dst[0], 60);                        // pixel 2
+    CHECK_EQ(dst[4], 190);                       // pixel 6, green
+}
+
+// smooth content: the auto factor stays within the error bound; thin
+// stripes on the sampled rows break it, so the factor steps down at each
+// check until full resolution, and failed frames use the full-res result
+static void testDownscaleCheck() {
+    const int w = 640, h = 360, leds = 10;
+    const std::vector<uint8_t> smooth = makeFrame(w, h, [](int x, int y, uint8_t* p) {
+        p[0] = static_cast<uint8_t>(x * 255 / w);
+        p[1] = static_cast<uint8_t>(y * 255 / h);
+        p[2] = 80;
+    });
+    AmbientProcessor scaled(leds), full(leds);
+    plain(scaled, MEAN, 0);
+    plain(full, MEAN, 1);
+    const std::vector<RGB> a = scaled.processFrame(smooth.data(), w, h);
+    const std::vector<RGB> b = full.processFrame(smooth.data(), w, h);
+    CHECK_EQ(scaled.stats().downscale, 8);
+    CHECK_EQ(full.stats().downscale, 1);
+    CHECK(scaled.stats().downscaleError <= 6);
+    CHECK_EQ(maxDiff(a, b), scaled.stats().downscaleError);
+
+    const std::vector<uint8_t> stripes = makeFrame(w, h, [](int, int y, uint8_t* p) {
+        p[0] = p[1] = p[2] = y % 8 == 4 ? 255 : 0;
+    });
+    AmbientProcessor p(leds), reference(leds);
+    plain(p, MEAN, 0);
+    plain(reference, MEAN, 1);
+    const std::vector<RGB> expected = reference.processFrame(stripes.data(), w, h);
+    CHECK_EQ(maxDiff(p.processFrame(stripes.data(), w, h), expected), 0);
+    CHECK_EQ(p.stats().downscale, 8);
+    for (int i = 1; i <= 240; ++i) p.processFrame(stripes.data(), w, h);
+    CHECK_EQ(p.stats().downscale, 2);
+    CHECK_EQ(p.stats().downscaleChecks, 3u);
+    CHECK_EQ(maxDiff(p.processFrame(stripes.data(), w, h), expected), 0);
+    CHECK_EQ(p.stats().downscale, 1);
+}
+
+// the grid reads its sample points only: exact on flat regions, close to
+// the mean on smooth content, blind to detail between the points
+static void testSampleMode() {
+    const int leds = 48;
+    const std::vector<uint8_t> smooth = makeFrame(W, H, [](int x, int y, uint8_t* p) {
+        p[0] = static_cast<uint8_t>(x * 255 / W);
+        p[1] = static_cast<uint8_t>(255 - y * 255 / H);
+        p[2] = static_cast<uint8_t>((x + y) * 255 / (W + H));
+    });
+    AmbientProcessor sample(leds), mean(leds);
+    plain(sample, AmbientProcessor::ReduceMode::Sample, 0);
+    plain(mean, MEAN, 1);
+    CHECK(maxDiff(sample.processFrame(smooth.data(), W, H), mean.processFrame(smooth.data(), W, H)) <= 4);
+    CHECK_EQ(sample.stats().downscale, 1);
+
+    // odd pixels bright: a 4x4 grid over even-sized regions lands on even ones
+    const std::vector<uint8_t> grid = makeFrame(W, H, [](int x, int y, uint8_t* p) {
+        p[0] = p[1] = p[2] = (x % 2 && y % 2) ? 255 : 10;
+    });
+    AmbientProcessor p1(4);
+    plain(p1, AmbientProcessor::ReduceMode::Sample, 0);
+    p1.setSampleGrid(2, 2);
+    const std::vector<RGB> out = p1.processFrame(grid.data(), W, H);
+    int bright = 0;
+    for (const RGB& c : out) bright += c.r > 10;
+    CHECK_EQ(bright, 0);
+}
+
+// a queued mode/grid change arrives with its region map built by the
+// queueing thread: same colors as the setters, no rebuild in processFrame
+static void testQueuedSettings() {
+    const int leds = 48;
+    const std::vector<uint8_t> frame = testFrame(W, H);
+    AmbientProcessor queued(leds), direct(leds);
+    plain(queued, MEAN, 1);
+    plain(direct, MEAN, 1);
+    queued.processFrame(frame.data(), W, H);
+    direct.processFrame(frame.data(), W, H);
+    CHECK_EQ(queued.stats().mapBuilds, 1u);
+
+    AmbientProcessor::Settings s;
+    s.smoothingMs = 0.0f;
+    s.borderDetection = false;
+    s.downscale = 1;
+    s.mode = AmbientProcessor::ReduceMode::Sample;
+    s.samplesX = 3;
+    s.samplesY = 2;
+    queued.queueSettings(s);
+    direct.setReduceMode(AmbientProcessor::ReduceMode::Sample);
+    direct.setSampleGrid(3, 2);
+    CHECK_EQ(maxDiff(queued.processFrame(frame.data(), W, H), direct.processFrame(frame.data(), W, H)), 0);
+    CHECK_EQ(queued.stats().mapBuilds, 1u);
+    CHECK_EQ(direct.stats().mapBuilds, 2u);
+}
+
+// 70 % red, 30 % blue scattered: the mean is purple, the dominant color is
+// the red itself, also when downscaled (point samples, no blending)
+static void testDominantMode() {
+    const int w = 640, h = 360, leds = 32;
+    const std::vector<uint8_t> mix = makeFrame(w, h, [](int x, int y, uint8_t* p) {
+        uint32_t k = static_cast<uint32_t>(y * w + x) * 2654435761u;
+        k ^= k >> 16;
+        const bool red = k % 10 < 7;
+        p[0] = red ? 250 : 10;
+        p[1] = 10;
+        p[2] = red ? 10 : 250;
+    });
+    for (int downscale : { 1, 4 }) {
+        AmbientProcessor p(leds);
+        plain(p, AmbientProcessor::ReduceMode::Dominant, downscale);
+        const std::vector<RGB> out = p.processFrame(mix.data(), w, h);
+        CHECK_EQ(p.stats().downscale, downscale);
+        int wrong = 0;
+        for (const RGB& c : out) wrong += !(c.r == 250 && c.g == 10 && c.b == 10);
+        CHECK_EQ(wrong, 0);
+    }
+    AmbientProcessor mean(leds);
+    plain(mean, MEAN, 1);
+    const RGB c = mean.processFrame(mix.data(), w, h)[0];
+    CHECK(c.r > 150 && c.r < 220 && c.b > 40);
+}
+
+int main() {
+    testBorderHysteresis();
+    testBorderDarkFrames();
+    testBorderSubtitles();
+    testProcessorCropStats();
+    testWorkerPool();
+    testThreadedMatchesSingle();
+    testDownscaleRows();
+    testDownscaleCheck();
+    testSampleMode();
+    testDominantMode();
+    testQueuedSettings();
+    return testResult("test_ambient");
+}
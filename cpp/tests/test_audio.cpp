@@ -0,0 +1,258 @@
+// cpp/tests/test_audio.cpp
+// RealFft against a direct DFT, AudioReactive bands / beats / silence with a
+// generated source, WavSource parsing, downmix and end of data
+#include "audio_reactive.h"
+#include "audio_source.h"
+#include "fft.h"
+#include "test_util.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr int RATE = 48000;
+
+// sample(i) for i < length, then end of stream; as fast as it is read
+class GeneratedSource : public AudioSource
+{
+public:
+    GeneratedSource(std::function<float(size_t)> sample, size_t length)
+        : _sample(std::move(sample)), _length(length) {}
+
+    bool read(float* samples, size_t count, uint64_t& captureNs) override {
+        if (_pos + count > _length) {
+            _done = true;
+            return false;
+        }
+        for (size_t k = 0; k < count; ++k) samples[k] = _sample(_pos++);
+        captureNs = 0;
+        return true;
+    }
+    int sampleRate() const override { return RATE; }
+
+    bool done() const { return _done; }
+
+private:
+    std::function<float(size_t)> _sample;
+    size_t _length;
+    size_t _pos = 0;
+    std::atomic<bool> _done{false};
+};
+
+// runs the analyzer over the whole generated stream
+static AudioReactive::Stats play(CaptureTarget& target, std::function<float(size_t)> sample, double seconds) {
+    auto source = std::make_unique<GeneratedSource>(std::move(sample), static_cast<size_t>(seconds * RATE));
+    const GeneratedSource* src = source.get();
+    AudioReactive audio(target, std::move(source), AudioReactive::Settings{});
+    audio.start();
+    for (int i = 0; i < 500 && !src->done(); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK(src->done());
+    audio.stop();
+    return audio.stats();
+}
+
+// deterministic white noise, -1..1
+static float noise(size_t i) {
+    uint32_t x = static_cast<uint32_t>(i) * 2654435761u;
+    x ^= x >> 15;
+    x *= 2246822519u;
+    x ^= x >> 13;
+    return static_cast<float>(x) / 2147483648.0f - 1.0f;
+}
+
+static void testFft() {
+    for (int n : { 16, 64, 1024 }) {
+        std::vector<float> in(n), out(n / 2 + 1);
+        for (int i = 0; i < n; ++i) in[i] = noise(i * 7 + n);
+        RealFft fft(n);
+        CHECK_EQ(fft.bins(), n / 2 + 1);
+        fft.power(in.data(), out.data());
+
+        double worst = 0.0, total = 0.0;
+        for (int k = 0; k <= n / 2; ++k) {
+            double re = 0.0, im = 0.0;
+            for (int i = 0; i < n; ++i) {
+                re += in[i] * std::cos(2.0 * M_PI * k * i / n);
+                im -= in[i] * std::sin(2.0 * M_PI * k * i / n);
+            }
+            worst = std::max(worst, std::fabs(out[k] - (re * re + im * im)));
+            total += re * re + im * im;
+        }
+        CHECK(worst <= 1e-4 * total);
+    }
+
+    bool threw = false;
+    try {
+        RealFft bad(24);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+// a steady 1 kHz tone lights the LEDs of its band, without beats
+static void testToneBand() {
+    const int leds = 64;
+    CaptureTarget target(leds);
+    const AudioReactive::Stats s =
+        play(target, [](size_t i) { return 0.5f * std::sin(2.0f * static_cast<float>(M_PI) * 1000.0f * i / RATE); }, 1.0);
+    CHECK(s.blocks > 80);
+    CHECK_EQ(s.beats, 0u);
+    CHECK_NEAR(s.levelDb, -9.0, 0.5);       // RMS of a 0.5 sine
+    CHECK_EQ(target.releases(), 1);         // end of stream
+
+    // r + g + b is 255 * level on every LED, so the brightest LED is the band's
+    const std::vector<RGB> f = target.last();
+    if (static_cast<int>(f.size()) != leds) return;
+    int brightest = 0;
+    for (int i = 1; i < leds; ++i) {
+        if (f[i].r + f[i].g + f[i].b > f[brightest].r + f[brightest].g + f[brightest].b) brightest = i;
+    }
+    const float band = std::log(1000.0f / 40.0f) / std::log(16000.0f / 40.0f) * AudioReactive::DEFAULT_BANDS;
+    const float pos = (brightest + 0.5f) / leds * AudioReactive::DEFAULT_BANDS - 0.5f;
+    CHECK_NEAR(pos, std::floor(band), 1.0);
+    CHECK(f[0].r + f[0].g + f[0].b < 32);               // 40 Hz stays dark
+    CHECK(f[leds - 1].r + f[leds - 1].g + f[leds - 1].b < 32);
+}
+
+// noise bursts every half second over a quiet floor are beats, once the
+// detector has half a second of history
+static void testBeats() {
+    CaptureTarget target(16);
+    const size_t period = RATE / 2, burst = RATE / 20;
+    const AudioReactive::Stats s =
+        play(target, [=](size_t i) { return noise(i) * (i % period < burst ? 0.5f : 0.002f); }, 4.0);
+    CHECK(s.beats >= 6 && s.beats <= 8);
+}
+
+// two seconds of silence release the target, sound takes it back
+static void testSilence() {
+    CaptureTarget target(16);
+    const size_t quiet = 3 * RATE;
+    const AudioReactive::Stats s = play(
+        target, [=](size_t i) { return i >= RATE && i < RATE + quiet ? 0.0f : 0.3f * noise(i); }, 5.0);
+    CHECK(s.active == false);
+    CHECK_EQ(target.releases(), 2);           // silence, then end of stream
+    CHECK(s.frames < s.blocks);
+    CHECK(s.frames > s.blocks / 2);
+}
+
+// RIFF/WAVE with the given format tag, bits and raw data
+static std::string writeWav(uint16_t tag, uint16_t channels, uint16_t bits, const std::string& data) {
+    auto le16 = [](uint16_t v) { return std::string{ char(v & 0xFF), char(v >> 8) }; };
+    auto le32 = [&](uint32_t v) { return le16(uint16_t(v & 0xFFFF)) + le16(uint16_t(v >> 16)); };
+    const uint32_t rate = 8000;
+    std::string wav = "RIFF" + le32(uint32_t(4 + 8 + 16 + 8 + 8 + data.size())) + "WAVE";
+    wav += "LIST" + le32(4) + "INFO";                                  // skipped
+    wav += "fmt " + le32(16) + le16(tag) + le16(channels) + le32(rate) +
+           le32(rate * channels * bits / 8) + le16(uint16_t(channels * bits / 8)) + le16(bits);
+    wav += "data" + le32(uint32_t(data.size())) + data;
+
+    char name[] = "/tmp/test_audio_XXXXXX";
+    const int fd = mkstemp(name);
+    if (fd >= 0) close(fd);
+    std::ofstream(name, std::ios::binary) << wav;
+    return name;
+}
+
+static void testWav() {
+    // stereo 16 bit: (16384, 0) and (-32768, -32768)
+    std::string pcm;
+    for (int k = 0; k < 100; ++k) pcm += std::string("\x00\x40\x00\x00\x00\x80\x00\x80", 8);
+    std::string path = writeWav(1, 2, 16, pcm);
+    {
+        WavSource wav(path, false);
+        CHECK_EQ(wav.sampleRate(), 8000);
+        float s[200];
+        uint64_t captureNs = 0;
+        CHECK(wav.read(s, 200, captureNs));
+        CHECK_EQ(s[0], 0.25f);
+        CHECK_EQ(s[1], -1.0f);
+        CHECK_EQ(s[199], -1.0f);
+        CHECK(!wav.read(s, 1, captureNs));        // no loop: end of data
+    }
+    {
+        WavSource wav(path, true);                // loops past the end
+        float s[300];
+        uint64_t captureNs = 0;
+        CHECK(wav.read(s, 300, captureNs));
+        CHECK_EQ(s[200], 0.25f);
+    }
+    unlink(path.c_str());
+
+    // mono float
+    float f[3] = { 0.5f, -0.25f, 1.0f };
+    path = writeWav(3, 1, 32, std::string(reinterpret_cast<const char*>(f), sizeof(f)));
+    {
+        WavSource wav(path, false);
+        float s[3];
+        uint64_t captureNs = 0;
+        CHECK(wav.read(s, 3, captureNs));
+        CHECK(std::memcmp(s, f, sizeof(f)) == 0);
+    }
+    unlink(path.c_str());
+
+    // 8 bit, and data shorter than one frame, are refused
+    for (const std::string& p : { writeWav(1, 1, 8, "abcd"), writeWav(1, 2, 16, "ab") }) {
+        bool threw = false;
+        try {
+            WavSource wav(p, true);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        CHECK(threw);
+        unlink(p.c_str());
+    }
+}
+
+// "-" reads a WAV stream from stdin without changing its file flags, which
+// it shares with the parent's tty or pipe
+static void testWavStdin() {
+    const std::string path = writeWav(1, 1, 16, std::string("\x00\x40\x00\xC0", 4));
+    std::ifstream in(path, std::ios::binary);
+    const std::string wav((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    unlink(path.c_str());
+
+    int fds[2];
+    if (pipe(fds) != 0) return;
+    const int savedStdin = dup(STDIN_FILENO);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+    const int flags = fcntl(STDIN_FILENO, F_GETFL);
+    CHECK_EQ(write(fds[1], wav.data(), wav.size()), static_cast<ssize_t>(wav.size()));
+    close(fds[1]);
+    {
+        WavSource source("-", false);
+        float s[2];
+        uint64_t captureNs = 0;
+        CHECK(source.read(s, 2, captureNs));
+        CHECK_EQ(s[0], 0.5f);
+        CHECK_EQ(s[1], -0.5f);
+        CHECK(!source.read(s, 1, captureNs));     // writer closed
+    }
+    CHECK_EQ(fcntl(STDIN_FILENO, F_GETFL), flags);
+    dup2(savedStdin, STDIN_FILENO);
+    close(savedStdin);
+}
+
+int main() {
+    testFft();
+    testToneBand();
+    testBeats();
+    testSilence();
+    testWav();
+    testWavStdin();
+    return testResult("test_audio");
+}
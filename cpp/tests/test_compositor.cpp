@@ -0,0 +1,112 @@
+// cpp/tests/test_compositor.cpp
+// Q8 blend modes against a float reference, compose(), FadeLevel timing
+#include "compositor.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// unrounded result of one channel, a = alpha / 256
+static double reference(BlendMode mode, int d, int s, double a) {
+    switch (mode) {
+    case BlendMode::Normal: return d + (s - d) * a;
+    case BlendMode::Add: return std::min(255.0, d + s * a);
+    case BlendMode::Max: return std::max<double>(d, s * a);
+    case BlendMode::Multiply: return d * (1.0 - a + s / 255.0 * a);
+    }
+    return 0.0;
+}
+
+// every dst x src pair per mode: within one step of the float result,
+// untouched at alpha 0, rounded exactly at OPAQUE
+static void testBlendModes() {
+    std::vector<uint8_t> src(256 * 256), dst(256 * 256);
+    for (int d = 0; d < 256; ++d) {
+        for (int s = 0; s < 256; ++s) {
+            dst[d * 256 + s] = static_cast<uint8_t>(d);
+            src[d * 256 + s] = static_cast<uint8_t>(s);
+        }
+    }
+    for (BlendMode mode : { BlendMode::Normal, BlendMode::Add, BlendMode::Max, BlendMode::Multiply }) {
+        for (uint32_t alpha : { 0u, 128u, OPAQUE }) {
+            std::vector<uint8_t> out = dst;
+            blendLayer(out.data(), src.data(), out.size(), mode, alpha);
+            double maxErr = 0.0;
+            int changed = 0, inexact = 0;
+            for (size_t i = 0; i < out.size(); ++i) {
+                const double ref = reference(mode, dst[i], src[i], alpha / 256.0);
+                maxErr = std::max(maxErr, std::fabs(out[i] - ref));
+                changed += out[i] != dst[i];
+                inexact += out[i] != std::lround(ref);
+            }
+            CHECK(maxErr <= 1.0);
+            if (alpha == 0) CHECK_EQ(changed, 0);
+            if (alpha == OPAQUE) CHECK_EQ(inexact, 0);
+        }
+    }
+
+    // alpha above OPAQUE is clamped
+    std::vector<uint8_t> out = dst;
+    blendLayer(out.data(), src.data(), out.size(), BlendMode::Normal, 1000);
+    CHECK(out == src);
+}
+
+// a translucent first layer goes over black, an opaque one replaces
+static void testCompose() {
+    Compositor c(2);
+    const std::vector<RGB> base = { RGB(200, 100, 50), RGB(0, 0, 0) };
+    const std::vector<RGB> top = { RGB(0, 0, 0), RGB(100, 100, 100) };
+    Layer layers[2];
+    layers[0].colors = base.data();
+    layers[0].alpha = 128;
+    c.compose(layers, 1);
+    CHECK_EQ(c.result()[0].r, 100);
+
+    layers[0].alpha = OPAQUE;
+    layers[1].colors = top.data();
+    layers[1].mode = BlendMode::Add;
+    layers[1].alpha = 128;
+    c.compose(layers, 2);
+    CHECK_EQ(c.result()[0].r, 200);
+    CHECK_EQ(c.result()[1].g, 50);
+}
+
+// steps of stepNs from 0; returns the elapsed time when FULL is reached
+static uint64_t fadeIn(uint64_t stepNs, uint64_t fadeNs) {
+    FadeLevel level;
+    uint64_t elapsed = 0;
+    while (!level.full() && elapsed < 2 * fadeNs) {
+        level.step(true, stepNs, fadeNs);
+        elapsed += stepNs;
+    }
+    return elapsed;
+}
+
+// FULL at fadeNs, within one step, whatever the step size
+static void testFadeLevel() {
+    const uint64_t fadeNs = 200000000;               // 200 ms
+    for (uint64_t stepNs : { 1000000ull, 3000000ull, 7000000ull, 16666667ull, 33333333ull, 250000000ull }) {
+        const uint64_t reached = fadeIn(stepNs, fadeNs);
+        CHECK(reached >= std::min(stepNs, fadeNs));
+        CHECK(reached < fadeNs + stepNs);
+    }
+
+    // halfway at half the time, and back out in the same time
+    FadeLevel level;
+    for (int i = 0; i < 100; ++i) level.step(true, 1000000, fadeNs);
+    CHECK_NEAR(level.alpha(), 128, 1);
+    for (int i = 0; i < 100; ++i) level.step(false, 1000000, fadeNs);
+    CHECK(!level.visible());
+
+    // no fade time: immediate
+    CHECK(!level.step(true, 0, 0));
+    CHECK(level.full());
+}
+
+int main() {
+    testBlendModes();
+    testCompose();
+    testFadeLevel();
+    return testResult("test_compositor");
+}
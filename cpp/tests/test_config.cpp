@@ -0,0 +1,135 @@
+// cpp/tests/test_config.cpp
+// loadConfig: defaults, values, conversions and error reporting
+#include "config.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+// writes text to a temporary file, removed again in the destructor
+class TempFile
+{
+public:
+    explicit TempFile(const std::string& text) {
+        char name[] = "/tmp/test_config_XXXXXX";
+        const int fd = mkstemp(name);
+        if (fd >= 0) close(fd);
+        _path = name;
+        std::ofstream(_path) << text;
+    }
+    ~TempFile() { unlink(_path.c_str()); }
+    const std::string& path() const { return _path; }
+
+private:
+    std::string _path;
+};
+
+static bool load(const std::string& text, Config& c, std::string& error) {
+    TempFile f(text);
+    const bool ok = loadConfig(f.path(), c, error);
+    // "path:line: message" -> ":line: message", the path is random
+    if (!ok && error.compare(0, f.path().size(), f.path()) == 0) error.erase(0, f.path().size());
+    return ok;
+}
+
+static void testDefaults() {
+    Config c;
+    std::string error;
+    CHECK(load("# nothing but a comment\n\n", c, error));
+    const Config d;
+    CHECK_EQ(c.ledCount, d.ledCount);
+    CHECK_EQ(c.device, d.device);
+    CHECK_EQ(c.port, d.port);
+    CHECK_EQ(c.output.segments.size(), 1u);       // one segment over the strip
+    CHECK_EQ(c.output.segments[0].count, d.ledCount);
+}
+
+static void testValues() {
+    Config c;
+    std::string error;
+    const bool ok = load("[led]\n"
+                         "count = 100   # trailing comment\n"
+                         "device = /tmp/spi.bin\n"
+                         "[OUTPUT]\n"
+                         "Gamma = 1.8\n"
+                         "order = GRB\n"
+                         "segments = 0:40 40:60:BGR:R\n"
+                         "calibration = WB 1 0.9 0.8\n"
+                         "smoothing = 0.25\n"
+                         "dither = on\n"
+                         "[ambient]\n"
+                         "smoothing = 3\n"
+                         "smoothing_fast_ms = 4\n"
+                         "mode = dominant\n"
+                         "[capture]\n"
+                         "delay = 120\n"
+                         "[sources]\n"
+                         "ipc = 300 1000 add 0.5\n"
+                         "[opc]\n"
+                         "channels = 1:0:50 2:50:50\n"
+                         "[trace]\n"
+                         "dir = /var/tmp\n"
+                         "[bogus]\n"
+                         "key = ignored\n",
+                         c, error);
+    CHECK(ok);
+    if (!ok) {
+        std::cerr << error << "\n";
+        return;
+    }
+    CHECK_EQ(c.ledCount, 100);
+    CHECK_EQ(c.device, "/tmp/spi.bin");
+    CHECK_NEAR(c.output.gamma, 1.8, 1e-6);
+    CHECK_EQ(c.output.segments.size(), 2u);
+    CHECK(c.output.segments[0].order == ColorOrder::GRB);
+    CHECK(c.output.segments[1].order == ColorOrder::BGR);
+    CHECK(c.output.segments[1].reversed);
+    CHECK_NEAR(c.output.calibration.matrix[4], 0.9, 1e-6);
+    CHECK_NEAR(c.smoothingMs, 57.9, 0.1);          // alpha 0.25 at 60 Hz
+    CHECK(c.dithering);
+    CHECK_NEAR(c.ambient.smoothingMs, 16.7, 0.1);  // 3 frames at 60 Hz
+    CHECK_NEAR(c.ambient.smoothingFastMs, 4.0, 1e-6);
+    CHECK(c.ambient.mode == AmbientProcessor::ReduceMode::Dominant);
+    CHECK_EQ(c.captureDelayMs, 120);
+    CHECK_EQ(c.ipcSource.priority, 300);
+    CHECK_EQ(c.ipcSource.timeoutMs, 1000);
+    CHECK(c.ipcSource.blend == BlendMode::Add);
+    CHECK_NEAR(c.ipcSource.opacity, 0.5, 1e-6);
+    CHECK_EQ(c.opcChannels.size(), 2u);
+    CHECK_EQ(c.traceDir, "/var/tmp");
+
+    // the old frame-count key still works, converted at 60 Hz
+    CHECK(load("[ambient]\nsmoothing_fast = 2\n", c, error));
+    CHECK_NEAR(c.ambient.smoothingFastMs, 8.3, 0.1);
+}
+
+static void testErrors() {
+    Config c;
+    c.ledCount = 7;                                // untouched on error
+    std::string error;
+
+    CHECK(!load("[led]\ncount = 0\n", c, error));
+    CHECK_EQ(error, ":2: bad value '0' for led.count");
+    CHECK(!load("[led\n", c, error));
+    CHECK_EQ(error, ":1: bad section header");
+    CHECK(!load("[led]\ncount\n", c, error));
+    CHECK_EQ(error, ":2: expected key = value");
+    CHECK(!load("[output]\ngamma = 2.2x\n", c, error));
+    CHECK(!load("[sources]\nipc = 300\n", c, error));
+    CHECK(!load("[ambient]\nsmoothing_fast = 0\n", c, error));
+    CHECK(!load("[led]\ncount = 10\n[output]\nsegments = 0:5 6:4\n", c, error));   // gap
+    CHECK_EQ(c.ledCount, 7);
+
+    CHECK(!loadConfig("/nonexistent/ambilight.conf", c, error));
+    CHECK_EQ(error, "/nonexistent/ambilight.conf: cannot open");
+}
+
+int main() {
+    testDefaults();
+    testValues();
+    testErrors();
+    return testResult("test_config");
+}
@@ -0,0 +1,214 @@
+// cpp/tests/test_effects.cpp
+// parseEffect, EffectEngine rendering at speed 0, timer rates, release on off;
+// expression compiler errors and limits, VM lanes against a scalar reference
+#include "effect_engine.h"
+#include "expression.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+static bool sameColor(const RGB& a, const RGB& b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+static void testParse() {
+    EffectParams p;
+    std::string error;
+    CHECK(parseEffect("fire", p, error));
+    CHECK(p.type == EffectType::Fire);
+    CHECK(p.palette == Palette::Heat);
+
+    CHECK(parseEffect("Chase speed=0 size=3 color=#00ff00 color2=000010", p, error));
+    CHECK(p.type == EffectType::Chase);
+    CHECK_EQ(p.speed, 0.0f);
+    CHECK_EQ(p.size, 3);
+    CHECK(sameColor(p.color, RGB(0, 255, 0)));
+    CHECK(sameColor(p.color2, RGB(0, 0, 16)));
+
+    CHECK(parseEffect("noise palette=forest scale=2.5", p, error));
+    CHECK(p.palette == Palette::Forest);
+    CHECK_EQ(p.scale, 2.5f);
+
+    // a failed parse leaves the previous params alone
+    CHECK(!parseEffect("sparkle", p, error));
+    CHECK(!parseEffect("", p, error));
+    CHECK(!parseEffect("rainbow speed=17", p, error));
+    CHECK(!parseEffect("rainbow speed=fast", p, error));
+    CHECK(!parseEffect("gradient color=12345", p, error));
+    CHECK(!parseEffect("chase size=0", p, error));
+    CHECK(!parseEffect("fire palette=lava", p, error));
+    CHECK(!parseEffect("rainbow speed", p, error));
+    CHECK(p.type == EffectType::Noise);
+}
+
+// renders `text` once and returns the frame; speed 0 keeps the phase at 0
+static std::vector<RGB> renderOnce(const std::string& text, int leds) {
+    CaptureTarget target(leds);
+    EffectEngine engine(target);
+    std::string error;
+    CHECK(engine.command(text, error));
+    CHECK(engine.start());
+    CHECK(target.waitUntil([&] { return target.frames() > 0; }));
+    engine.stop();
+    std::vector<RGB> frame = target.last();
+    frame.resize(leds);         // no frame: fail the checks, don't crash
+    return frame;
+}
+
+static void testStaticFrames() {
+    // one repeat across 4 LEDs: color, halfway, color2, halfway back
+    std::vector<RGB> f = renderOnce("gradient speed=0 color=ff0000 color2=0000ff", 4);
+    CHECK_EQ(f.size(), 4u);
+    CHECK(sameColor(f[0], RGB(255, 0, 0)));
+    CHECK(sameColor(f[2], RGB(0, 0, 255)));
+    CHECK_NEAR(f[1].r, 127, 1);
+    CHECK_NEAR(f[3].b, 127, 1);
+
+    // head on LED 0, the tail fades backwards from the last LED and never
+    // wraps onto the (unlit) LED ahead of the head
+    f = renderOnce("chase speed=0 size=8 color=ff0000 color2=000000", 4);
+    CHECK_EQ(f[0].r, 255);
+    CHECK_EQ(f[1].r, 0);
+    CHECK(f[3].r > f[2].r);
+    CHECK(f[2].r > 0);
+
+    f = renderOnce("chase speed=0 color=ff0000 color2=000000", 1);
+    CHECK_EQ(f[0].r, 255);
+
+    // phase 0 is the middle of the sine
+    f = renderOnce("breathing speed=0 color=ff8000", 3);
+    CHECK_NEAR(f[0].r, 128, 1);
+    CHECK_NEAR(f[0].g, 64, 1);
+    CHECK(sameColor(f[0], f[2]));
+}
+
+// the slowest configurable rate still renders (the period is a whole second)
+static void testSlowRate() {
+    CaptureTarget target(2);
+    EffectEngine engine(target, 1);
+    std::string error;
+    CHECK(engine.command("rainbow", error));
+    CHECK(engine.start());
+    CHECK(target.waitUntil([&] { return target.frames() > 0; }));
+    engine.stop();
+}
+
+// off stops the frames and releases the target once
+static void testOff() {
+    CaptureTarget target(8);
+    EffectEngine engine(target, 500);
+    std::string error;
+    CHECK(engine.command("fire", error));
+    CHECK(engine.start());
+    CHECK(target.waitUntil([&] { return target.frames() > 5; }));
+    CHECK(engine.stats().type == EffectType::Fire);
+    CHECK(engine.stats().frames > 0);
+
+    CHECK(engine.command("off", error));
+    target.waitUntil([&] { return target.releases() > 0; });
+    CHECK_EQ(target.releases(), 1);
+    const int frames = target.frames();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_EQ(target.frames(), frames);
+    CHECK(engine.stats().type == EffectType::Off);
+    engine.stop();
+}
+
+static std::shared_ptr<const ExprProgram> compileOk(const std::string& text) {
+    std::string error;
+    auto program = ExprProgram::compile(text, error);
+    CHECK(program != nullptr);
+    if (!program) std::cerr << "  " << text << ": " << error << "\n";
+    return program;
+}
+
+static std::string compileError(const std::string& text) {
+    std::string error;
+    CHECK(ExprProgram::compile(text, error) == nullptr);
+    return error;
+}
+
+static void testExprErrors() {
+    CHECK_EQ(compileError(""), "col 1: no statements");
+    CHECK_EQ(compileError("r = 1 +"), "col 8: expected a value");
+    CHECK_EQ(compileError("r = foo(1)"), "col 9: unknown function 'foo'");
+    CHECK_EQ(compileError("r = q"), "col 6: unknown name 'q'");
+    CHECK_EQ(compileError("t = 1"), "col 2: 't' is an input");
+    CHECK_EQ(compileError("r = 1 2"), "col 7: expected ';' or end of line");
+    CHECK_EQ(compileError("r = min(1)"), "col 10: expected ','");
+    CHECK_EQ(compileError("r = (x"), "col 7: expected ')'");
+
+    // nesting, registers and length are bounded
+    const int deep = ExprProgram::MAX_DEPTH + 1;
+    CHECK(compileError("r = " + std::string(deep, '(') + "x" + std::string(deep, ')')).find("too deep") !=
+          std::string::npos);
+    std::string sum = "r = x";
+    for (int k = 0; k < ExprProgram::MAX_REGISTERS; ++k) sum += "+x";
+    CHECK(compileError(sum).find("too long") != std::string::npos);
+    CHECK(compileError("r = " + std::string(ExprProgram::MAX_SOURCE, '1')).find("longer than") != std::string::npos);
+}
+
+// constant subexpressions fold, inputs and locals don't
+static void testExprFolding() {
+    auto p = compileOk("r = sin(1) * 100 + clamp(400, 0, 255)");
+    if (p) CHECK_EQ(p->instructions(), 0u);
+    p = compileOk("k = 2 * 3\nr = x * k; g = r");
+    if (p) CHECK_EQ(p->instructions(), 1u);
+    CHECK_EQ(ExprProgram::evalScalar(ExprProgram::Op::Mod, -1.0f, 4.0f, 0.0f), 3.0f);
+    CHECK_EQ(ExprProgram::evalScalar(ExprProgram::Op::Step, 0.5f, 0.5f, 0.0f), 1.0f);
+}
+
+// more LEDs than one batch, every operator, against std:: math per LED
+static void testExprLanes() {
+    auto p = compileOk(
+        "s = sin(t*2 + i*0.1)*127 + 128; c = cos(x*6.2832)\n"
+        "r = s; g = abs(c)*200 + (i % 7) + fract(x*3.5)*10 + floor(x*4)*5\n"
+        "b = mix(min(i, 90), max(sqrt(i)*10, 20), step(0.5, x)) + (i < 10)*40 - (i > 140)*(-3) + clamp(-i, -20, 10)/2");
+    if (!p) return;
+    const int leds = 150;
+    const float t = 1.25f;
+    std::vector<RGB> frame(leds);
+    ExprVM vm;
+    vm.run(*p, t, frame);
+
+    auto byte = [](double v) { return std::lround(std::min(255.0, std::max(0.0, v))); };
+    int worst = 0;
+    for (int i = 0; i < leds; ++i) {
+        const double x = static_cast<double>(i) / leds;
+        const double r = std::sin(t * 2 + i * 0.1) * 127 + 128;
+        const double g = std::fabs(std::cos(x * 6.2832)) * 200 + (i % 7) + (x * 3.5 - std::floor(x * 3.5)) * 10 +
+                         std::floor(x * 4) * 5;
+        const double b = (x < 0.5 ? std::min(i, 90) : std::max(std::sqrt(i) * 10, 20.0)) + (i < 10) * 40 +
+                         (i > 140) * 3 + std::max(-20, std::min(-i, 10)) / 2.0;
+        worst = std::max<int>(worst, std::abs(frame[i].r - byte(r)));
+        worst = std::max<int>(worst, std::abs(frame[i].g - byte(g)));
+        worst = std::max<int>(worst, std::abs(frame[i].b - byte(b)));
+    }
+    CHECK(worst <= 1);
+
+    // unassigned outputs are black, NaN clamps to 0, the same VM switches programs
+    p = compileOk("g = 0/0 + 300");
+    if (!p) return;
+    vm.run(*p, t, frame);
+    CHECK(sameColor(frame[0], RGB(0, 0, 0)));
+    p = compileOk("g = 300");
+    if (!p) return;
+    vm.run(*p, t, frame);
+    CHECK(sameColor(frame[leds - 1], RGB(0, 255, 0)));
+}
+
+int main() {
+    testParse();
+    testStaticFrames();
+    testSlowRate();
+    testOff();
+    testExprErrors();
+    testExprFolding();
+    testExprLanes();
+    return testResult("test_effects");
+}
@@ -0,0 +1,342 @@
+// cpp/tests/test_led_driver.cpp
+// LEDDriver wire output: color order, segments, dithering, calibration, power
+// limit; output trace round trip
+#include "led_driver.h"
+#include "trace.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// keeps the last frame the driver wrote
+class CaptureSink : public OutputSink
+{
+public:
+    bool write(const uint8_t* data, size_t size) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        last.assign(data, data + size);
+        ++writes;
+        return true;
+    }
+
+    std::mutex mutex;
+    std::vector<uint8_t> last;
+    int writes = 0;
+};
+
+// gamma 1 and no smoothing: the wire carries the submitted values
+static void configureLinear(LEDDriver& driver, std::vector<LedSegment> segments = {}) {
+    LEDDriver::OutputConfig oc;
+    oc.gamma = 1.0f;
+    oc.segments = std::move(segments);
+    CHECK(driver.setOutputConfig(oc));
+    driver.setSmoothingTime(0.0f);
+}
+
+static std::vector<RGB> ramp(int leds) {
+    std::vector<RGB> colors(leds);
+    for (int i = 0; i < leds; ++i) colors[i] = RGB(static_cast<uint8_t>(10 * i + 1), static_cast<uint8_t>(10 * i + 2),
+                                                   static_cast<uint8_t>(10 * i + 3));
+    return colors;
+}
+
+static void testPassThrough() {
+    auto sink = std::make_unique<CaptureSink>();
+    CaptureSink* cap = sink.get();
+    LEDDriver driver(std::move(sink), 4);
+    configureLinear(driver);
+    driver.submitFrame(ramp(4));
+    CHECK_EQ(cap->last.size(), 12u);
+    CHECK_EQ(cap->last[0], 1);
+    CHECK_EQ(cap->last[11], 33);
+
+    // wrong size is ignored
+    const int writes = cap->writes;
+    driver.submitFrame(ramp(3));
+    CHECK_EQ(cap->writes, writes);
+}
+
+static void testSegments() {
+    auto sink = std::make_unique<CaptureSink>();
+    CaptureSink* cap = sink.get();
+    LEDDriver driver(std::move(sink), 4);
+    // LEDs 0-1 GRB, LEDs 2-3 RGB and wired in reverse
+    configureLinear(driver, { LedSegment{0, 2, ColorOrder::GRB, false}, LedSegment{2, 2, ColorOrder::RGB, true} });
+    driver.submitFrame(ramp(4));
+    const std::vector<uint8_t> expect = { 2, 1, 3, 12, 11, 13, 31, 32, 33, 21, 22, 23 };
+    CHECK(cap->last == expect);
+
+    // gaps and overlaps are rejected, the old layout stays
+    CHECK(!driver.setSegments({ LedSegment{0, 2, ColorOrder::RGB, false}, LedSegment{3, 1, ColorOrder::RGB, false} }));
+    driver.submitFrame(ramp(4));
+    CHECK(cap->last == expect);
+}
+
+// every order is a permutation of the logical channels
+static void testColorOrders() {
+    const char* names[] = { "RGB", "RBG", "GRB", "GBR", "BRG", "BGR" };
+    for (const char* name : names) {
+        ColorOrder order;
+        CHECK(parseColorOrder(name, order));
+        CHECK_EQ(std::string(colorOrderName(order)), std::string(name));
+
+        auto sink = std::make_unique<CaptureSink>();
+        CaptureSink* cap = sink.get();
+        LEDDriver driver(std::move(sink), 1);
+        configureLinear(driver);
+        driver.setColorOrder(order);
+        driver.submitFrame({ RGB('R', 'G', 'B') });
+        CHECK_EQ(std::string(cap->last.begin(), cap->last.end()), std::string(name));
+    }
+    ColorOrder order;
+    CHECK(!parseColorOrder("RGBW", order));
+
+    LedSegment seg;
+    CHECK(parseSegment("10:20:BGR:R", ColorOrder::GRB, seg));
+    CHECK_EQ(seg.start, 10);
+    CHECK_EQ(seg.count, 20);
+    CHECK(seg.order == ColorOrder::BGR);
+    CHECK(seg.reversed);
+    CHECK(parseSegment("0:5", ColorOrder::GRB, seg));
+    CHECK(seg.order == ColorOrder::GRB);
+    CHECK(!seg.reversed);
+    CHECK(!parseSegment("0:0", ColorOrder::RGB, seg));
+    CHECK(!parseSegment("0:5:XYZ", ColorOrder::RGB, seg));
+}
+
+// the 8.8 LUT value for level v at gamma 1 (see compileCalibration)
+static double wireTarget(int v, float brightness) {
+    return static_cast<uint16_t>(v * brightness * 256.0f + 0.5f) / 256.0;
+}
+
+// the mean over N refreshes is the 8.8 value within 1/N; without
+// dithering every refresh sends the same rounded byte
+static void testDithering() {
+    const int N = 64;
+    const float brightness = 0.3f;
+    for (bool dither : { true, false }) {
+        auto sink = std::make_unique<CaptureSink>();
+        CaptureSink* cap = sink.get();
+        LEDDriver driver(std::move(sink), 3);
+        configureLinear(driver);
+        driver.setBrightness(brightness);
+        driver.setDithering(dither);
+        const std::vector<RGB> frame = { RGB(101, 7, 255), RGB(1, 50, 33), RGB(0, 128, 250) };
+        driver.submitFrame(frame);
+
+        const std::vector<uint8_t> first = cap->last;
+        std::vector<long> sum(first.size(), 0);
+        int changed = 0;
+        for (int k = 0; k < N; ++k) {
+            driver.show();
+            if (cap->last != first) ++changed;
+            for (size_t i = 0; i < sum.size(); ++i) sum[i] += cap->last[i];
+        }
+        const uint8_t* logical = reinterpret_cast<const uint8_t*>(frame.data());
+        for (size_t i = 0; i < sum.size(); ++i) {
+            const double target = wireTarget(logical[i], brightness);
+            if (dither) {
+                CHECK_NEAR(double(sum[i]) / N, target, 1.0 / N);
+            } else {
+                CHECK_EQ(int(first[i]), int(std::lround(target)));
+            }
+        }
+        if (dither) CHECK(changed > 0);    // 30.3 alternates between 30 and 31
+        else CHECK_EQ(changed, 0);
+    }
+}
+
+static void testCalibration() {
+    auto sink = std::make_unique<CaptureSink>();
+    CaptureSink* cap = sink.get();
+    LEDDriver driver(std::move(sink), 2);
+    configureLinear(driver, { LedSegment{0, 1, ColorOrder::RGB, false}, LedSegment{1, 1, ColorOrder::RGB, false} });
+    driver.handleCommand("CALIB SEG 1 WB 0.5 1 1");
+    driver.submitFrame({ RGB(200, 100, 50), RGB(200, 100, 50) });
+    CHECK_EQ(cap->last[0], 200);
+    CHECK_EQ(cap->last[3], 100);                   // red halved on segment 1 only
+    CHECK_EQ(cap->last[4], 100);
+
+    driver.handleCommand("CALIB SEG 1 RESET");
+    driver.submitFrame({ RGB(200, 100, 50), RGB(200, 100, 50) });
+    CHECK_EQ(cap->last[3], 200);
+
+    // off-diagonal terms mix channels (Q12 path): red and blue swapped
+    driver.handleCommand("CALIB MATRIX 0 0 1  0 1 0  1 0 0");
+    driver.submitFrame({ RGB(200, 100, 50), RGB(200, 100, 50) });
+    CHECK_EQ(cap->last[0], 50);
+    CHECK_EQ(cap->last[1], 100);
+    CHECK_EQ(cap->last[5], 200);
+}
+
+static void testCalibrationParse() {
+    Calibration c;
+    std::string error;
+    std::istringstream wb("WB 1 0.9 0.8");
+    CHECK(parseCalibration(wb, c, error));
+    CHECK_NEAR(c.matrix[8], 0.8, 1e-6);
+    std::istringstream negative("WB 1 1 -1");
+    CHECK(!parseCalibration(negative, c, error));
+    std::istringstream shortMatrix("MATRIX 1 0 0 0 1 0 0 0");
+    CHECK(!parseCalibration(shortMatrix, c, error));
+    CHECK(!error.empty());
+    CHECK_NEAR(c.matrix[8], 0.8, 1e-6);              // untouched on error
+}
+
+// the lane form against the 3x3 product per pixel, over a full block and a tail
+static void testColorMatrix() {
+    Calibration c;
+    const float m[9] = { 0.9f, 0.2f, -0.1f, 0.05f, 1.1f, 0.0f, -0.3f, 0.4f, 1.5f };
+    std::copy(m, m + 9, c.matrix);
+    CompiledCalibration compiled;
+    compileCalibration(c, 1.0f, 1.0f, compiled);
+    CHECK(compiled.mix);
+
+    const int leds = CALIB_LANES / 3 + 5;
+    std::vector<uint8_t> rgb(leds * 3);
+    for (size_t i = 0; i < rgb.size(); ++i) rgb[i] = static_cast<uint8_t>(i * 37 % 256);
+    const std::vector<uint8_t> in = rgb;
+    applyColorMatrix(compiled, rgb.data(), leds);
+    int worst = 0;
+    for (int p = 0; p < leds; ++p) {
+        for (int ch = 0; ch < 3; ++ch) {
+            double v = 0.0;
+            for (int j = 0; j < 3; ++j) v += m[ch * 3 + j] * in[p * 3 + j];
+            const int expect = static_cast<int>(std::lround(std::min(255.0, std::max(0.0, v))));
+            worst = std::max(worst, std::abs(rgb[p * 3 + ch] - expect));
+        }
+    }
+    CHECK(worst <= 1);
+}
+
+static void testPowerLimit() {
+    auto sink = std::make_unique<CaptureSink>();
+    CaptureSink* cap = sink.get();
+    LEDDriver driver(std::move(sink), 10);
+    configureLinear(driver);
+    PowerModel pm;
+    pm.idlemA = 0.0f;
+    pm.budgetmA = 300.0f;                          // full white would be 600 mA
+    driver.setPowerModel(pm);
+    driver.submitFrame(std::vector<RGB>(10, RGB(255, 255, 255)));
+    for (uint8_t v : cap->last) CHECK(v >= 126 && v <= 129);
+
+    pm.budgetmA = 0.0f;
+    driver.setPowerModel(pm);
+    driver.submitFrame(std::vector<RGB>(10, RGB(255, 255, 255)));
+    CHECK_EQ(cap->last[0], 255);
+}
+
+// the current of a logical channel is found whatever the wire order
+static void testPowerPerChannel() {
+    auto sink = std::make_unique<CaptureSink>();
+    CaptureSink* cap = sink.get();
+    LEDDriver driver(std::move(sink), 10);
+    configureLinear(driver, { LedSegment{0, 10, ColorOrder::GRB, false} });
+    PowerModel pm;
+    pm.idlemA = 0.0f;
+    pm.channelmA[0] = 40.0f;                       // only red draws current
+    pm.channelmA[1] = 0.0f;
+    pm.channelmA[2] = 0.0f;
+    pm.budgetmA = 200.0f;                          // full red would be 400 mA
+    driver.setPowerModel(pm);
+    driver.submitFrame(std::vector<RGB>(10, RGB(255, 0, 0)));
+    CHECK(cap->last[1] >= 126 && cap->last[1] <= 129);   // GRB: red is byte 1
+    driver.submitFrame(std::vector<RGB>(10, RGB(0, 255, 255)));
+    CHECK_EQ(cap->last[0], 255);                   // free channels untouched
+}
+
+static void testSumTriplets() {
+    std::vector<uint16_t> wire(3 * 21);
+    for (size_t i = 0; i < wire.size(); ++i) wire[i] = static_cast<uint16_t>(i * 997 % 65281);
+    uint64_t out[3];
+    sumTriplets(wire.data(), 21, out);            // 2 blocks of 8 + a tail of 5
+    uint64_t ref[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < wire.size(); ++i) ref[i % 3] += wire[i];
+    for (int c = 0; c < 3; ++c) CHECK_EQ(out[c], ref[c]);
+}
+
+static void testTrace() {
+    char path[] = "/tmp/test_led_driver_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+
+    auto sink = std::make_unique<CaptureSink>();
+    CaptureSink* cap = sink.get();
+    std::vector<std::vector<uint8_t>> written;
+    {
+        LEDDriver driver(std::move(sink), 8);
+        configureLinear(driver);
+        CHECK(driver.startTrace(path));
+        for (int f = 0; f < 5; ++f) {
+            std::vector<RGB> colors = ramp(8);
+            colors[f].g = 0;                        // one LED changes per frame
+            driver.submitFrame(colors);
+            written.push_back(cap->last);
+        }
+        driver.stopTrace();
+    }
+
+    TraceReader reader;
+    CHECK(reader.open(path));
+    size_t frames = 0;
+    while (reader.next()) {
+        if (frames < written.size()) CHECK(reader.frame() == written[frames]);
+        ++frames;
+    }
+    CHECK_EQ(frames, written.size());
+    unlink(path);
+}
+
+// a record whose skip or length runs past the frame (or wraps size_t)
+// ends the trace instead of writing outside it
+static void testTraceCorrupt() {
+    auto u32 = [](std::string& out, uint32_t v) {
+        for (int k = 0; k < 4; ++k) out += static_cast<char>(v >> (8 * k));
+    };
+    const std::string huge = "\xFE\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x01";   // varint SIZE_MAX - 1
+    const std::string payloads[] = { huge + "\x02" + "ab",            // skip wraps pos
+                                     std::string("\x04") + huge + "ab", // length wraps pos + len
+                                     std::string("\x05\x02") + "ab" };  // runs one byte past 6
+    for (const std::string& payload : payloads) {
+        char path[] = "/tmp/test_led_driver_XXXXXX";
+        const int fd = mkstemp(path);
+        if (fd >= 0) close(fd);
+        std::string file(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        u32(file, TRACE_VERSION);
+        u32(file, 6);                               // frame bytes
+        u32(file, static_cast<uint32_t>(payload.size()));
+        u32(file, 1);                               // runs
+        file += std::string(8, '\0');              // timestamp
+        file += payload;
+        std::ofstream(path, std::ios::binary) << file;
+
+        TraceReader reader;
+        CHECK(reader.open(path));
+        CHECK(!reader.next());
+        unlink(path);
+    }
+}
+
+int main() {
+    testPassThrough();
+    testSegments();
+    testColorOrders();
+    testDithering();
+    testCalibration();
+    testCalibrationParse();
+    testColorMatrix();
+    testPowerLimit();
+    testPowerPerChannel();
+    testSumTriplets();
+    testTrace();
+    testTraceCorrupt();
+    return testResult("test_led_driver");
+}
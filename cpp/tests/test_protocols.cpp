@@ -0,0 +1,539 @@
+// cpp/tests/test_protocols.cpp
+// Network receivers: E1.31 / Art-Net packet round trips and frame assembly,
+// DDP offset handling, OPC mapping and TCP framing; IPC server shutdown
+#include "ddp_receiver.h"
+#include "dmx_protocol.h"
+#include "dmx_receiver.h"
+#include "ipc_server.h"
+#include "led_driver.h"
+#include "opc_server.h"
+#include "test_util.h"
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const uint8_t CID[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+static constexpr int DDP_TEST_PORT = 40480;
+static constexpr int OPC_TEST_PORT = 40490;
+static constexpr int IPC_TEST_PORT = 40500;
+static constexpr int DMX_TEST_PORT = 40510;
+
+static std::vector<uint8_t> pattern(size_t n) {
+    std::vector<uint8_t> v(n);
+    for (size_t i = 0; i < n; ++i) v[i] = static_cast<uint8_t>(i * 7 + 3);
+    return v;
+}
+
+// -----------------------------
+// E1.31
+// -----------------------------
+static void testE131RoundTrip() {
+    const std::vector<uint8_t> data = pattern(DMX_CHANNELS);
+    uint8_t buf[DMX_PACKET_MAX];
+    const size_t len = buildE131Data(buf, CID, 7, 42, 9, data.data(), DMX_CHANNELS);
+    CHECK_EQ(len, DMX_PACKET_MAX);
+
+    DmxPacket p;
+    CHECK(parseE131(buf, len, p));
+    CHECK(p.type == DmxPacket::Type::Data);
+    CHECK_EQ(p.universe, 7);
+    CHECK_EQ(p.sequence, 42);
+    CHECK_EQ(p.syncAddress, 9);
+    CHECK_EQ(p.priority, 100);
+    CHECK_EQ(p.length, DMX_CHANNELS);
+    CHECK(std::memcmp(p.data, data.data(), DMX_CHANNELS) == 0);
+
+    // short universes work too
+    const size_t shortLen = buildE131Data(buf, CID, 1, 0, 0, data.data(), 30);
+    CHECK(parseE131(buf, shortLen, p));
+    CHECK_EQ(p.length, 30);
+
+    const size_t syncLen = buildE131Sync(buf, CID, 9, 5);
+    CHECK(parseE131(buf, syncLen, p));
+    CHECK(p.type == DmxPacket::Type::Sync);
+    CHECK_EQ(p.syncAddress, 9);
+    CHECK_EQ(p.sequence, 5);
+}
+
+static void testE131Malformed() {
+    const std::vector<uint8_t> data = pattern(DMX_CHANNELS);
+    uint8_t buf[DMX_PACKET_MAX];
+    const size_t len = buildE131Data(buf, CID, 1, 0, 0, data.data(), DMX_CHANNELS);
+    DmxPacket p;
+
+    // truncated anywhere: header, slots, below the sync size
+    CHECK(!parseE131(buf, len - 1, p));
+    CHECK(!parseE131(buf, 125, p));
+    CHECK(!parseE131(buf, 10, p));
+    CHECK(!parseE131(buf, 0, p));
+
+    // property count larger than the datagram
+    uint8_t bad[DMX_PACKET_MAX];
+    std::memcpy(bad, buf, len);
+    bad[123] = 0x02;                 // start code + 513 slots
+    bad[124] = 0x02;
+    CHECK(!parseE131(bad, len, p));
+    bad[123] = 0;                    // zero slots (no start code)
+    bad[124] = 0;
+    CHECK(!parseE131(bad, len, p));
+
+    std::memcpy(bad, buf, len);
+    bad[125] = 0xDD;                 // per-address priority start code
+    CHECK(!parseE131(bad, len, p));
+
+    std::memcpy(bad, buf, len);
+    bad[112] = 0x80;                 // preview data
+    CHECK(!parseE131(bad, len, p));
+    bad[112] = 0x40;                 // stream terminated
+    CHECK(!parseE131(bad, len, p));
+
+    std::memcpy(bad, buf, len);
+    bad[5] = 'X';                    // ACN packet identifier
+    CHECK(!parseE131(bad, len, p));
+}
+
+// -----------------------------
+// Art-Net
+// -----------------------------
+static void testArtNetRoundTrip() {
+    const std::vector<uint8_t> data = pattern(DMX_CHANNELS + 2);
+    uint8_t buf[DMX_PACKET_MAX];
+    const size_t len = buildArtDmx(buf, 0x1234, 17, data.data(), DMX_CHANNELS);
+
+    DmxPacket p;
+    CHECK(parseArtNet(buf, len, p));
+    CHECK(p.type == DmxPacket::Type::Data);
+    CHECK_EQ(p.universe, 0x1234);
+    CHECK_EQ(p.sequence, 17);
+    CHECK_EQ(p.length, DMX_CHANNELS);
+    CHECK(std::memcmp(p.data, data.data(), DMX_CHANNELS) == 0);
+
+    // odd lengths are padded to even on the wire: only the given bytes are
+    // read, the pad is zero
+    const std::vector<uint8_t> odd = pattern(45);
+    std::memset(buf, 0xAA, sizeof(buf));
+    const size_t oddLen = buildArtDmx(buf, 0, 0, odd.data(), 45);
+    CHECK(parseArtNet(buf, oddLen, p));
+    CHECK_EQ(p.length, 46);
+    CHECK(std::memcmp(p.data, odd.data(), 45) == 0);
+    CHECK_EQ(p.data[45], 0);
+
+    const size_t syncLen = buildArtSync(buf);
+    CHECK(parseArtNet(buf, syncLen, p));
+    CHECK(p.type == DmxPacket::Type::Sync);
+}
+
+static void testArtNetMalformed() {
+    const std::vector<uint8_t> data = pattern(DMX_CHANNELS);
+    uint8_t buf[DMX_PACKET_MAX];
+    const size_t len = buildArtDmx(buf, 3, 0, data.data(), 100);
+    DmxPacket p;
+
+    CHECK(!parseArtNet(buf, len - 1, p));     // length field beyond the datagram
+    CHECK(!parseArtNet(buf, 17, p));          // header cut off
+    CHECK(!parseArtNet(buf, 4, p));
+
+    uint8_t bad[DMX_PACKET_MAX];
+    std::memcpy(bad, buf, len);
+    bad[16] = 0x02;                           // 514 channels
+    bad[17] = 0x02;
+    CHECK(!parseArtNet(bad, sizeof(bad), p));
+
+    std::memcpy(bad, buf, len);
+    bad[9] = 0x20;                            // ArtPoll
+    CHECK(!parseArtNet(bad, len, p));
+}
+
+static void testSequence() {
+    CHECK(sequenceStale(10, 10));
+    CHECK(sequenceStale(10, 9));
+    CHECK(!sequenceStale(10, 11));
+    CHECK(sequenceStale(10, 250));            // 16 behind across the wrap
+    CHECK(!sequenceStale(250, 5));            // ahead across the wrap
+    CHECK(!sequenceStale(100, 70));           // far behind: sender restarted
+}
+
+// frame number n from a receiver; out is all black on timeout
+static bool waitFrames(CaptureTarget& target, int n, std::vector<RGB>& out) {
+    if (target.waitUntil([&] { return target.frames() >= n; })) {
+        out = target.last();
+        return true;
+    }
+    out.assign(target.numLeds(), RGB());
+    return false;
+}
+
+// counts the frames the driver wrote, keeps the first byte of the last one
+class CountingSink : public OutputSink
+{
+public:
+    bool write(const uint8_t* data, size_t size) override {
+        if (size) first = data[0];
+        ++writes;
+        return true;
+    }
+
+    std::atomic<int> writes{0};
+    std::atomic<int> first{0};
+};
+
+static int connectLocal(int port) {
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// -----------------------------
+// DMX receiver
+// -----------------------------
+// sends one Art-Net universe of leds * 3 bytes, every byte = value
+static void sendArtDmx(int fd, const sockaddr_in& to, uint16_t universe, uint8_t sequence, int leds, uint8_t value) {
+    const std::vector<uint8_t> data(static_cast<size_t>(leds) * 3, value);
+    uint8_t buf[DMX_PACKET_MAX];
+    const size_t len = buildArtDmx(buf, universe, sequence, data.data(), static_cast<uint16_t>(data.size()));
+    sendto(fd, buf, len, 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+}
+
+static void sendArtSync(int fd, const sockaddr_in& to) {
+    uint8_t buf[DMX_PACKET_MAX];
+    const size_t len = buildArtSync(buf);
+    sendto(fd, buf, len, 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+}
+
+// 6 LEDs over 3 universes of 2: a frame is rendered when all universes are
+// in, when a universe repeats (partial), when the frame times out (partial)
+// and - once the sender syncs - only on the sync packet
+static void testDmxAssembly() {
+    CaptureTarget target(6);
+    DmxReceiver::Params params;
+    params.protocol = DmxReceiver::Protocol::ArtNet;
+    params.port = DMX_TEST_PORT;
+    params.ledsPerUniverse = 2;
+    DmxReceiver receiver(target, params);
+    if (!receiver.start()) {
+        CHECK(!"DMX receiver did not start");
+        return;
+    }
+    CHECK_EQ(receiver.universes(), 3);
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(DMX_TEST_PORT);
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    uint8_t seq = 0;
+    std::vector<RGB> frame;
+
+    // complete: the last universe renders
+    sendArtDmx(fd, to, 0, ++seq, 2, 10);
+    sendArtDmx(fd, to, 1, ++seq, 2, 11);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK_EQ(target.frames(), 0);
+    sendArtDmx(fd, to, 2, ++seq, 2, 12);
+    CHECK(waitFrames(target, 1, frame));
+    CHECK_EQ(frame[0].r, 10);
+    CHECK_EQ(frame[5].b, 12);
+
+    // universe 0 repeats before universe 2: what arrived is rendered, the
+    // repeat starts the next frame
+    sendArtDmx(fd, to, 0, ++seq, 2, 20);
+    sendArtDmx(fd, to, 1, ++seq, 2, 21);
+    sendArtDmx(fd, to, 0, ++seq, 2, 30);
+    CHECK(waitFrames(target, 2, frame));
+    CHECK_EQ(frame[0].r, 20);
+    CHECK_EQ(frame[2].r, 21);
+    CHECK_EQ(frame[4].r, 12);                          // missing universe keeps its last data
+
+    // the sender stops: the pending universe 0 is flushed after the timeout
+    CHECK(waitFrames(target, 3, frame));
+    CHECK_EQ(frame[0].r, 30);
+    CHECK_EQ(frame[2].r, 21);
+
+    // with ArtSync the complete frame waits for the sync packet
+    sendArtSync(fd, to);
+    sendArtDmx(fd, to, 0, ++seq, 2, 40);
+    sendArtDmx(fd, to, 1, ++seq, 2, 41);
+    sendArtDmx(fd, to, 2, ++seq, 2, 42);
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));   // past the frame timeout too
+    CHECK_EQ(target.frames(), 3);
+    sendArtSync(fd, to);
+    CHECK(waitFrames(target, 4, frame));
+    CHECK_EQ(frame[0].r, 40);
+    CHECK_EQ(frame[5].b, 42);
+
+    close(fd);
+    receiver.stop();
+    const DmxReceiver::Stats s = receiver.stats();
+    CHECK_EQ(s.frames, 2u);
+    CHECK_EQ(s.partial, 2u);
+    CHECK_EQ(s.stale, 0u);
+}
+
+// -----------------------------
+// DDP
+// -----------------------------
+static void sendDdp(int fd, uint8_t flags, uint32_t offset, const std::vector<uint8_t>& payload,
+                    size_t announced) {
+    std::vector<uint8_t> pkt(10);
+    pkt[0] = static_cast<uint8_t>(0x40 | flags);
+    pkt[1] = 0;
+    pkt[2] = 0x0B;                   // RGB, 8 bit
+    pkt[3] = 1;                      // default output device
+    pkt[4] = static_cast<uint8_t>(offset >> 24);
+    pkt[5] = static_cast<uint8_t>(offset >> 16);
+    pkt[6] = static_cast<uint8_t>(offset >> 8);
+    pkt[7] = static_cast<uint8_t>(offset);
+    pkt[8] = static_cast<uint8_t>(announced >> 8);
+    pkt[9] = static_cast<uint8_t>(announced);
+    pkt.insert(pkt.end(), payload.begin(), payload.end());
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(DDP_TEST_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (sendto(fd, pkt.data(), pkt.size(), 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("sendto");
+    }
+}
+
+static void testDdpOffsets() {
+    CaptureTarget target(10);        // 30 bytes
+    DdpReceiver receiver(target, DDP_TEST_PORT);
+    if (!receiver.start()) {
+        CHECK(!"DDP receiver did not start");
+        return;
+    }
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    const uint8_t PUSH = 0x01;
+    std::vector<RGB> frame;
+
+    // in range: LED 2 and 3
+    sendDdp(fd, PUSH, 6, { 10, 11, 12, 20, 21, 22 }, 6);
+    CHECK(waitFrames(target, 1, frame));
+    CHECK_EQ(frame[2].r, 10);
+    CHECK_EQ(frame[3].b, 22);
+    CHECK_EQ(frame[4].r, 0);
+
+    // runs past the end: the part that fits is written, the rest clipped
+    sendDdp(fd, PUSH, 27, { 1, 2, 3, 4, 5, 6 }, 6);
+    CHECK(waitFrames(target, 2, frame));
+    CHECK_EQ(frame[9].r, 1);
+    CHECK_EQ(frame[9].b, 3);
+
+    // starts past the end: nothing written, the push still shows the frame
+    sendDdp(fd, PUSH, 300, { 99, 99, 99 }, 3);
+    CHECK(waitFrames(target, 3, frame));
+    CHECK_EQ(frame[9].r, 1);
+
+    // announces more than it carries: counted as ignored, not pushed
+    sendDdp(fd, PUSH, 0, { 7, 7, 7 }, 30);
+    // header-only garbage (wrong version)
+    sendDdp(fd, 0x80, 0, {}, 0);
+    sendDdp(fd, PUSH, 0, { 5, 5, 5 }, 3);
+    CHECK(waitFrames(target, 4, frame));
+    CHECK_EQ(frame[0].r, 5);
+
+    const DdpReceiver::Stats s = receiver.stats();
+    CHECK_EQ(s.frames, 4u);
+    CHECK_EQ(s.clipped, 2u);
+    CHECK_EQ(s.ignored, 2u);
+    close(fd);
+    receiver.stop();
+}
+
+// -----------------------------
+// OPC
+// -----------------------------
+static void testOpcMapping() {
+    std::vector<OpcServer::Mapping> m;
+    CHECK(OpcServer::parseMapping("1:0:30 2:30:30", m));
+    CHECK_EQ(m.size(), 2u);
+    CHECK_EQ(m[1].channel, 2);
+    CHECK_EQ(m[1].start, 30);
+    CHECK_EQ(m[1].count, 30);
+
+    CHECK(OpcServer::parseMapping("", m));
+    CHECK(m.empty());
+
+    m.assign(1, OpcServer::Mapping{});
+    CHECK(!OpcServer::parseMapping("0:0:10", m));      // channel 0 is broadcast
+    CHECK(!OpcServer::parseMapping("256:0:10", m));
+    CHECK(!OpcServer::parseMapping("1:-1:10", m));
+    CHECK(!OpcServer::parseMapping("1:0:0", m));
+    CHECK(!OpcServer::parseMapping("1:0:10x", m));
+    CHECK(!OpcServer::parseMapping("1:0", m));
+    CHECK_EQ(m.size(), 1u);                            // untouched on error
+}
+
+static std::vector<uint8_t> opcMessage(uint8_t channel, uint8_t command, const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> msg = { channel, command, static_cast<uint8_t>(payload.size() >> 8),
+                                 static_cast<uint8_t>(payload.size()) };
+    msg.insert(msg.end(), payload.begin(), payload.end());
+    return msg;
+}
+
+static void sendAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n <= 0) {
+            perror("send");
+            return;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+// a message split anywhere (even inside the header) is put together before
+// it is shown; unknown commands and channels are skipped
+static void testOpcFraming() {
+    CaptureTarget target(4);
+    OpcServer server(target, OPC_TEST_PORT, { OpcServer::Mapping{1, 0, 2}, OpcServer::Mapping{2, 2, 2} });
+    if (!server.start()) {
+        CHECK(!"OPC server did not start");
+        return;
+    }
+    const int fd = connectLocal(OPC_TEST_PORT);
+    if (fd < 0) {
+        CHECK(!"OPC connect failed");
+        server.stop();
+        return;
+    }
+
+    std::vector<RGB> frame;
+    const std::vector<uint8_t> msg = opcMessage(2, 0, { 10, 11, 12, 20, 21, 22 });
+    sendAll(fd, msg.data(), 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    sendAll(fd, msg.data() + 2, 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK_EQ(target.frames(), 0);                      // not shown torn
+    sendAll(fd, msg.data() + 7, msg.size() - 7);
+    CHECK(waitFrames(target, 1, frame));
+    CHECK_EQ(frame[0].r, 0);
+    CHECK_EQ(frame[2].r, 10);
+    CHECK_EQ(frame[3].b, 22);
+
+    // longer than the range: the rest is read and dropped
+    const std::vector<uint8_t> longer = opcMessage(1, 0, { 1, 2, 3, 4, 5, 6, 7, 8, 9 });
+    const std::vector<uint8_t> other = opcMessage(1, 0xFF, { 99, 99, 99 });   // system exclusive
+    const std::vector<uint8_t> unmapped = opcMessage(7, 0, { 99, 99, 99 });
+    sendAll(fd, other.data(), other.size());
+    sendAll(fd, unmapped.data(), unmapped.size());
+    sendAll(fd, longer.data(), longer.size());
+    CHECK(waitFrames(target, 2, frame));
+    CHECK_EQ(frame[0].r, 1);
+    CHECK_EQ(frame[1].b, 6);
+    CHECK_EQ(frame[2].r, 10);                          // channel 2 untouched
+
+    close(fd);
+    server.stop();
+    const OpcServer::Stats s = server.stats();
+    CHECK_EQ(s.messages, 2u);
+    CHECK_EQ(s.skipped, 2u);
+    CHECK_EQ(s.clients, 1u);
+}
+
+// -----------------------------
+// IPC
+// -----------------------------
+// stop() returns with a client still connected and idle in read(); the
+// client sees the close and no new connection is accepted
+static void testIpcStop() {
+    auto sink = std::make_unique<CountingSink>();
+    CountingSink* cap = sink.get();
+    LEDDriver driver(std::move(sink), 4);
+    IpcServer server(driver, IPC_TEST_PORT);
+    if (!server.start()) {
+        CHECK(!"IPC server did not start");
+        return;
+    }
+    const int idle = connectLocal(IPC_TEST_PORT);
+    const int fd = connectLocal(IPC_TEST_PORT);
+    CHECK(idle >= 0 && fd >= 0);
+    const std::string cmd = "COLOR 200 0 0\n";
+    sendAll(fd, reinterpret_cast<const uint8_t*>(cmd.data()), cmd.size());
+    for (int i = 0; i < 100 && cap->writes == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(cap->writes > 0);
+    close(fd);                                  // one client gone, one still open
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    server.stop();
+    char c;
+    CHECK_EQ(read(idle, &c, 1), 0);
+    close(idle);
+    CHECK_EQ(connectLocal(IPC_TEST_PORT), -1);
+
+    // restartable on the same port
+    CHECK(server.start());
+    server.stop();
+}
+
+// each server keeps its own COLOR / PIX frame, sized for its input
+static void testIpcFramePerServer() {
+    CaptureTarget small(4), large(8);
+    SourceManager smallSources(small), largeSources(large);
+    SourceManager::Input& smallInput = smallSources.add("ipc", SourcePolicy{});
+    SourceManager::Input& largeInput = largeSources.add("ipc", SourcePolicy{});
+    smallSources.start();
+    largeSources.start();
+    auto sink = std::make_unique<CountingSink>();
+    LEDDriver driver(std::move(sink), 4);
+    IpcServer a(driver, IPC_TEST_PORT + 1, &smallInput), b(driver, IPC_TEST_PORT + 2, &largeInput);
+    CHECK(a.start() && b.start());
+
+    auto send = [](int port, const std::string& cmd) {
+        const int fd = connectLocal(port);
+        CHECK(fd >= 0);
+        if (fd >= 0) {
+            sendAll(fd, reinterpret_cast<const uint8_t*>(cmd.data()), cmd.size());
+            close(fd);
+        }
+    };
+    std::vector<RGB> out;
+    send(IPC_TEST_PORT + 1, "PIX 1 10 0 0\n");
+    CHECK(waitFrames(small, 1, out));
+    CHECK_EQ(out.size(), 4u);
+    send(IPC_TEST_PORT + 2, "PIX 6 20 0 0\n");
+    CHECK(waitFrames(large, 1, out));
+    CHECK_EQ(out.size(), 8u);
+    if (out.size() == 8u) {
+        CHECK_EQ(out[6].r, 20);
+        CHECK_EQ(out[1].r, 0);                  // not the other server's pixel
+    }
+    a.stop();
+    b.stop();
+    smallSources.stop();
+    largeSources.stop();
+}
+
+int main() {
+    testE131RoundTrip();
+    testE131Malformed();
+    testArtNetRoundTrip();
+    testArtNetMalformed();
+    testSequence();
+    testDmxAssembly();
+    testDdpOffsets();
+    testOpcMapping();
+    testOpcFraming();
+    testIpcStop();
+    testIpcFramePerServer();
+    return testResult("test_protocols");
+}
@@ -0,0 +1,115 @@
+// cpp/tests/test_queues.cpp
+// SpscQueue across two threads, DelayLine timing and overflow
+#include "delay_line.h"
+#include "spsc_queue.h"
+#include "test_util.h"
+
+#include <thread>
+#include <vector>
+
+static void testSpscSingleThread() {
+    SpscQueue<int, 4> q;
+    int v = 0;
+    CHECK(!q.tryPop(v));
+    for (int i = 0; i < 4; ++i) CHECK(q.tryPush(i));
+    CHECK(!q.tryPush(99));                       // full
+    CHECK(q.tryPop(v));
+    CHECK_EQ(v, 0);
+    CHECK(q.tryPush(4));                         // wraps
+    for (int i = 1; i <= 4; ++i) {
+        CHECK(q.tryPop(v));
+        CHECK_EQ(v, i);
+    }
+    CHECK(!q.tryPop(v));
+}
+
+// every value arrives once and in order
+static void testSpscTwoThreads() {
+    constexpr int COUNT = 1000000;
+    SpscQueue<int, 8> q;
+    std::thread producer([&] {
+        for (int i = 0; i < COUNT; ++i) {
+            while (!q.tryPush(i)) std::this_thread::yield();
+        }
+    });
+    int expected = 0;
+    int outOfOrder = 0;
+    while (expected < COUNT) {
+        int v;
+        if (!q.tryPop(v)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (v != expected) ++outOfOrder;
+        expected = v + 1;
+    }
+    producer.join();
+    CHECK_EQ(outOfOrder, 0);
+}
+
+static constexpr uint64_t MS = 1000000;
+
+static std::vector<RGB> frameOf(uint8_t r) {
+    return std::vector<RGB>(3, RGB(r, 0, 0));
+}
+
+// frames come out delay after their timestamp, the newest due one wins
+static void testDelayLine() {
+    DelayLine line(3);
+    line.setDelayMs(100);
+    for (int k = 0; k < 5; ++k) line.push(frameOf(static_cast<uint8_t>(k)), (10 + k * 10) * MS, k + 1);
+
+    uint64_t ts = 0, media = 0;
+    CHECK(line.due(109 * MS, ts, media) == nullptr);
+    const std::vector<RGB>* f = line.due(110 * MS, ts, media);
+    CHECK(f != nullptr);
+    if (f) CHECK_EQ((*f)[2].r, 0);
+    CHECK_EQ(ts, 10 * MS);
+    CHECK_EQ(media, 1u);
+    CHECK(line.due(110 * MS, ts, media) == nullptr);     // emitted once
+
+    // late by two frames: the older due ones are skipped
+    f = line.due(140 * MS, ts, media);
+    CHECK(f != nullptr);
+    if (f) CHECK_EQ((*f)[0].r, 3);
+    CHECK_EQ(line.dropped(), 2u);
+    CHECK(!line.empty());
+
+    // a shorter delay releases the rest at once
+    line.setDelayMs(0);
+    f = line.due(50 * MS, ts, media);
+    CHECK(f != nullptr);
+    if (f) CHECK_EQ((*f)[0].r, 4);
+    CHECK(line.empty());
+
+    line.setDelayMs(5000);
+    CHECK_EQ(line.delayMs(), DelayLine::MAX_DELAY_MS);
+    line.setDelayMs(-1);
+    CHECK_EQ(line.delayMs(), 0);
+}
+
+// a full ring overwrites the oldest frames, in order
+static void testDelayLineOverflow() {
+    DelayLine line(1);
+    line.setDelayMs(DelayLine::MAX_DELAY_MS);
+    const size_t extra = 10;
+    for (size_t k = 0; k < DelayLine::CAPACITY + extra; ++k) {
+        line.push(std::vector<RGB>(1, RGB(static_cast<uint8_t>(k), 0, 0)), k * MS);
+    }
+    CHECK_EQ(line.dropped(), extra);
+
+    uint64_t ts = 0, media = 0;
+    const std::vector<RGB>* f = line.due(extra * MS + DelayLine::MAX_DELAY_MS * MS, ts, media);
+    CHECK(f != nullptr);
+    if (f) CHECK_EQ((*f)[0].r, static_cast<uint8_t>(extra));
+    CHECK_EQ(ts, extra * MS);
+    CHECK_EQ(line.dropped(), extra);
+}
+
+int main() {
+    testSpscSingleThread();
+    testSpscTwoThreads();
+    testDelayLine();
+    testDelayLineOverflow();
+    return testResult("test_queues");
+}
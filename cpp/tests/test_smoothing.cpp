@@ -0,0 +1,159 @@
+// cpp/tests/test_smoothing.cpp
+// LEDDriver smoothing: adaptive response (slow / fast attack / cut), step
+// response at several rates paced by frame timestamps; replay media time
+#include "led_driver.h"
+#include "replay_source.h"
+#include "test_util.h"
+
+#include <unistd.h>
+
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+static constexpr uint64_t SEC = 1000000000ull;
+
+// keeps the last byte of the last frame the driver wrote
+class LastByteSink : public OutputSink
+{
+public:
+    bool write(const uint8_t* data, size_t size) override {
+        if (size) last = data[size - 1];
+        return true;
+    }
+
+    uint8_t last = 0;
+};
+
+static void testClassify() {
+    AdaptiveSmoothing params;                      // 12 / 64
+    CHECK(classifyChange(0.0f, params) == SmoothingResponse::Slow);
+    CHECK(classifyChange(11.9f, params) == SmoothingResponse::Slow);
+    CHECK(classifyChange(12.5f, params) == SmoothingResponse::Fast);
+    CHECK(classifyChange(63.0f, params) == SmoothingResponse::Fast);
+    CHECK(classifyChange(64.5f, params) == SmoothingResponse::Snap);
+
+    params.cutThreshold = 0.0f;                    // no cuts: large changes attack fast
+    CHECK(classifyChange(200.0f, params) == SmoothingResponse::Fast);
+    params.attackThreshold = 0.0f;
+    CHECK(classifyChange(200.0f, params) == SmoothingResponse::Slow);
+}
+
+// from black, one frame 10 ms later: a mean difference between the
+// thresholds follows smoothingFastMs_, one above cutThreshold snaps
+static void testAdaptiveResponse() {
+    const uint64_t t0 = 5 * SEC, step = 10000000;
+    for (int level : { 8, 40, 200 }) {
+        auto sink = std::make_unique<LastByteSink>();
+        LastByteSink* cap = sink.get();
+        LEDDriver driver(std::move(sink), 4);
+        LEDDriver::OutputConfig oc;
+        oc.gamma = 1.0f;
+        CHECK(driver.setOutputConfig(oc));
+        driver.setSmoothingTime(1000.0f);
+        driver.setAdaptiveSmoothing(10.0f, AdaptiveSmoothing{});   // 12 / 64
+        driver.submitFrame(std::vector<RGB>(4, RGB(0, 0, 0)), t0);
+        driver.submitFrame(std::vector<RGB>(4, RGB(level, level, level)), t0 + step);
+
+        const double slow = level * (1.0 - std::exp(-10.0 / 1000.0));
+        const double fast = level * (1.0 - std::exp(-10.0 / 10.0));
+        if (level == 8) CHECK_NEAR(cap->last, slow, 1.0);
+        if (level == 40) CHECK_NEAR(cap->last, fast, 1.0);
+        if (level == 200) CHECK_EQ(cap->last, 200);
+    }
+}
+
+// black, then a step to 200 held for 200 ms at fps; returns the output
+static int stepResponse(int fps, float tauMs) {
+    auto sink = std::make_unique<LastByteSink>();
+    LastByteSink* cap = sink.get();
+    LEDDriver driver(std::move(sink), 4);
+    LEDDriver::OutputConfig oc;
+    oc.gamma = 1.0f;
+    CHECK(driver.setOutputConfig(oc));
+    driver.setSmoothingTime(tauMs);
+    AdaptiveSmoothing plain;
+    plain.attackThreshold = 0.0f;                  // always the slow time constant
+    plain.cutThreshold = 0.0f;
+    driver.setAdaptiveSmoothing(tauMs, plain);
+
+    const uint64_t t0 = 5 * SEC;
+    driver.submitFrame(std::vector<RGB>(4, RGB(0, 0, 0)), t0);
+    const int frames = fps / 5;
+    for (int k = 1; k <= frames; ++k) {
+        driver.submitFrame(std::vector<RGB>(4, RGB(200, 200, 200)), t0 + k * SEC / fps);
+    }
+    return cap->last;
+}
+
+// the frame timestamps pace the filter, not the (here instant) call rate
+static void testStepResponse() {
+    const float tau = 57.9f;
+    const double expect = 200.0 * (1.0 - std::exp(-200.0 / tau));   // 193.7
+    const int ref = stepResponse(60, tau);
+    CHECK_NEAR(ref, expect, 1.0);
+    for (int fps : { 30, 120, 240 }) CHECK_NEAR(stepResponse(fps, tau), ref, 1.0);
+
+    // the same frames submitted again give the same output
+    CHECK_EQ(stepResponse(240, tau), stepResponse(240, tau));
+}
+
+// a gap counts as MAX_SMOOTHING_STEP_NS, a timestamp going backwards as one
+// reference frame; neither jumps straight to the target
+static void testGaps() {
+    auto sink = std::make_unique<LastByteSink>();
+    LastByteSink* cap = sink.get();
+    LEDDriver driver(std::move(sink), 1);
+    LEDDriver::OutputConfig oc;
+    oc.gamma = 1.0f;
+    CHECK(driver.setOutputConfig(oc));
+    AdaptiveSmoothing plain;
+    plain.attackThreshold = 0.0f;
+    plain.cutThreshold = 0.0f;
+    driver.setSmoothingTime(100.0f);
+    driver.setAdaptiveSmoothing(100.0f, plain);
+
+    driver.submitFrame({ RGB(0, 0, 0) }, 10 * SEC);
+    driver.submitFrame({ RGB(200, 200, 200) }, 20 * SEC);
+    CHECK_NEAR(cap->last, 200.0 * (1.0 - std::exp(-1.0)), 1.0);   // 100 ms of 10 s
+
+    driver.setSmoothingTime(0.0f);
+    driver.submitFrame({ RGB(0, 0, 0) }, 21 * SEC);
+    driver.setSmoothingTime(100.0f);
+    driver.submitFrame({ RGB(200, 200, 200) }, 1 * SEC);
+    CHECK_NEAR(cap->last, 200.0 * (1.0 - std::exp(-1000.0 / SMOOTHING_REFERENCE_HZ / 100.0)), 1.0);
+}
+
+// unpaced replays step media time by the nominal rate, across loops
+static void testReplayMediaTime() {
+    char path[] = "/tmp/test_smoothing_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    std::ofstream(path, std::ios::binary) << std::string(3 * 2 * 2 * 3, '\x40');   // 3 frames of 2x2
+
+    ReplaySource::Options options;
+    options.format = ReplaySource::Format::RGB24;
+    options.width = 2;
+    options.height = 2;
+    options.fps = 0.0;
+    options.loop = true;
+    ReplaySource source(path, options);
+    const uint64_t step = (SEC + 30) / 60;
+    Frame frame;
+    for (uint64_t n = 0; n < 7; ++n) {
+        CHECK(source.capture(frame));
+        CHECK_EQ(frame.mediaNs, (n + 1) * step);
+        CHECK(frame.timestampNs != 0);
+    }
+    unlink(path);
+}
+
+int main() {
+    testClassify();
+    testAdaptiveResponse();
+    testStepResponse();
+    testGaps();
+    testReplayMediaTime();
+    return testResult("test_smoothing");
+}
@@ -0,0 +1,107 @@
+// cpp/tests/test_sources.cpp
+// SourceManager: priority, timeout hand-over, release, per-input counters
+#include "source_manager.h"
+#include "test_util.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// red of LED 0 in the last composite, -1 before the first
+static int red(CaptureTarget& target) {
+    const std::vector<RGB> last = target.last();
+    return last.empty() ? -1 : last[0].r;
+}
+
+static bool waitRed(CaptureTarget& target, uint8_t r) {
+    return target.waitUntil([&] { return red(target) == r; });
+}
+
+static constexpr int LEDS = 4;
+
+static std::vector<RGB> solid(uint8_t r) {
+    return std::vector<RGB>(LEDS, RGB(r, 0, 0));
+}
+
+static SourceManager::SourceStats statsOf(const SourceManager& m, const std::string& name) {
+    for (const SourceManager::SourceStats& s : m.stats()) {
+        if (s.name == name) return s;
+    }
+    return SourceManager::SourceStats{};
+}
+
+static SourcePolicy policy(int priority, int timeoutMs) {
+    SourcePolicy p;
+    p.priority = priority;
+    p.timeoutMs = timeoutMs;
+    return p;
+}
+
+// the higher priority wins while it sends; on its timeout the lower one
+// takes over with the frame it sent meanwhile, release() hands back at once
+static void testPriorityHandover() {
+    CaptureTarget target(LEDS);
+    SourceManager manager(target);
+    SourceManager::Input& low = manager.add("low", policy(100, 0));
+    SourceManager::Input& high = manager.add("high", policy(200, 100));
+    CHECK(manager.start());
+
+    low.submitFrame(solid(10));
+    CHECK(waitRed(target, 10));
+    high.submitFrame(solid(20));
+    CHECK(waitRed(target, 20));
+    CHECK(statsOf(manager, "high").active);
+
+    // hidden below the winner: not shown
+    low.submitFrame(solid(11));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    CHECK_EQ(red(target), 20);
+
+    // high stops sending: expires after 100 ms, low's latest frame shows
+    CHECK(waitRed(target, 11));
+    CHECK_EQ(statsOf(manager, "high").expired, 1u);
+    CHECK(!statsOf(manager, "high").live);
+    CHECK(statsOf(manager, "low").active);
+
+    // back, then released: no timeout needed
+    high.submitFrame(solid(21));
+    CHECK(waitRed(target, 21));
+    high.release();
+    CHECK(waitRed(target, 11));
+    CHECK_EQ(statsOf(manager, "high").expired, 1u);       // a release is not an expiry
+    CHECK_EQ(statsOf(manager, "low").expired, 0u);
+
+    manager.stop();
+    const SourceManager::SourceStats h = statsOf(manager, "high");
+    CHECK_EQ(h.submitted, 2u);
+    CHECK_EQ(h.shown, 2u);
+    CHECK_EQ(h.superseded, 0u);
+}
+
+// frames overwritten before the manager read them count as superseded;
+// only the newest is shown
+static void testSuperseded() {
+    CaptureTarget target(LEDS);
+    SourceManager manager(target);
+    SourceManager::Input& in = manager.add("in", policy(100, 0));
+    in.submitFrame(solid(1));
+    in.submitFrame(solid(2));
+    in.submitFrame(solid(3));
+    in.submitFrame(std::vector<RGB>(LEDS + 1));           // wrong size, ignored
+    CHECK(manager.start());
+    CHECK(waitRed(target, 3));
+    manager.stop();
+
+    const SourceManager::SourceStats s = statsOf(manager, "in");
+    CHECK_EQ(s.submitted, 3u);
+    CHECK_EQ(s.superseded, 2u);
+    CHECK_EQ(s.shown, 1u);
+    CHECK_EQ(target.frames(), 1);
+}
+
+int main() {
+    testPriorityHandover();
+    testSuperseded();
+    return testResult("test_sources");
+}
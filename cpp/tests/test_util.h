@@ -0,0 +1,118 @@
+// cpp/tests/test_util.h
+#pragma once
+
+#include "frame_target.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ----------------------------------------------------------
+// Test helpers – minimale Checks ohne Framework
+// ----------------------------------------------------------
+// Each test binary runs its cases from main() and returns testResult():
+// 0 if every check passed, 1 otherwise (ctest reports the binary). A failed
+// check prints file:line and keeps going, so one run shows all failures.
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+// bytes print as numbers, not characters
+template <class T>
+const T& printable(const T& v) { return v; }
+inline int printable(uint8_t v) { return v; }
+inline int printable(int8_t v) { return v; }
+
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed\n";  \
+            ++testFailures();                                                           \
+        }                                                                               \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                  \
+    do {                                                                                \
+        const auto va_ = (a);                                                           \
+        const auto vb_ = (b);                                                           \
+        if (!(va_ == vb_)) {                                                            \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " #a " == " #b " failed ("   \
+                      << printable(va_) << " vs " << printable(vb_) << ")\n";           \
+            ++testFailures();                                                           \
+        }                                                                               \
+    } while (0)
+
+#define CHECK_NEAR(a, b, eps)                                                           \
+    do {                                                                                \
+        const double va_ = (a);                                                         \
+        const double vb_ = (b);                                                         \
+        if (!(std::fabs(va_ - vb_) <= (eps))) {                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " #a " ~ " #b " failed ("    \
+                      << va_ << " vs " << vb_ << ")\n";                                 \
+            ++testFailures();                                                           \
+        }                                                                               \
+    } while (0)
+
+// Keeps the last frame a producer submitted and counts frames and releases;
+// the producer's thread writes, the test reads through the accessors.
+class CaptureTarget : public FrameTarget
+{
+public:
+    explicit CaptureTarget(int leds) : _leds(leds) {}
+
+    void submitFrame(const std::vector<RGB>& colors, uint64_t) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _last = colors;
+        ++_frames;
+    }
+    int numLeds() const override { return _leds; }
+    void release() override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_releases;
+    }
+
+    // empty until the first frame
+    std::vector<RGB> last() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _last;
+    }
+    int frames() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _frames;
+    }
+    int releases() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _releases;
+    }
+
+    // polls pred() every 10 ms for up to two seconds
+    template <class Pred>
+    bool waitUntil(Pred pred) {
+        for (int i = 0; i < 200; ++i) {
+            if (pred()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return pred();
+    }
+
+private:
+    int _leds;
+    std::mutex _mutex;
+    std::vector<RGB> _last;
+    int _frames = 0;
+    int _releases = 0;
+};
+
+inline int testResult(const char* name) {
+    if (testFailures() > 0) {
+        std::cerr << name << ": " << testFailures() << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << name << ": ok\n";
+    return 0;
+}
@@ -0,0 +1,179 @@
+// cpp/tools/dmx_send.cpp
+// Packet generator for the E1.31 / Art-Net / DDP receivers: sends a moving
+// rainbow (or a solid color) as one DMX universe per 170 LEDs, all
+// universes of a frame (plus the sync packet) in one sendmmsg. --ddp sends
+// 480 LEDs per packet instead, PUSH on the last one.
+//   dmx_send [--artnet | --ddp] [--host IP] [--port N] [--leds N] [--universe U]
+//            [--fps N] [--frames N] [--sync U] [--solid RRGGBB]
+#include "dmx_protocol.h"
+#include "ddp_receiver.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const uint8_t CID[16] = { 0x41, 0x6d, 0x62, 0x69, 0x6c, 0x69, 0x67, 0x68,
+                                 0x74, 0x2d, 0x64, 0x6d, 0x78, 0x73, 0x6e, 0x64 };
+
+static constexpr int DDP_LEDS_PER_PACKET = 480;    // 1440 byte payload
+static constexpr size_t DDP_HEADER = 10;
+
+static size_t buildDdp(uint8_t* out, uint8_t sequence, bool push, uint32_t offset, const uint8_t* data,
+                       uint16_t length) {
+    out[0] = static_cast<uint8_t>(0x40 | (push ? 0x01 : 0x00));   // version 1
+    out[1] = sequence;
+    out[2] = 0x0B;                                                 // RGB, 8 bit
+    out[3] = 0x01;                                                 // default output
+    out[4] = static_cast<uint8_t>(offset >> 24);
+    out[5] = static_cast<uint8_t>(offset >> 16);
+    out[6] = static_cast<uint8_t>(offset >> 8);
+    out[7] = static_cast<uint8_t>(offset);
+    out[8] = static_cast<uint8_t>(length >> 8);
+    out[9] = static_cast<uint8_t>(length);
+    std::memcpy(out + DDP_HEADER, data, length);
+    return DDP_HEADER + length;
+}
+
+static void hue(int h, uint8_t* rgb) {
+    h &= 0x5FF;                                   // 6 * 256 steps
+    const uint8_t up = static_cast<uint8_t>(h & 0xFF), down = static_cast<uint8_t>(255 - up);
+    const uint8_t table[6][3] = { { 255, up, 0 }, { down, 255, 0 }, { 0, 255, up },
+                                  { 0, down, 255 }, { up, 0, 255 }, { 255, 0, down } };
+    std::memcpy(rgb, table[h >> 8], 3);
+}
+
+int main(int argc, char** argv) {
+    bool artnet = false, ddp = false;
+    std::string host = "127.0.0.1";
+    int port = 0, leds = 60, universe = -1, syncAddress = 0;
+    double fps = 40.0;
+    long frames = -1;
+    long solid = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool more = i + 1 < argc;
+        if (arg == "--artnet") artnet = true;
+        else if (arg == "--ddp") ddp = true;
+        else if (arg == "--host" && more) host = argv[++i];
+        else if (arg == "--port" && more) port = std::atoi(argv[++i]);
+        else if (arg == "--leds" && more) leds = std::atoi(argv[++i]);
+        else if (arg == "--universe" && more) universe = std::atoi(argv[++i]);
+        else if (arg == "--fps" && more) fps = std::atof(argv[++i]);
+        else if (arg == "--frames" && more) frames = std::atol(argv[++i]);
+        else if (arg == "--sync" && more) syncAddress = std::atoi(argv[++i]);
+        else if (arg == "--solid" && more) solid = std::strtol(argv[++i], nullptr, 16);
+        else {
+            std::fprintf(stderr,
+                         "usage: %s [--artnet | --ddp] [--host IP] [--port N] [--leds N] [--universe U]\n"
+                         "          [--fps N] [--frames N] [--sync U] [--solid RRGGBB]\n"
+                         "  --sync U: E1.31 sync universe U (Art-Net: any U > 0 sends ArtSync)\n",
+                         argv[0]);
+            return 2;
+        }
+    }
+    if (port <= 0) port = ddp ? DDP_PORT : artnet ? ARTNET_PORT : E131_PORT;
+    if (universe < 0) universe = artnet ? 0 : 1;
+    if (leds <= 0) leds = 1;
+    if (ddp) syncAddress = 0;
+    const int perPacket = ddp ? DDP_LEDS_PER_PACKET : LEDS_PER_UNIVERSE;
+    const int universes = (leds + perPacket - 1) / perPacket;
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        std::fprintf(stderr, "bad host %s\n", host.c_str());
+        return 2;
+    }
+
+    // one packet buffer per universe + one for sync, sent in one go
+    const int count = universes + (syncAddress > 0 ? 1 : 0);
+    const size_t packetMax = ddp ? DDP_HEADER + DDP_LEDS_PER_PACKET * 3 : DMX_PACKET_MAX;
+    std::vector<uint8_t> packets(size_t(count) * packetMax);
+    std::vector<iovec> iov(count);
+    std::vector<mmsghdr> msgs(count);
+    std::memset(msgs.data(), 0, msgs.size() * sizeof(mmsghdr));
+    for (int i = 0; i < count; ++i) {
+        iov[i].iov_base = packets.data() + size_t(i) * packetMax;
+        msgs[i].msg_hdr.msg_name = &addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(addr);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    std::vector<uint8_t> rgb(size_t(leds) * 3);
+    const auto period = std::chrono::duration<double>(fps > 0.0 ? 1.0 / fps : 0.0);
+    auto next = std::chrono::steady_clock::now();
+    uint8_t seq = 0;
+    long sent = 0;
+    for (long f = 0; frames < 0 || f < frames; ++f) {
+        for (int i = 0; i < leds; ++i) {
+            if (solid >= 0) {
+                rgb[i * 3] = uint8_t(solid >> 16);
+                rgb[i * 3 + 1] = uint8_t(solid >> 8);
+                rgb[i * 3 + 2] = uint8_t(solid);
+            } else {
+                hue(int(f * 16 + i * 1536 / leds), &rgb[i * 3]);
+            }
+        }
+
+        ++seq;
+        if (artnet && seq == 0) seq = 1;                  // 0 = sequencing off
+        for (int u = 0; u < universes; ++u) {
+            const int first = u * perPacket;
+            const int n = std::min(perPacket, leds - first);
+            uint8_t* out = static_cast<uint8_t*>(iov[u].iov_base);
+            if (ddp) {
+                const uint8_t ddpSeq = static_cast<uint8_t>((f * universes + u) % 15 + 1);
+                iov[u].iov_len = buildDdp(out, ddpSeq, u == universes - 1, uint32_t(first * 3), &rgb[first * 3],
+                                          uint16_t(n * 3));
+                continue;
+            }
+            iov[u].iov_len = artnet
+                ? buildArtDmx(out, uint16_t(universe + u), seq, &rgb[first * 3], uint16_t(n * 3))
+                : buildE131Data(out, CID, uint16_t(universe + u), seq, uint16_t(syncAddress), &rgb[first * 3],
+                                uint16_t(n * 3));
+        }
+        if (syncAddress > 0) {
+            uint8_t* out = static_cast<uint8_t*>(iov[universes].iov_base);
+            iov[universes].iov_len = artnet ? buildArtSync(out) : buildE131Sync(out, CID, uint16_t(syncAddress), seq);
+        }
+
+        for (int done = 0; done < count;) {
+            const int n = sendmmsg(fd, msgs.data() + done, count - done, 0);
+            if (n < 0) {
+                perror("sendmmsg");
+                close(fd);
+                return 1;
+            }
+            done += n;
+        }
+        sent += count;
+
+        if (fps > 0.0) {
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    std::printf("sent %ld packets (%d %s/frame%s) to %s:%d\n", sent, universes, ddp ? "packets" : "universes",
+                syncAddress > 0 ? " + sync" : "", host.c_str(), port);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,86 @@
+// cpp/tools/trace_diff.cpp
+// Compares two LED output traces (see trace.h) frame by frame, or prints
+// the statistics of one. Timestamps are ignored, only the bytes count.
+//   trace_diff A.trace B.trace   exit 0 = bit-identical, 1 = different
+//   trace_diff --stats A.trace
+#include "trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static constexpr int MAX_REPORTED = 10;   // differing frames listed in detail
+
+static int printStats(const char* path) {
+    TraceReader r;
+    if (!r.open(path)) return 2;
+    uint64_t frames = 0, changed = 0, first = 0, last = 0;
+    while (r.next()) {
+        if (frames == 0) first = r.timestampNs();
+        last = r.timestampNs();
+        changed += r.changedBytes();
+        ++frames;
+    }
+    const double secs = (last - first) / 1e9;
+    std::printf("%s: %llu frames of %zu bytes, %.2f s", path, static_cast<unsigned long long>(frames),
+                r.frameBytes(), secs);
+    if (secs > 0.0) std::printf(" (%.1f fps)", (frames - 1) / secs);
+    std::printf("\n  changed bytes/frame %.1f (%.1f%%), file %zu bytes (%.1f%% of raw)\n",
+                frames ? double(changed) / frames : 0.0,
+                frames && r.frameBytes() ? 100.0 * changed / frames / r.frameBytes() : 0.0, r.fileBytes(),
+                frames && r.frameBytes() ? 100.0 * r.fileBytes() / (double(frames) * r.frameBytes()) : 0.0);
+    return 0;
+}
+
+static int diff(const char* pathA, const char* pathB) {
+    TraceReader a, b;
+    if (!a.open(pathA) || !b.open(pathB)) return 2;
+    if (a.frameBytes() != b.frameBytes()) {
+        std::printf("frame size differs: %zu vs %zu bytes\n", a.frameBytes(), b.frameBytes());
+        return 1;
+    }
+
+    uint64_t frame = 0, differing = 0, bytes = 0;
+    bool moreA, moreB;
+    while ((moreA = a.next()) & (moreB = b.next())) {
+        const uint8_t* fa = a.frame().data();
+        const uint8_t* fb = b.frame().data();
+        if (std::memcmp(fa, fb, a.frameBytes()) != 0) {
+            size_t n = 0, firstByte = 0, maxDelta = 0;
+            for (size_t i = 0; i < a.frameBytes(); ++i) {
+                if (fa[i] == fb[i]) continue;
+                if (n++ == 0) firstByte = i;
+                const size_t d = fa[i] > fb[i] ? fa[i] - fb[i] : fb[i] - fa[i];
+                if (d > maxDelta) maxDelta = d;
+            }
+            if (differing < MAX_REPORTED) {
+                std::printf("frame %llu: %zu bytes differ, first at %zu (LED %zu), max delta %zu\n",
+                            static_cast<unsigned long long>(frame), n, firstByte, firstByte / 3, maxDelta);
+            }
+            ++differing;
+            bytes += n;
+        }
+        ++frame;
+    }
+
+    if (moreA != moreB) {
+        uint64_t extra = 1;
+        TraceReader& longer = moreA ? a : b;
+        while (longer.next()) ++extra;
+        std::printf("%s has %llu more frames\n", moreA ? pathA : pathB, static_cast<unsigned long long>(extra));
+    }
+    if (differing == 0 && moreA == moreB) {
+        std::printf("identical: %llu frames\n", static_cast<unsigned long long>(frame));
+        return 0;
+    }
+    std::printf("%llu of %llu frames differ, %llu bytes\n", static_cast<unsigned long long>(differing),
+                static_cast<unsigned long long>(frame), static_cast<unsigned long long>(bytes));
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && std::strcmp(argv[1], "--stats") == 0) return printStats(argv[2]);
+    if (argc == 3) return diff(argv[1], argv[2]);
+    std::fprintf(stderr, "usage: %s A.trace B.trace | --stats A.trace\n", argv[0]);
+    return 2;
+}